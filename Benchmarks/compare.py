@@ -0,0 +1,81 @@
+#!/usr/bin/env python3
+"""Compares two Google Benchmark JSON reports.
+
+Usage: compare.py [--threshold PERCENT] [--metric real_time|cpu_time] BASELINE CURRENT
+
+Benchmarks are matched by name. Reports with repetitions are compared by their
+median. Complexity fits (_BigO, _RMS) are skipped. The exit status is 1 when a
+benchmark got slower than the threshold (10 % by default), so the script can
+gate a build.
+"""
+
+import argparse
+import json
+import sys
+
+UNITS = {"ns": 1.0, "us": 1e3, "ms": 1e6, "s": 1e9}
+
+
+def load(path, metric):
+    """Returns {name: time in nanoseconds} of a report."""
+    with open(path, encoding="utf-8") as file:
+        report = json.load(file)
+    times = {}
+    medians = {}
+    for run in report.get("benchmarks", []):
+        if run.get("error_occurred"):
+            continue
+        name = run.get("run_name", run["name"])
+        if run.get("run_type") == "aggregate":
+            if run.get("aggregate_name") == "median":
+                medians[name] = run[metric] * UNITS[run.get("time_unit", "ns")]
+            continue
+        if name.endswith("_BigO") or name.endswith("_RMS"):
+            continue
+        times.setdefault(name, run[metric] * UNITS[run.get("time_unit", "ns")])
+    times.update(medians)
+    return times
+
+
+def format_time(nanoseconds):
+    for unit in ("s", "ms", "us"):
+        if nanoseconds >= UNITS[unit]:
+            return f"{nanoseconds / UNITS[unit]:.3f} {unit}"
+    return f"{nanoseconds:.1f} ns"
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Compare two Google Benchmark JSON reports.")
+    parser.add_argument("baseline")
+    parser.add_argument("current")
+    parser.add_argument("--threshold", type=float, default=10.0, help="slowdown in percent that fails the comparison")
+    parser.add_argument("--metric", choices=("real_time", "cpu_time"), default="cpu_time")
+    arguments = parser.parse_args()
+
+    baseline = load(arguments.baseline, arguments.metric)
+    current = load(arguments.current, arguments.metric)
+    width = max((len(name) for name in baseline.keys() | current.keys()), default=9)
+    print(f"{'Benchmark':<{width}}  {'baseline':>12}  {'current':>12}  {'change':>8}")
+    regressions = 0
+    for name in sorted(baseline.keys() & current.keys(), key=list(current).index):
+        old, new = baseline[name], current[name]
+        change = (new - old) / old * 100 if old > 0 else 0.0
+        mark = ""
+        if change > arguments.threshold:
+            mark = "  slower"
+            regressions += 1
+        elif change < -arguments.threshold:
+            mark = "  faster"
+        print(f"{name:<{width}}  {format_time(old):>12}  {format_time(new):>12}  {change:>+7.1f}%{mark}")
+    for name in sorted(current.keys() - baseline.keys()):
+        print(f"{name:<{width}}  {'-':>12}  {format_time(current[name]):>12}       new")
+    for name in sorted(baseline.keys() - current.keys()):
+        print(f"{name:<{width}}  {format_time(baseline[name]):>12}  {'-':>12}   missing")
+    if regressions:
+        print(f"\n{regressions} benchmark(s) slower than the baseline by more than {arguments.threshold:g} %")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,228 @@
+#include <benchmark/benchmark.h>
+#include <Matrix/Matrix.h>
+#include <Polyline/Polyline.h>
+#include <Buffer/Buffer.h>
+#include <Buffer/RenderTarget.h>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace MatrixNameSpace;
+using namespace PolylineNameSpace;
+using namespace BufferNameSpace;
+
+// ==================== Helper Functions ====================
+
+// A random walk that stays in view of the default camera
+Polyline<double> random_walk(size_t points, uint32_t seed = 42) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> step(-1.0, 1.0);
+    Polyline<double> polyline;
+    polyline.resize(points);
+    double x = 0, y = 0, z = 0;
+    for (size_t i = 0; i < points; ++i) {
+        x = std::clamp(x + step(generator), -30.0, 30.0);
+        y = std::clamp(y + step(generator), -30.0, 30.0);
+        z = std::clamp(z + step(generator), -30.0, 30.0);
+        polyline.add_point(x, y, z, static_cast<char>('A' + i % 26));
+    }
+    return polyline;
+}
+
+template <size_t N>
+std::unique_ptr<Matrix<double, N, N>> random_matrix(uint32_t seed) {
+    std::mt19937 generator(seed);
+    std::uniform_real_distribution<double> value(-1.0, 1.0);
+    auto matrix = std::make_unique<Matrix<double, N, N>>();
+    for (double& element : *matrix) { element = value(generator); }
+    return matrix;
+}
+
+// 10, 100, ..., 10M points
+void point_counts(benchmark::internal::Benchmark* benchmark) {
+    benchmark->RangeMultiplier(10)->Range(10, 10'000'000)->Complexity(benchmark::oN);
+}
+
+void set_points_processed(benchmark::State& state) {
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations()) * state.range(0));
+    state.SetComplexityN(state.range(0));
+}
+
+// ==================== Matrix Benchmarks ====================
+
+template <size_t N>
+void BM_MatrixMultiply(benchmark::State& state) {
+    auto a = random_matrix<N>(1);
+    auto b = random_matrix<N>(2);
+    auto result = std::make_unique<Matrix<double, N, N>>();
+    for (auto _ : state) {
+        *result = *a * *b;
+        benchmark::DoNotOptimize(result->begin());
+        benchmark::ClobberMemory();
+    }
+    state.SetItemsProcessed(static_cast<int64_t>(state.iterations() * N * N * N));
+}
+BENCHMARK(BM_MatrixMultiply<3>);
+BENCHMARK(BM_MatrixMultiply<16>);
+BENCHMARK(BM_MatrixMultiply<64>);
+BENCHMARK(BM_MatrixMultiply<128>);
+
+// The 1x3 by 3x3 product every rotated point goes through
+void BM_MatrixMultiplyPoint(benchmark::State& state) {
+    Matrix<double, 1, 3> point = {1.0, 2.0, 3.0};
+    auto rotation = random_matrix<3>(3);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(point);
+        Matrix<double, 1, 3> result = point * *rotation;
+        benchmark::DoNotOptimize(result);
+    }
+}
+BENCHMARK(BM_MatrixMultiplyPoint);
+
+template <size_t N>
+void BM_MatrixTransposed(benchmark::State& state) {
+    auto matrix = random_matrix<N>(4);
+    auto result = std::make_unique<Matrix<double, N, N>>();
+    for (auto _ : state) {
+        *result = matrix->transposed();
+        benchmark::DoNotOptimize(result->begin());
+        benchmark::ClobberMemory();
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * N * N * sizeof(double)));
+}
+BENCHMARK(BM_MatrixTransposed<3>);
+BENCHMARK(BM_MatrixTransposed<16>);
+BENCHMARK(BM_MatrixTransposed<64>);
+BENCHMARK(BM_MatrixTransposed<128>);
+
+// Row-major traversal is the reference for the column iterator
+template <size_t N>
+void BM_MatrixRowTraversal(benchmark::State& state) {
+    auto matrix = random_matrix<N>(5);
+    for (auto _ : state) {
+        const auto& constant = *matrix;
+        benchmark::DoNotOptimize(std::accumulate(constant.begin(), constant.end(), 0.0));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * N * N * sizeof(double)));
+}
+BENCHMARK(BM_MatrixRowTraversal<16>);
+BENCHMARK(BM_MatrixRowTraversal<128>);
+
+template <size_t N>
+void BM_MatrixColumnTraversal(benchmark::State& state) {
+    auto matrix = random_matrix<N>(5);
+    for (auto _ : state) {
+        const auto& constant = *matrix;
+        benchmark::DoNotOptimize(std::accumulate(constant.col_begin(), constant.col_end(), 0.0));
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * N * N * sizeof(double)));
+}
+BENCHMARK(BM_MatrixColumnTraversal<16>);
+BENCHMARK(BM_MatrixColumnTraversal<128>);
+
+// ==================== Polyline Benchmarks ====================
+
+void BM_PolylineRotateFromOrigin(benchmark::State& state) {
+    Polyline<double> polyline = random_walk(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        polyline.rotate_from_origin(1.0, 2.0, 3.0);
+        benchmark::DoNotOptimize(polyline[0]);
+    }
+    set_points_processed(state);
+}
+BENCHMARK(BM_PolylineRotateFromOrigin)->Apply(point_counts);
+
+void BM_PolylineRotateByVector(benchmark::State& state) {
+    Polyline<double> polyline = random_walk(static_cast<size_t>(state.range(0)));
+    Point<double> start{1, 2, 3}, finish{1, 1, 1};
+    for (auto _ : state) {
+        polyline.rotate_by_vector(start, finish, 5.0);
+        benchmark::DoNotOptimize(polyline[0]);
+    }
+    set_points_processed(state);
+}
+BENCHMARK(BM_PolylineRotateByVector)->Apply(point_counts);
+
+void BM_PolylineShift(benchmark::State& state) {
+    Polyline<double> polyline = random_walk(static_cast<size_t>(state.range(0)));
+    double direction = 1.0;
+    for (auto _ : state) {
+        polyline.shift(direction, -direction, 0.5 * direction);
+        direction = -direction;
+        benchmark::DoNotOptimize(polyline[0]);
+    }
+    set_points_processed(state);
+}
+BENCHMARK(BM_PolylineShift)->Apply(point_counts);
+
+void BM_PolylineLength(benchmark::State& state) {
+    const Polyline<double> polyline = random_walk(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(polyline.length());
+    }
+    set_points_processed(state);
+}
+BENCHMARK(BM_PolylineLength)->Apply(point_counts);
+
+// Every removed point is added back, so the polyline keeps its size
+void BM_PolylineRemoveDistant(benchmark::State& state) {
+    Polyline<double> polyline = random_walk(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        polyline.remove_distant();
+        polyline.add_point(0, 0, 0, 'Z');
+    }
+    set_points_processed(state);
+}
+BENCHMARK(BM_PolylineRemoveDistant)->Apply(point_counts);
+
+// ==================== Buffer Benchmarks ====================
+
+// One frame: clean the buffer and draw one polyline, in ASCII (0) or braille (1) mode
+void BM_BufferDrawPolyline(benchmark::State& state) {
+    const Polyline<double> polyline = random_walk(static_cast<size_t>(state.range(0)));
+    auto buffer = std::make_unique<Buffer<74, 313>>();
+    if (state.range(1) == 1) { buffer->set_mode(RenderMode::Braille); }
+    for (auto _ : state) {
+        buffer->clean_buffer();
+        *buffer << polyline;
+    }
+    set_points_processed(state);
+}
+BENCHMARK(BM_BufferDrawPolyline)->ArgsProduct({benchmark::CreateRange(10, 1'000'000, 10), {0, 1}})->ArgNames({"points", "braille"});
+
+// Encoding a frame full of colored lines into a reused string
+void BM_BufferEncode(benchmark::State& state) {
+    auto buffer = std::make_unique<Buffer<74, 313>>();
+    *buffer << random_walk(10'000);
+    auto format = static_cast<FrameFormat>(state.range(0));
+    std::string frame;
+    for (auto _ : state) {
+        frame.clear();
+        buffer->encode(frame, format);
+        benchmark::DoNotOptimize(frame.data());
+    }
+    state.SetBytesProcessed(static_cast<int64_t>(state.iterations() * frame.size()));
+}
+BENCHMARK(BM_BufferEncode)->Arg(static_cast<int>(FrameFormat::Ansi))->Arg(static_cast<int>(FrameFormat::Plain))->ArgName("format");
+
+// The whole frame output path: encoding plus the write system call
+void BM_BufferWriteFrame(benchmark::State& state) {
+    auto buffer = std::make_unique<Buffer<74, 313>>();
+    *buffer << random_walk(10'000);
+    int fd = ::open("/dev/null", O_WRONLY);
+    if (fd < 0) {
+        state.SkipWithError("Cannot open /dev/null");
+        return;
+    }
+    {
+        RenderTarget target(fd, FrameFormat::Ansi);
+        for (auto _ : state) {
+            target.write(*buffer);
+        }
+    }
+    ::close(fd);
+}
+BENCHMARK(BM_BufferWriteFrame);
@@ -0,0 +1,71 @@
+/**
+ * @file Braille.h
+ * @brief Unicode braille encoding helpers for sub-cell rendering
+ * @author Chesnokov Alexandr
+ * @date 2025
+ * @version 1.0
+ *
+ * Every terminal cell is treated as a 2x4 grid of dots stored in one byte. This
+ * header maps dot positions to bits and bytes to UTF-8 encoded characters of the
+ * Unicode braille block (U+2800 - U+28FF).
+ */
+
+#ifndef BRAILLE_H
+#define BRAILLE_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace BufferNameSpace {
+    constexpr size_t braille_rows = 4; ///< Dot rows in one cell
+    constexpr size_t braille_cols = 2; ///< Dot columns in one cell
+
+    /**
+     * @brief Returns the bit of a dot inside a braille cell
+     * @param row Dot row inside the cell (0 - 3, top to bottom)
+     * @param col Dot column inside the cell (0 - 1, left to right)
+     * @return uint8_t Mask with the single bit of the dot set
+     *
+     * Follows the Unicode dot numbering: dots 1-3 and 7 form the left column,
+     * dots 4-6 and 8 form the right column.
+     */
+    constexpr uint8_t braille_bit(size_t row, size_t col){
+        constexpr uint8_t bits[braille_rows][braille_cols] = {
+            {0x01, 0x08},
+            {0x02, 0x10},
+            {0x04, 0x20},
+            {0x40, 0x80}
+        };
+        return bits[row][col];
+    }
+
+    /**
+     * @brief Precomputed UTF-8 sequences of all 256 braille characters
+     *
+     * Entry m holds the three bytes of U+2800 + m.
+     */
+    constexpr std::array<std::array<char, 3>, 256> braille_utf8 = []{
+        std::array<std::array<char, 3>, 256> table{};
+        for(size_t mask = 0; mask < 256; mask++){
+            table[mask] = {
+                static_cast<char>(0xE2),
+                static_cast<char>(0xA0 | (mask >> 6)),
+                static_cast<char>(0x80 | (mask & 0x3F))
+            };
+        }
+        return table;
+    }();
+
+    /**
+     * @brief Returns the UTF-8 encoding of a braille cell
+     * @param mask Dot mask of the cell
+     * @return std::string_view View of the three bytes in braille_utf8
+     */
+    constexpr std::string_view braille_char(uint8_t mask){
+        return std::string_view(braille_utf8[mask].data(), braille_utf8[mask].size());
+    }
+}
+
+#endif
@@ -1,12 +1,13 @@
 /**
  * @file Buffer.h
- * @brief 2D character buffer for 3D polyline rendering with isometric projection
+ * @brief 2D character buffer for 3D polyline rendering with a configurable camera
  * @author Chesnokov Alexandr
  * @date 2025
  * @version 1.0
- * 
+ *
  * This header defines a Buffer class for rendering 3D polylines onto a 2D character
- * display using isometric projection. Includes support for colored terminal output.
+ * display through a Camera (isometric by default). Includes support for colored
+ * terminal output.
  */
 
 #ifndef BUFFER_H
@@ -14,16 +15,30 @@
 
 #include <Matrix/Matrix.h>
 #include <Polyline/Polyline.h>
+#include <Utils/ThreadPool.h>
+#include <Utils/Profiler.h>
+#include <Buffer/Braille.h>
+#include <Buffer/Camera.h>
+#include <Buffer/Color.h>
+#include <Buffer/Transform.h>
+#include <algorithm>
+#include <array>
 #include <concepts>
 #include <cstddef>
 #include <utility>
 #include <cmath>
+#include <cstdint>
+#include <cstring>
 #include <stdexcept>
-
-// ANSI color codes for terminal output
-#define GREEN "\033[38;2;0;255;0m"    ///< Green color code (RGB: 0,255,0)
-#define BLUE "\033[38;2;0;191;255m"   ///< Blue color code (RGB: 0,191,255)
-#define RESET "\033[0;0m"             ///< Reset color and style codes
+#include <vector>
+#include <memory>
+#include <span>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <ostream>
+#include <chrono>
+#include <unordered_map>
 
 namespace BufferNameSpace {
     using namespace MatrixNameSpace;
@@ -32,7 +47,7 @@ namespace BufferNameSpace {
     /**
      * @struct BufferPoint
      * @brief 2D point representation for buffer coordinates
-     * 
+     *
      * Used internally for converting 3D points to 2D screen coordinates
      * during the rendering process.
      */
@@ -41,33 +56,545 @@ namespace BufferNameSpace {
         double y = 0; ///< Y coordinate in buffer (horizontal position)
     };
 
+    /**
+     * @enum RenderMode
+     * @brief Way polylines are rasterized into the buffer
+     */
+    enum class RenderMode{
+        Ascii,  ///< One glyph per cell, lines drawn with '-'
+        Braille ///< 2x4 dots per cell, encoded as Unicode braille characters
+    };
+
+    /**
+     * @enum FrameFormat
+     * @brief Encoding of a frame produced by Buffer::encode
+     */
+    enum class FrameFormat{
+        Ansi,  ///< Text with ANSI color escapes, as printed to a terminal
+        Plain, ///< Text without escapes
+        Pgm,   ///< Binary grayscale bitmap (P5), one pixel per cell or per braille dot
+        Ppm    ///< Binary color bitmap (P6), one pixel per cell or per braille dot
+    };
+
+    /**
+     * @struct FrameCell
+     * @brief Visible content of one cell, as printed by the text encoder
+     */
+    struct FrameCell{
+        std::array<char, 3> text{' '}; ///< UTF-8 bytes of the printed character
+        uint8_t size = 1; ///< Number of used bytes in text
+        Color color{}; ///< Color of the character, automatic for blank cells
+
+        bool operator==(const FrameCell& other) const = default; ///< Equality operator
+
+        /**
+         * @brief Checks whether the cell prints a space
+         * @return bool True for a blank cell, which never switches colors
+         */
+        bool blank() const{
+            return size == 1 && text[0] == ' ';
+        }
+
+        /**
+         * @brief Get the printed bytes
+         * @return std::string_view View of the used part of text
+         */
+        std::string_view view() const{
+            return std::string_view(text.data(), size);
+        }
+    };
+
+    /**
+     * @struct StageTimes
+     * @brief Time spent in the rendering stages since the last reset_stage_times()
+     */
+    struct StageTimes{
+        std::chrono::nanoseconds projection{}; ///< Projection and clipping of points
+        std::chrono::nanoseconds rasterization{}; ///< Drawing of the visible segments
+    };
+
+    /**
+     * @struct Tile
+     * @brief Rectangular region of the buffer (rasterization tile, viewport, dirty rectangle)
+     *
+     * Rows are taken from [row_begin, row_end), columns from [col_begin, col_end).
+     */
+    struct Tile{
+        size_t row_begin = 0; ///< First row of the tile
+        size_t row_end = 0; ///< Row after the last row of the tile
+        size_t col_begin = 0; ///< First column of the tile
+        size_t col_end = 0; ///< Column after the last column of the tile
+    };
+
+    /**
+     * @brief Checks whether a tile covers no cells
+     * @param tile Tile to check
+     * @return bool True if the tile has no rows or no columns
+     */
+    inline bool tile_empty(const Tile& tile){
+        return tile.row_begin >= tile.row_end || tile.col_begin >= tile.col_end;
+    }
+
+    /**
+     * @brief Computes the bounding rectangle of two tiles
+     * @param a First tile
+     * @param b Second tile
+     * @return Smallest Tile covering both; empty tiles are ignored
+     */
+    inline Tile tile_union(const Tile& a, const Tile& b){
+        if(tile_empty(a)){ return b; }
+        if(tile_empty(b)){ return a; }
+        return Tile{std::min(a.row_begin, b.row_begin), std::max(a.row_end, b.row_end),
+                    std::min(a.col_begin, b.col_begin), std::max(a.col_end, b.col_end)};
+    }
+
+    /**
+     * @enum Layer
+     * @brief Layer of the buffer that drawing goes into, from bottom to top
+     *
+     * On output a cell shows the glyph of the topmost layer that has one, the union of
+     * the braille dots of all layers and the color of the topmost layer drawn into it.
+     */
+    enum class Layer : uint8_t{
+        Background, ///< Axes and polylines added with add_background, managed by the buffer
+        Static,     ///< Geometry kept over many frames
+        Dynamic,    ///< Geometry redrawn every frame (the default)
+        Overlay     ///< Labels and annotations on top of everything
+    };
+
+    constexpr size_t layer_count = 4; ///< Number of Layer values
+
+    /**
+     * @struct Viewport
+     * @brief Rectangle of the buffer showing the scene through its own camera
+     *
+     * The world origin is drawn at the middle column of the area, two thirds down
+     * for the isometric view and halfway down for the axis-aligned views.
+     */
+    struct Viewport{
+        Tile area{}; ///< Cells covered by the viewport
+        Camera camera{}; ///< Projection of the viewport
+    };
+
+    /**
+     * @brief Splits a buffer into top, front, side and isometric viewports
+     * @param height Height of the buffer in characters
+     * @param width Width of the buffer in characters
+     * @return Four viewports in reading order, separated by one empty row and column
+     *
+     * The cameras are zoomed out by half, so each view shows the same region of the
+     * scene as the whole buffer would.
+     */
+    inline std::vector<Viewport> quad_viewports(size_t height, size_t width){
+        size_t top = (height - 1) / 2, left = (width - 1) / 2;
+        std::vector<Viewport> viewports = {
+            {Tile{0, top, 0, left}, Camera(View::Top)},
+            {Tile{0, top, left + 1, width}, Camera(View::Front)},
+            {Tile{top + 1, height, 0, left}, Camera(View::Side)},
+            {Tile{top + 1, height, left + 1, width}, Camera(View::Isometric)}
+        };
+        for(Viewport& viewport : viewports){ viewport.camera.zoom(0.5); }
+        return viewports;
+    }
+
+    /**
+     * @struct Segment2D
+     * @brief Visible part of a projected segment, ready for rasterization
+     *
+     * A label of '\0' means that the endpoint was cut off by clipping and has
+     * no label to draw. ASCII rasterization tests the cells within bounds, so a
+     * clipped segment covers the same cells inside the buffer as the whole one.
+     */
+    struct Segment2D{
+        BufferPoint start{}; ///< Start of the visible part
+        BufferPoint end{}; ///< End of the visible part
+        char start_name = '\0'; ///< Label of the start point
+        char end_name = '\0'; ///< Label of the end point
+        uint8_t view = 0; ///< Viewport the segment is drawn in
+        Tile bounds{}; ///< Inclusive cell bounds of the segment before clipping to the buffer, clamped to it
+    };
+
+    /**
+     * @enum FillRule
+     * @brief Rule deciding which regions of a self-intersecting polygon are inside
+     */
+    enum class FillRule{
+        EvenOdd, ///< Inside where a ray crosses the outline an odd number of times
+        NonZero  ///< Inside where the outline winds around the point a non-zero number of times
+    };
+
+    /**
+     * @struct FillStyle
+     * @brief Appearance of a filled polygon
+     *
+     * The fill color is the current buffer color (buffer << Color before filling).
+     */
+    struct FillStyle{
+        FillRule rule = FillRule::EvenOdd; ///< Inside test for self-intersecting outlines
+        char glyph = '#'; ///< Glyph of filled cells in ASCII mode (braille mode sets all dots)
+    };
+
+    /**
+     * @struct ScanEdge
+     * @brief Non-horizontal polygon edge prepared for scanline filling
+     *
+     * Rows and columns are counted in samples: cells in ASCII mode, dots in braille mode.
+     */
+    struct ScanEdge{
+        long long row_begin = 0; ///< First sample row crossed by the edge
+        long long row_end = 0; ///< Sample row after the last one crossed by the edge
+        double col = 0; ///< Column coordinate of the crossing with the current row
+        double step = 0; ///< Change of col from one sample row to the next
+        int winding = 0; ///< +1 for edges going down, -1 for edges going up
+    };
+
+    /**
+     * @struct RasterOp
+     * @brief One recorded cell write of the rasterizer
+     */
+    struct RasterOp{
+        uint32_t cell = 0; ///< Row-major index of the cell
+        char glyph = '\0'; ///< Written glyph, or '\0' for a braille dot write
+        uint8_t dots = 0; ///< Braille dots added to the cell
+    };
+
+    /**
+     * @struct ProjectionCacheEntry
+     * @brief Cached rendering of one polyline, valid for one polyline version
+     *
+     * Holds the recorded cell writes when the polyline was rasterized serially,
+     * otherwise (tiled rendering) the clipped segments.
+     */
+    struct ProjectionCacheEntry{
+        uint64_t version = 0; ///< Polyline version the entry was computed for
+        size_t last_used = 0; ///< Frame counter value of the last use
+        bool valid = false; ///< Whether the entry holds a result
+        bool rasterized = false; ///< Whether cells (and not segments) hold the result
+        std::vector<Segment2D> segments{}; ///< Visible segments in all views
+        std::vector<RasterOp> cells{}; ///< Cell writes in rasterization order
+        Tile extent{}; ///< Cells the entry may write
+    };
+
+    /**
+     * @struct ClipRect
+     * @brief Rectangle in buffer coordinates that segments are clipped to
+     */
+    struct ClipRect{
+        double x_min = 0; ///< Smallest visible row coordinate
+        double x_max = 0; ///< Largest visible row coordinate
+        double y_min = 0; ///< Smallest visible column coordinate
+        double y_max = 0; ///< Largest visible column coordinate
+    };
+
+    /**
+     * @brief Computes the Cohen-Sutherland outcode of a point
+     * @param point Projected point
+     * @param rect Clipping rectangle
+     * @return uint8_t Bits 1/2 for above/below, 4/8 for left/right of the rectangle
+     *
+     * Branch-free, so a loop over many points vectorizes. A NaN coordinate sets both
+     * bits of its axis, which never happens for a real point.
+     */
+    inline uint8_t outcode(const BufferPoint& point, const ClipRect& rect){
+        return static_cast<uint8_t>((!(point.x >= rect.x_min)) | (!(point.x <= rect.x_max) << 1) |
+                                    (!(point.y >= rect.y_min) << 2) | (!(point.y <= rect.y_max) << 3));
+    }
+
+    /**
+     * @brief Clips a segment to a rectangle with the Liang-Barsky algorithm
+     * @param start Start of the segment, moved to the first visible point
+     * @param end End of the segment, moved to the last visible point
+     * @param rect Clipping rectangle
+     * @param start_clipped Set to true if start was moved
+     * @param end_clipped Set to true if end was moved
+     * @return bool False if no part of the segment is inside the rectangle
+     */
+    inline bool clip_segment(BufferPoint& start, BufferPoint& end, const ClipRect& rect, bool& start_clipped, bool& end_clipped){
+        double dx = end.x - start.x, dy = end.y - start.y;
+        double p[4] = {-dx, dx, -dy, dy};
+        double q[4] = {start.x - rect.x_min, rect.x_max - start.x, start.y - rect.y_min, rect.y_max - start.y};
+        double t0 = 0, t1 = 1;
+        for(size_t k = 0; k < 4; k++){
+            if(p[k] == 0){
+                if(q[k] < 0){ return false; }
+                continue;
+            }
+            double r = q[k] / p[k];
+            if(p[k] < 0){
+                if(r > t1){ return false; }
+                t0 = std::max(t0, r);
+            }
+            else{
+                if(r < t0){ return false; }
+                t1 = std::min(t1, r);
+            }
+        }
+        start_clipped = t0 > 0;
+        end_clipped = t1 < 1;
+        BufferPoint original = start;
+        if(start_clipped){ start = {original.x + t0 * dx, original.y + t0 * dy}; }
+        if(end_clipped){ end = {original.x + t1 * dx, original.y + t1 * dy}; }
+        return true;
+    }
+
+    /**
+     * @struct Projector
+     * @brief Camera matrix unpacked into scalars for projecting many points in a row
+     *
+     * Holding the coefficients by value lets the compiler keep them in registers and
+     * vectorize the projection loop, since they cannot alias the output array.
+     */
+    struct Projector{
+        static constexpr double near_w = 1e-3; ///< Smallest w of a drawn point in perspective projection
+
+        double m[4][3]{}; ///< Coefficients of the camera matrix
+        double anchor_row = 0; ///< Buffer row of the camera origin
+        double anchor_col = 0; ///< Buffer column of the camera origin
+        bool perspective = false; ///< Whether the division by w is needed
+        bool round_rows = true; ///< Whether rows are rounded to whole cells (ASCII mode)
+
+        /**
+         * @brief Projects one 3D point
+         * @tparam T Numeric type of point coordinates (must satisfy Numeric concept)
+         * @param point 3D point to project
+         * @return BufferPoint with buffer coordinates
+         *
+         * For perspective projection w is clamped to near_w, so a point behind the eye
+         * does not divide by zero; its position is meaningless, and segments reaching
+         * behind the near plane must be cut with near_point before drawing.
+         */
+        template <Numeric T>
+        BufferPoint operator()(const Point<T>& point) const{
+            double x = point.x, y = point.y, z = point.z;
+            double row = x * m[0][0] + y * m[1][0] + z * m[2][0] + m[3][0];
+            double col = x * m[0][1] + y * m[1][1] + z * m[2][1] + m[3][1];
+            if(perspective){
+                double w = std::max(x * m[0][2] + y * m[1][2] + z * m[2][2] + m[3][2], near_w);
+                row /= w;
+                col /= w;
+            }
+            return BufferPoint{(round_rows ? std::round(row) : row) + anchor_row, col + anchor_col};
+        }
+
+        /**
+         * @brief Checks whether a point lies behind the near plane
+         * @tparam T Numeric type of point coordinates (must satisfy Numeric concept)
+         * @param point 3D point
+         * @return bool True in perspective projection when w < near_w
+         */
+        template <Numeric T>
+        bool behind(const Point<T>& point) const{
+            return perspective && point.x * m[0][2] + point.y * m[1][2] + point.z * m[2][2] + m[3][2] < near_w;
+        }
+
+        /**
+         * @brief Projects the point where a segment crosses the near plane
+         * @tparam T Numeric type of point coordinates (must satisfy Numeric concept)
+         * @param hidden End of the segment behind the near plane
+         * @param visible End of the segment in front of it
+         * @return BufferPoint Projection of the crossing point
+         *
+         * w is affine in the point, so the crossing is found in homogeneous
+         * coordinates, before the division that mirrors points behind the eye.
+         */
+        template <Numeric T>
+        BufferPoint near_point(const Point<T>& hidden, const Point<T>& visible) const{
+            auto w = [this](double x, double y, double z){ return x * m[0][2] + y * m[1][2] + z * m[2][2] + m[3][2]; };
+            double w0 = w(hidden.x, hidden.y, hidden.z), w1 = w(visible.x, visible.y, visible.z);
+            double t = (near_w - w0) / (w1 - w0);
+            Point<double> crossing{hidden.x + t * (static_cast<double>(visible.x) - hidden.x),
+                                   hidden.y + t * (static_cast<double>(visible.y) - hidden.y),
+                                   hidden.z + t * (static_cast<double>(visible.z) - hidden.z), '\0'};
+            return (*this)(crossing);
+        }
+    };
+
     /**
      * @class Buffer
-     * @brief 2D character buffer for rendering 3D polylines with isometric projection
+     * @brief 2D character buffer for rendering 3D polylines through a Camera
      * @tparam height_ Height of the buffer in characters (compile-time constant)
      * @tparam width_ Width of the buffer in characters (compile-time constant)
-     * 
-     * The Buffer class provides a character-based display for 3D graphics using
-     * isometric projection. It supports rendering polylines with automatic line
-     * drawing and colored terminal output.
+     *
+     * The Buffer class provides a character-based display for 3D graphics. Points are
+     * projected by the Camera returned from camera(); its default is the isometric
+     * projection. It supports rendering polylines with automatic line drawing and
+     * colored terminal output.
+     *
+     * All points of a polyline are projected in one batch into a reusable scratch
+     * array before any segment is rasterized. The projected segments are then clipped
+     * to the buffer rectangle (outcodes for all points first, Liang-Barsky for the
+     * segments crossing the border), so only their visible parts are rasterized.
+     *
+     * Long polylines are rendered tile by tile: the screen is split into tiles of
+     * tile_height_ x tile_width_ cells, segments are binned by the tiles their bounding
+     * box overlaps, and the tiles are rasterized in parallel. Every tile replays its
+     * segments in the original order, so the result is identical to serial rendering.
+     *
+     * In RenderMode::Braille lines are rasterized into a 2x4 dot mask per cell, which
+     * gives 8x the resolution of ASCII mode. Point labels are kept in the glyph matrix
+     * and override the dots of their cell on output.
+     *
+     * Drawing goes into one of four layers (see Layer), selected with buffer << Layer.
+     * The background layer (axes and polylines added with add_background) is rasterized
+     * once and rebuilt only after a view camera or the render mode has changed. Every
+     * layer tracks the rectangle drawn into since it was cleared and the rectangle
+     * changed since the last encode(). clean_buffer(), clean_dynamic() and clear_layer() wipe only the
+     * drawn rectangles, and encode() composites the layers into the output planes only
+     * inside the union of the changed ones, so redrawing a small moving object costs
+     * in proportion to its size and not to the size of the screen.
+     *
+     * Colors are stored per cell as an index into a small palette (attribute plane).
+     * Index 0 is the automatic coloring (lines green, labels blue); sending a Color to
+     * the buffer selects the color of everything drawn afterwards. The frame encoder
+     * emits a color escape only where the color changes along a row.
+     *
+     * draw_instances renders one polyline under many Transforms. Each instance is
+     * projected through the product of its transform and the camera matrix, so the
+     * polyline is never copied.
+     *
+     * draw_cached keeps the clipped segments of every polyline keyed by its id and
+     * version, so a frame where one of many polylines changed projects only that one.
+     *
+     * set_viewports splits the buffer into rectangles with their own cameras (for
+     * example quad_viewports: top, front, side and isometric). Every point is read
+     * once and projected into all views in the same pass; segments are clipped to
+     * their view and rasterization never writes outside it.
      */
     template <size_t height_, size_t width_>
     class Buffer{
     private:
-        Matrix<char, height_, width_> buffer_{}; ///< Character matrix representing the display buffer
+        static constexpr size_t tile_height_ = 16; ///< Height of a rasterization tile in characters
+        static constexpr size_t tile_width_ = 64; ///< Width of a rasterization tile in characters
+        static constexpr size_t tile_rows_ = (height_ + tile_height_ - 1) / tile_height_; ///< Number of tile rows
+        static constexpr size_t tile_cols_ = (width_ + tile_width_ - 1) / tile_width_; ///< Number of tile columns
+        static constexpr size_t parallel_threshold_ = 4096; ///< Minimal segment count rendered with tiles
+        static constexpr size_t projection_chunk_ = 16384; ///< Points projected by one parallel job
+        static constexpr size_t max_viewports_ = 256; ///< Viewport indices must fit into Segment2D::view
+
+        /**
+         * @struct LayerPlanes
+         * @brief Cells drawn into one layer
+         */
+        struct LayerPlanes{
+            Matrix<char, height_, width_> glyphs{}; ///< Glyphs, ' ' where nothing was drawn
+            Matrix<uint8_t, height_, width_> dots{}; ///< Braille dot masks
+            Matrix<uint8_t, height_, width_> attrs{}; ///< Palette index of every cell's color
+            Tile drawn{}; ///< Bounding rectangle of the cells drawn since the layer was cleared
+            mutable Tile dirty{}; ///< Bounding rectangle of the cells changed since the last composite
+        };
+
+        mutable Matrix<char, height_, width_> buffer_{}; ///< Composited glyphs of all layers
+        mutable Matrix<uint8_t, height_, width_> dots_{}; ///< Composited braille dot masks, used in RenderMode::Braille
+        mutable Matrix<uint8_t, height_, width_> attrs_{}; ///< Composited palette index of every cell's color
+        std::array<LayerPlanes, layer_count> layers_{}; ///< Layers from bottom to top
+        Layer layer_ = Layer::Dynamic; ///< Layer drawn into now
+        std::vector<Color> palette_{Color::automatic()}; ///< Colors referenced by attrs_, index 0 is automatic
+        uint8_t attr_ = 0; ///< Palette index used for the cells drawn now
+        RenderMode mode_ = RenderMode::Ascii; ///< Current rasterization mode
+        Camera camera_{}; ///< Camera used for projection
+        std::vector<Polyline<double>> background_lines_{}; ///< Extra polylines drawn into the background
+        bool background_valid_ = false; ///< Whether the background layer may be used
+        std::vector<size_t> background_versions_{}; ///< Versions of the view cameras the background was drawn with
+        RenderMode background_mode_ = RenderMode::Ascii; ///< Render mode the background was drawn with
+        bool static_valid_ = false; ///< Whether the static layer was drawn since clean_dynamic() last wiped it
+        std::vector<size_t> static_versions_{}; ///< Versions of the view cameras the static layer was drawn with
+        RenderMode static_mode_ = RenderMode::Ascii; ///< Render mode the static layer was drawn with
+        std::unique_ptr<UtilsNameSpace::ThreadPool> pool_{}; ///< Worker threads, created on the first tiled render
+        std::vector<BufferPoint> points_2d_{}; ///< Projected points of the polyline being rendered
+        std::vector<uint8_t> outcodes_{}; ///< Outcodes of one view's points against its clipping rectangle
+        std::vector<Segment2D> segments_{}; ///< Visible parts of the segments being rendered
+        std::vector<size_t> tile_offsets_{}; ///< Start of every tile's list in tile_segments_
+        std::vector<size_t> tile_segments_{}; ///< Segment indices binned by tile, in drawing order
+        StageTimes stage_times_{}; ///< Accumulated stage durations
+        std::vector<Viewport> viewports_{}; ///< Sub-viewports, empty for one view of the whole buffer through camera_
+        std::vector<Projector> projectors_{}; ///< Projector of every view for the polyline being rendered
+        std::unordered_map<uint64_t, ProjectionCacheEntry> projection_cache_{}; ///< Clipped segments by polyline id
+        std::vector<size_t> projection_cache_versions_{}; ///< Versions of the view cameras the cache was filled with
+        size_t projection_cache_hits_ = 0; ///< Number of draw_cached calls replayed from the cache
+        size_t frame_ = 0; ///< Number of clean_buffer and clean_dynamic calls, ages cache entries
+        std::vector<RasterOp>* raster_log_ = nullptr; ///< Receives the cell writes of serial rasterization when set
+        static constexpr size_t cache_lifetime_ = 64; ///< Frames an unused cache entry is kept for
+        std::vector<ScanEdge> scan_edges_{}; ///< Edges of the polygon being filled, sorted by first row
+        std::vector<ScanEdge> active_edges_{}; ///< Edges crossing the current sample row, sorted by column
+
+        /**
+         * @brief Builds the projectors of all views into projectors_
+         * @param transform Model transform applied before every camera, or nullptr
+         *
+         * Every projector holds its camera matrix, the anchor of its view and the
+         * current render mode.
+         */
+        void prepare_projectors(const Transform* transform);
+
+        /**
+         * @brief Projects all points of a polyline into points_2d_ for every view
+         * @tparam T Numeric type of point coordinates (must satisfy Numeric concept)
+         * @param polyline Polyline to project
+         *
+         * Uses projectors_. The points of view v are stored at [v * size, (v + 1) * size).
+         * Every point is read once and projected into all views in the same pass.
+         * Polylines longer than projection_chunk_ points are projected in parallel chunks.
+         */
+        template <Numeric T>
+        void project(const Polyline<T>& polyline);
 
         /**
-         * @brief Converts 3D point to 2D buffer coordinates using isometric projection
+         * @brief Clips the segments of a projected polyline and appends them to segments_
          * @tparam T Numeric type of point coordinates (must satisfy Numeric concept)
-         * @param point 3D point to convert (Point<T> with x, y, z coordinates)
-         * @return BufferPoint containing 2D screen coordinates after projection
-         * 
-         * The projection formula used:
-         * x_2d = round((point.x + point.y) / sqrt(15) - point.z * 0.6) + height_ * 2 / 3
-         * y_2d = point.y - point.x + width_ / 2
+         * @param polyline Polyline whose points are already in points_2d_
+         * @param view View whose projected points are clipped
+         *
+         * Segments are clipped to the area of the view with a one cell margin.
+         * Segments with both ends on the same outer side are rejected by their
+         * outcodes, segments inside are kept as is, and only the rest is clipped.
+         * In perspective projection segments are first cut at the near plane, so
+         * no end behind the eye is drawn. A single point polyline gives one
+         * degenerate segment.
          */
         template <Numeric T>
-        BufferPoint get_point_2d(const Point<T>& point);
+        void clip(const Polyline<T>& polyline, size_t view);
+
+        /**
+         * @brief Rasterizes segments_ in the current render mode
+         *
+         * When at least parallel_threshold_ segments are visible they are rendered
+         * with draw_tiled (ASCII mode only).
+         */
+        void draw_segments();
+
+        /**
+         * @brief Computes the cells segments_ may write
+         * @return Tile covering every cell the segments (and their labels) can touch
+         */
+        Tile segments_extent() const;
+
+        /**
+         * @brief Get the layer drawn into now
+         * @return Reference to the planes of layer_
+         */
+        LayerPlanes& active_layer();
+
+        /**
+         * @brief Records that cells of the active layer are about to be drawn
+         * @param area Cells that may be written
+         *
+         * Called before rasterizing rather than per cell, so tiled rendering does not
+         * contend on the rectangles.
+         */
+        void mark_drawn(const Tile& area);
+
+        /**
+         * @brief Wipes the drawn rectangle of a layer
+         * @param planes Layer to wipe
+         */
+        void wipe(LayerPlanes& planes);
+
+        /**
+         * @brief Composites the layers into the output planes inside the changed rectangles
+         *
+         * Brings buffer_, dots_ and attrs_ up to date; called by encode().
+         */
+        void composite() const;
 
         /**
          * @brief Calculates perpendicular distance from a point to a line segment
@@ -75,162 +602,1410 @@ namespace BufferNameSpace {
          * @param start_line Start point of the line segment (BufferPoint)
          * @param end_line End point of the line segment (BufferPoint)
          * @return double Distance from the point to the line segment
-         * 
+         *
          * Uses the formula for distance from point to line:
-         * distance = |(end.x - start.x)*(start.y - point.y) - (start.x - point.x)*(end.y - start.y)| 
+         * distance = |(end.x - start.x)*(start.y - point.y) - (start.x - point.x)*(end.y - start.y)|
          *            / sqrt((end.x - start.x)² + (end.y - start.y)²)
          */
         double distance_to_the_line(const BufferPoint& point, const BufferPoint& start_line, const BufferPoint& end_line);
 
         /**
-         * @brief Draws a line between two 3D points in the buffer using Bresenham-like algorithm
-         * @tparam T Numeric type of point coordinates (must satisfy Numeric concept)
-         * @param point1 First 3D point (Point<T> with x, y, z coordinates and name)
-         * @param point2 Second 3D point (Point<T> with x, y, z coordinates and name)
-         * 
-         * Draws the points themselves as their character labels and connects them
-         * with '-' characters. Uses distance-based line drawing for smooth lines.
+         * @brief Draws a clipped segment in the current render mode, inside its view
+         * @param segment Segment to draw
          */
-        template <Numeric T>
-        void draw_line(const Point<T>& point1, const Point<T>& point2);
+        void draw_segment(const Segment2D& segment);
+
+        /**
+         * @brief Rasterizes a projected segment, writing only inside the given tile
+         * @param segment Visible part of the segment with its bounds before clipping
+         * @param tile Region of the buffer that may be written
+         *
+         * Performs exactly the writes of the whole segment that fall into the tile,
+         * in the same order. For every row only the columns near the line are tested.
+         */
+        void rasterize_segment(const Segment2D& segment, const Tile& tile);
+
+        /**
+         * @brief Draws a projected segment as braille dots
+         * @param point1 First projected point (fractional row)
+         * @param name1 Character label of the first point
+         * @param point2 Second projected point (fractional row)
+         * @param name2 Character label of the second point
+         * @param area Cells that may be written
+         *
+         * Rasterizes the segment with Bresenham's algorithm on the dot grid
+         * (4 * height_ x 2 * width_) and stores the point labels in the glyph matrix.
+         */
+        void draw_braille_segment(const BufferPoint& point1, char name1, const BufferPoint& point2, char name2, const Tile& area);
+
+        /**
+         * @brief Fills a projected polygon
+         * @param points Projected vertices
+         * @param size Number of vertices
+         * @param area Cells that may be written
+         * @param style Fill rule and glyph
+         *
+         * Active edge table scanline: edges are sorted by their first sample row, and
+         * every row walks only the edges crossing it, so the cost is proportional to
+         * the number of edges plus the number of filled samples.
+         */
+        void fill_scanlines(const BufferPoint* points, size_t size, const Tile& area, const FillStyle& style);
+
+        /**
+         * @brief Fills samples [col_begin, col_end) of one sample row
+         * @param row Sample row
+         * @param col_begin First filled sample column
+         * @param col_end Sample column after the last filled one
+         * @param glyph Glyph of filled cells in ASCII mode
+         */
+        void fill_span(long long row, long long col_begin, long long col_end, char glyph);
+
+        /**
+         * @brief Computes the clamped bounding box of a projected segment
+         * @param point1 First projected point
+         * @param point2 Second projected point
+         * @return Tile with inclusive bounds [row_begin, row_end] x [col_begin, col_end]
+         */
+        Tile segment_bounds(const BufferPoint& point1, const BufferPoint& point2) const;
+
+        /**
+         * @brief Renders segments_ by rasterizing screen tiles in parallel
+         *
+         * Bins segments by tile with a counting sort and rasterizes the tiles on
+         * the thread pool.
+         */
+        void draw_tiled();
+
+        /**
+         * @brief Returns the thread pool, creating it on first use
+         * @return Reference to the pool
+         */
+        UtilsNameSpace::ThreadPool& get_pool();
 
         /**
          * @brief Draws coordinate axes (X, Y, Z) in the buffer
-         * 
+         *
          * Creates axes labeled 'X', 'Y', 'Z' originating from point 'O' (origin).
-         * The axes are drawn using the draw_line method.
+         * Every view gets its own axes, as long as the view is high.
          */
         void draw_axes();
 
+        /**
+         * @brief Writes a glyph and the current attribute into a cell
+         * @param x Row of the cell
+         * @param y Column of the cell
+         * @param glyph Character to write
+         */
+        void put(size_t x, size_t y, char glyph);
+
+        /**
+         * @brief Returns the palette index of a color, adding it if needed
+         * @param color Color to look up
+         * @return uint8_t Index in palette_
+         * @throws std::length_error if 256 colors are in use by drawn cells at once
+         *
+         * When the palette is full, an index no layer cell refers to any more is
+         * reused, so a long-lived buffer may see any number of colors over time.
+         */
+        uint8_t palette_index(const Color& color);
+
+        /**
+         * @brief Returns the color a visible cell is printed with
+         * @param x Row of the cell
+         * @param y Column of the cell
+         * @param is_label Whether the cell shows a point label
+         * @return Color from the palette, or the automatic line or label color
+         */
+        Color cell_color(size_t x, size_t y, bool is_label) const;
+
+        /**
+         * @brief Checks whether a drawn glyph is printed in the label color
+         * @param glyph Non-blank glyph of a composited cell
+         * @return bool True for point names, and for every glyph in braille mode
+         */
+        bool is_label(char glyph) const;
+
+        /**
+         * @brief Classifies a composited cell and passes what it prints to a visitor
+         * @tparam Visit Callable as visit(text, visible, label)
+         * @param x Row of the cell
+         * @param y Column of the cell
+         * @param visit Receives the printed text (a char, or a std::string_view for a
+         *        braille character), whether the cell is not blank, and whether it
+         *        takes the label color (see cell_color)
+         *
+         * The only place deciding between braille dots and a glyph and between the
+         * line and label colors, shared by encode_text and frame_cell so frames,
+         * recordings and deltas always agree. A visitor instead of a returned value
+         * keeps a single byte a char, and the color is looked up only by callers
+         * that print it.
+         */
+        template <typename Visit>
+        void visit_cell(size_t x, size_t y, Visit&& visit) const;
+
+        /**
+         * @brief Computes what a composited cell is printed as
+         * @param x Row of the cell
+         * @param y Column of the cell
+         * @return FrameCell with the glyph or braille character and its color
+         */
+        FrameCell frame_cell(size_t x, size_t y) const;
+
+        /**
+         * @brief Appends the frame as text
+         * @param out String to append to
+         * @param colored Whether ANSI color escapes are emitted
+         */
+        void encode_text(std::string& out, bool colored) const;
+
+        /**
+         * @brief Appends the frame as a binary PGM or PPM bitmap
+         * @param out String to append to
+         * @param colored Whether a PPM (true) or a PGM (false) is produced
+         */
+        void encode_bitmap(std::string& out, bool colored) const;
+
+        /**
+         * @brief Stores the versions of all view cameras
+         * @param versions Vector receiving camera_ first, then the viewport cameras
+         */
+        void store_view_versions(std::vector<size_t>& versions) const;
+
+        /**
+         * @brief Checks stored camera versions against the current view cameras
+         * @param versions Versions saved by store_view_versions
+         * @return bool True if no view camera changed since
+         */
+        bool view_versions_match(const std::vector<size_t>& versions) const;
+
+        /**
+         * @brief Checks whether the cached background no longer matches the views
+         * @return bool True if the cache is invalid or a view camera or the mode changed
+         */
+        bool background_stale() const;
+
+        /**
+         * @brief Rasterizes the background layer
+         *
+         * Draws the axes and all background polylines into the cleared background layer.
+         */
+        void rebuild_background();
+
+        /**
+         * @brief Per-frame bookkeeping shared by clean_buffer and clean_dynamic
+         *
+         * Ages the projection cache and rebuilds the background if it is stale.
+         */
+        void start_frame();
+
     public:
         /**
          * @brief Default constructor
-         * 
+         *
          * Initializes the buffer with spaces and draws coordinate axes.
          */
         Buffer();
 
         /**
          * @brief Clears the buffer and redraws axes
-         * 
-         * Fills the buffer with space characters and redraws the coordinate axes.
+         *
+         * Wipes every layer above the background; the background (spaces and
+         * coordinate axes) is redrawn only if a view camera or the mode changed.
          * Useful for resetting the display between frames.
          */
         void clean_buffer();
 
         /**
-         * @brief Stream insertion operator for Polyline objects
-         * @tparam T Numeric type of polyline coordinates (must satisfy Numeric concept)
+         * @brief Clears the buffer for a frame that keeps its static geometry
+         * @return bool True if Layer::Static was wiped too and has to be redrawn
+         *
+         * Like clean_buffer(), but Layer::Static survives as long as no view camera
+         * and not the mode changed since the previous clean_dynamic(). After
+         * clean_buffer() or clear_layer(Layer::Static) it is wiped the next time.
+         */
+        bool clean_dynamic();
+
+        /**
+         * @brief Wipes one layer, keeping the others
+         * @param layer Layer to wipe
+         * @throws std::invalid_argument for Layer::Background
+         *
+         * Only the rectangle drawn into since the last wipe is cleared. A frame loop
+         * that keeps its static geometry wipes and redraws Layer::Dynamic only.
+         */
+        void clear_layer(Layer layer);
+
+        /**
+         * @brief Adds a polyline to the static background layer
+         * @param polyline Polyline to draw under every frame (grid lines, annotations)
+         *
+         * The background is rebuilt and restored into the buffer.
+         */
+        void add_background(Polyline<double> polyline);
+
+        /**
+         * @brief Removes all polylines added with add_background
+         *
+         * Only the axes remain in the background. The buffer is cleaned.
+         */
+        void clear_background();
+
+        /**
+         * @brief Switches the rasterization mode
+         * @param mode New render mode
+         *
+         * Clears the buffer, so the next frame is drawn entirely in the new mode.
+         */
+        void set_mode(RenderMode mode);
+
+        /**
+         * @brief Get the current rasterization mode
+         * @return RenderMode Current mode
+         */
+        RenderMode get_mode() const;
+
+        /**
+         * @brief Appends the whole frame in the given format
+         * @param out String to append to
+         * @param format Frame encoding
+         *
+         * In FrameFormat::Ansi every row ends with a reset and a newline. A color
+         * escape is emitted only when the color changes between visible cells of a
+         * row; spaces never switch colors.
+         *
+         * Bitmaps have one pixel per cell in ASCII mode and one pixel per dot in braille
+         * mode, where a labelled cell is filled completely. Empty pixels are black.
+         */
+        void encode(std::string& out, FrameFormat format = FrameFormat::Ansi) const;
+
+        /**
+         * @brief Copies the visible frame cell by cell
+         * @param out Vector receiving height_ * width_ cells in row-major order
+         *
+         * Every cell holds exactly what encode() prints for it in FrameFormat::Ansi,
+         * so frames can be compared and re-encoded partially (see Recorder).
+         */
+        void cells(std::vector<FrameCell>& out) const;
+
+        /**
+         * @brief Selects the color of everything drawn afterwards
          * @param buffer Reference to the target buffer
-         * @param polyline Polyline object to render into the buffer
-         * @return Reference to the buffer after rendering
-         * 
-         * Renders each segment of the polyline using draw_line method.
-         * Friend function for direct access to buffer internals.
+         * @param color New drawing color (Color::automatic() restores legacy coloring)
+         * @return Reference to the buffer
          */
-        template <Numeric T>
-        friend Buffer& operator<<(Buffer& buffer, const Polyline<T>& polyline){
-            size_t size = polyline.points_count();
-            if(size == 1){ buffer.draw_line(polyline[0], polyline[0]); }
-            for(size_t i = 1; i < size; i++){
-                buffer.draw_line(polyline[i - 1], polyline[i]);
-            }
+        friend Buffer& operator<<(Buffer& buffer, const Color& color){
+            buffer.attr_ = buffer.palette_index(color);
             return buffer;
         }
 
         /**
-         * @brief Output stream operator for buffer display
-         * @param out Output stream to write to (e.g., std::cout)
-         * @param buffer Buffer object to display
-         * @return Reference to the output stream
-         * 
-         * Outputs the buffer contents with colored formatting:
-         * - Lines are displayed in GREEN
-         * - Points are displayed in BLUE
-         * Friend function for direct access to buffer internals.
+         * @brief Selects the layer of everything drawn afterwards
+         * @param buffer Reference to the target buffer
+         * @param layer New drawing layer
+         * @return Reference to the buffer
+         * @throws std::invalid_argument for Layer::Background, use add_background instead
          */
-        friend std::ostream& operator<<(std::ostream& out, const Buffer& buffer){
-            for(size_t x = 0; x < height_; x++){
-                std::for_each(buffer.buffer_.begin() + x * width_, buffer.buffer_.begin() + (x + 1) * width_, [&out](char elem){
-                    if(elem != '-'){ out << BLUE << elem << RESET; }
-                    else{ out << GREEN << elem << RESET; }
-                });
-                out << std::endl;
-            }
-            return out;
+        friend Buffer& operator<<(Buffer& buffer, Layer layer){
+            if(layer == Layer::Background){ throw std::invalid_argument("The background layer is drawn with add_background"); }
+            buffer.layer_ = layer;
+            return buffer;
         }
-    };
 
-    template <size_t height_, size_t width_>
-    template <Numeric T>
-    BufferPoint Buffer<height_, width_>::get_point_2d(const Point<T>& point){
-        BufferPoint result = {
-            std::round((point.x + point.y) / std::sqrt(15) - point.z * 0.6) + height_ * 2 / 3,
-            static_cast<double>(point.y) - static_cast<double>(point.x) + static_cast<double>(width_) / 2
+        /**
+         * @brief Access the camera used for projection
+         * @return Reference to the camera
+         *
+         * Camera changes take effect from the next rendered polyline; call
+         * clean_buffer() to redraw the axes with the new view. While viewports are
+         * set, each of them uses its own camera instead (see viewport_camera).
+         */
+        Camera& camera();
+
+        /**
+         * @brief Access the camera used for projection (const)
+         * @return Const reference to the camera
+         */
+        const Camera& camera() const;
+
+        /**
+         * @brief Splits the buffer into viewports with their own cameras
+         * @param viewports Viewports to render into; an empty list restores one view
+         *                  of the whole buffer through camera()
+         * @throws std::invalid_argument if a viewport is empty or leaves the buffer
+         * @throws std::length_error if there are more than 256 viewports
+         *
+         * Every polyline is then projected into all viewports in one pass over its
+         * points. The buffer is cleaned.
+         */
+        void set_viewports(std::vector<Viewport> viewports);
+
+        /**
+         * @brief Get the current viewports
+         * @return Const reference to the viewports, empty for one view of the whole buffer
+         */
+        const std::vector<Viewport>& viewports() const;
+
+        /**
+         * @brief Access the camera of a viewport
+         * @param index Index of the viewport
+         * @return Reference to the camera
+         * @throws std::out_of_range if there is no such viewport
+         */
+        Camera& viewport_camera(size_t index);
+
+        /**
+         * @brief Get the number of views
+         * @return size_t Number of viewports, or 1 when the whole buffer is one view
+         */
+        size_t view_count() const;
+
+        /**
+         * @brief Get the cells covered by a view
+         * @param view Index of the view
+         * @return Tile of the viewport, or the whole buffer without viewports
+         */
+        Tile view_area(size_t view) const;
+
+        /**
+         * @brief Get the camera of a view
+         * @param view Index of the view
+         * @return Const reference to the viewport camera, or camera_ without viewports
+         */
+        const Camera& view_camera(size_t view) const;
+
+        /**
+         * @brief Builds the projection of a view
+         * @param view Index of the view
+         * @param transform Model transform applied before the camera, or nullptr
+         * @return Projector mapping 3D points to buffer coordinates of the view
+         *
+         * Rows are rounded to whole cells in ASCII mode, like everything drawn into the
+         * buffer; vector output (see write_svg) clears round_rows.
+         */
+        Projector view_projector(size_t view, const Transform* transform = nullptr) const;
+
+        /**
+         * @brief Stream insertion operator for Polyline objects
+         * @tparam T Numeric type of polyline coordinates (must satisfy Numeric concept)
+         * @param buffer Reference to the target buffer
+         * @param polyline Polyline object to render into the buffer
+         * @return Reference to the buffer after rendering
+         *
+         * Projects all points of the polyline, clips the segments to the buffer and
+         * renders the visible ones. When at least parallel_threshold_ segments are
+         * visible they are rendered with draw_tiled (ASCII mode only).
+         * Friend function for direct access to buffer internals.
+         */
+        template <Numeric T>
+        friend Buffer& operator<<(Buffer& buffer, const Polyline<T>& polyline){
+            buffer.segments_.clear();
+            if(polyline.points_count() == 0){ return buffer; }
+            auto start = std::chrono::steady_clock::now();
+            buffer.prepare_projectors(nullptr);
+            buffer.project(polyline);
+            for(size_t view = 0; view < buffer.view_count(); view++){
+                buffer.clip(polyline, view);
+            }
+            auto projected = std::chrono::steady_clock::now();
+            buffer.draw_segments();
+            buffer.stage_times_.projection += projected - start;
+            buffer.stage_times_.rasterization += std::chrono::steady_clock::now() - projected;
+            return buffer;
+        }
+
+        /**
+         * @brief Renders a polyline, reusing its projection from earlier frames
+         * @tparam T Numeric type of polyline coordinates (must satisfy Numeric concept)
+         * @param polyline Polyline to render
+         *
+         * Produces the same cells as buffer << polyline. The cell writes of the
+         * rasterizer (the clipped segments for tiled rendering) are cached by
+         * polyline id() and replayed while the polyline version(), the render mode
+         * and all view cameras are unchanged, so only stale polylines are projected
+         * and rasterized again. Entries of polylines not drawn for cache_lifetime_
+         * frames are dropped.
+         */
+        template <Numeric T>
+        void draw_cached(const Polyline<T>& polyline);
+
+        /**
+         * @brief Get the number of polylines with cached projections
+         * @return size_t Number of cache entries
+         */
+        size_t cached_projections() const;
+
+        /**
+         * @brief Get the number of draw_cached calls served from the cache
+         * @return size_t Number of replayed polylines since the buffer was created
+         */
+        size_t projection_cache_hits() const;
+
+        /**
+         * @brief Renders one polyline under many transforms
+         * @tparam T Numeric type of polyline coordinates (must satisfy Numeric concept)
+         * @param polyline Template shape
+         * @param transforms Transform of every instance
+         *
+         * The visible segments of all instances are collected first and rasterized
+         * together, in instance order, so thousands of small instances still use the
+         * tiled renderer.
+         */
+        template <Numeric T>
+        void draw_instances(const Polyline<T>& polyline, std::span<const Transform> transforms);
+
+        /**
+         * @brief Fills the region enclosed by a polyline
+         * @tparam T Numeric type of polyline coordinates (must satisfy Numeric concept)
+         * @param polyline Outline of the region, closed implicitly from the last point to the first
+         * @param style Fill rule and glyph
+         *
+         * A sample (a cell in ASCII mode, a dot in braille mode) is filled when its
+         * center is inside the projected outline. The outline itself is not drawn;
+         * send the polyline to the buffer afterwards to outline the region.
+         */
+        template <Numeric T>
+        void fill(const Polyline<T>& polyline, const FillStyle& style = FillStyle{});
+
+        /**
+         * @brief Get the time spent projecting and rasterizing polylines
+         * @return Const reference to the accumulated StageTimes
+         *
+         * Every operator<< for a polyline and every draw_instances call adds to it.
+         */
+        const StageTimes& stage_times() const;
+
+        /**
+         * @brief Sets the accumulated stage times to zero
+         */
+        void reset_stage_times();
+
+        /**
+         * @brief Output stream operator for buffer display
+         * @param out Output stream to write to (e.g., std::cout)
+         * @param buffer Buffer object to display
+         * @return Reference to the output stream
+         *
+         * Outputs the buffer contents with colored formatting:
+         * - Lines are displayed in green unless drawn with another Color
+         * - Points are displayed in blue unless drawn with another Color
+         * In braille mode every cell without a label is printed as the braille
+         * character of its dot mask, looked up in braille_utf8.
+         * The frame is encoded into one string and written at once.
+         * Friend function for direct access to buffer internals.
+         */
+        friend std::ostream& operator<<(std::ostream& out, const Buffer& buffer){
+            std::string frame;
+            buffer.encode(frame);
+            out.write(frame.data(), static_cast<std::streamsize>(frame.size()));
+            return out;
+        }
+    };
+
+    template <size_t height_, size_t width_>
+    size_t Buffer<height_, width_>::view_count() const{
+        return viewports_.empty() ? 1 : viewports_.size();
+    }
+
+    template <size_t height_, size_t width_>
+    Tile Buffer<height_, width_>::view_area(size_t view) const{
+        return viewports_.empty() ? Tile{0, height_, 0, width_} : viewports_[view].area;
+    }
+
+    template <size_t height_, size_t width_>
+    const Camera& Buffer<height_, width_>::view_camera(size_t view) const{
+        return viewports_.empty() ? camera_ : viewports_[view].camera;
+    }
+
+    template <size_t height_, size_t width_>
+    Projector Buffer<height_, width_>::view_projector(size_t view, const Transform* transform) const{
+        const Camera& camera = view_camera(view);
+        Matrix<double, 4, 3> matrix = transform ? homogeneous(*transform) * camera.matrix() : camera.matrix();
+        Tile area = view_area(view);
+        size_t rows = area.row_end - area.row_begin;
+        Projector projector;
+        for(size_t i = 0; i < 4; i++){
+            for(size_t j = 0; j < 3; j++){
+                projector.m[i][j] = matrix[i, j];
+            }
+        }
+        projector.anchor_row = static_cast<double>(area.row_begin + (camera.get_view() == View::Isometric ? rows * 2 / 3 : rows / 2));
+        projector.anchor_col = static_cast<double>(area.col_begin) + static_cast<double>(area.col_end - area.col_begin) / 2;
+        projector.perspective = camera.get_projection() == Projection::Perspective;
+        projector.round_rows = mode_ == RenderMode::Ascii;
+        return projector;
+    }
+
+    template <size_t height_, size_t width_>
+    void Buffer<height_, width_>::prepare_projectors(const Transform* transform){
+        projectors_.resize(view_count());
+        for(size_t view = 0; view < projectors_.size(); view++){
+            projectors_[view] = view_projector(view, transform);
+        }
+    }
+
+    template <size_t height_, size_t width_>
+    template <Numeric T>
+    void Buffer<height_, width_>::project(const Polyline<T>& polyline){
+        UtilsNameSpace::ScopedTimer timer(UtilsNameSpace::ProfileStage::Projection);
+        size_t size = polyline.points_count();
+        size_t views = projectors_.size();
+        UtilsNameSpace::Profiler::count(UtilsNameSpace::ProfileCounter::PointsProjected, size * views);
+        points_2d_.resize(size * views);
+        const Point<T>* source = polyline.begin();
+        BufferPoint* target = points_2d_.data();
+        const Projector* projectors = projectors_.data();
+        auto project_range = [projectors, views, source, target, size](size_t begin, size_t end){
+            if(views == 1){
+                Projector projector = projectors[0];
+                for(size_t i = begin; i < end; i++){
+                    target[i] = projector(source[i]);
+                }
+                return;
+            }
+            for(size_t i = begin; i < end; i++){
+                const Point<T> point = source[i];
+                for(size_t view = 0; view < views; view++){
+                    target[view * size + i] = projectors[view](point);
+                }
+            }
         };
-        return result;
+        if(size <= projection_chunk_){
+            project_range(0, size);
+            return;
+        }
+        get_pool().parallel_for((size + projection_chunk_ - 1) / projection_chunk_, [&project_range, size](size_t chunk){
+            project_range(chunk * projection_chunk_, std::min(size, (chunk + 1) * projection_chunk_));
+        });
+    }
+
+    template <size_t height_, size_t width_>
+    template <Numeric T>
+    void Buffer<height_, width_>::clip(const Polyline<T>& polyline, size_t view){
+        size_t size = polyline.points_count();
+        outcodes_.resize(size);
+        const BufferPoint* points = points_2d_.data() + view * size;
+        uint8_t* codes = outcodes_.data();
+        Tile area = view_area(view);
+        // One cell margin around the view, as labels and lines may reach just outside it
+        const ClipRect rect = {static_cast<double>(area.row_begin) - 1, static_cast<double>(area.row_end),
+                               static_cast<double>(area.col_begin) - 1, static_cast<double>(area.col_end)};
+        uint8_t view_index = static_cast<uint8_t>(view);
+        for(size_t i = 0; i < size; i++){
+            codes[i] = outcode(points[i], rect);
+        }
+        // Points behind the near plane get a code of their own, so segments between two
+        // of them are rejected like any segment with both ends on one side
+        const Projector& projector = projectors_[view];
+        constexpr uint8_t hidden = 0x10;
+        if(projector.perspective){
+            for(size_t i = 0; i < size; i++){
+                if(projector.behind(polyline[i])){ codes[i] = hidden; }
+            }
+        }
+        auto invalid = [](uint8_t code){ return (code & 0x3) == 0x3 || (code & 0xC) == 0xC; };
+        if(size == 1){
+            if(codes[0] == 0){ segments_.push_back({points[0], points[0], polyline[0].name_, polyline[0].name_, view_index, segment_bounds(points[0], points[0])}); }
+            return;
+        }
+        for(size_t i = 1; i < size; i++){
+            uint8_t code1 = codes[i - 1], code2 = codes[i];
+            if((code1 & code2) != 0 || invalid(code1) || invalid(code2)){ continue; }
+            Segment2D segment = {points[i - 1], points[i], polyline[i - 1].name_, polyline[i].name_, view_index};
+            if(((code1 | code2) & hidden) != 0){
+                if(code1 == hidden){
+                    segment.start = projector.near_point(polyline[i - 1], polyline[i]);
+                    segment.start_name = '\0';
+                    code1 = outcode(segment.start, rect);
+                }
+                else{
+                    segment.end = projector.near_point(polyline[i], polyline[i - 1]);
+                    segment.end_name = '\0';
+                    code2 = outcode(segment.end, rect);
+                }
+                if((code1 & code2) != 0 || invalid(code1) || invalid(code2)){ continue; }
+            }
+            segment.bounds = segment_bounds(segment.start, segment.end);
+            if((code1 | code2) != 0){
+                bool start_clipped = false, end_clipped = false;
+                if(!clip_segment(segment.start, segment.end, rect, start_clipped, end_clipped)){ continue; }
+                if(start_clipped){ segment.start_name = '\0'; }
+                if(end_clipped){ segment.end_name = '\0'; }
+            }
+            segments_.push_back(segment);
+        }
+    }
+
+    template <size_t height_, size_t width_>
+    void Buffer<height_, width_>::draw_segments(){
+        UtilsNameSpace::ScopedTimer timer(UtilsNameSpace::ProfileStage::Rasterization);
+        mark_drawn(segments_extent());
+        if(segments_.size() >= parallel_threshold_ && mode_ == RenderMode::Ascii){
+            draw_tiled();
+            return;
+        }
+        for(const Segment2D& segment : segments_){
+            draw_segment(segment);
+        }
+    }
+
+    template <size_t height_, size_t width_>
+    Tile Buffer<height_, width_>::segments_extent() const{
+        Tile extent{};
+        for(const Segment2D& segment : segments_){
+            Tile area = view_area(segment.view);
+            // Cells are found by truncation in ASCII mode and by rounding rows in braille mode
+            auto rows = [&area](double value){ return static_cast<size_t>(std::clamp(value, static_cast<double>(area.row_begin), static_cast<double>(area.row_end))); };
+            auto cols = [&area](double value){ return static_cast<size_t>(std::clamp(value, static_cast<double>(area.col_begin), static_cast<double>(area.col_end))); };
+            Tile bounds = {rows(std::floor(std::min(segment.start.x, segment.end.x))), rows(std::ceil(std::max(segment.start.x, segment.end.x)) + 1),
+                           cols(std::floor(std::min(segment.start.y, segment.end.y))), cols(std::floor(std::max(segment.start.y, segment.end.y)) + 1)};
+            extent = tile_union(extent, bounds);
+            if(segment.start_name == '\0' || segment.end_name == '\0'){
+                // Cells next to the border are tested against the line beyond a clipped endpoint
+                const Tile& tested = segment.bounds;
+                extent = tile_union(extent, Tile{std::max(tested.row_begin, area.row_begin), std::min(tested.row_end + 1, area.row_end),
+                                                 std::max(tested.col_begin, area.col_begin), std::min(tested.col_end + 1, area.col_end)});
+            }
+        }
+        return extent;
+    }
+
+    template <size_t height_, size_t width_>
+    typename Buffer<height_, width_>::LayerPlanes& Buffer<height_, width_>::active_layer(){
+        return layers_[static_cast<size_t>(layer_)];
+    }
+
+    template <size_t height_, size_t width_>
+    void Buffer<height_, width_>::mark_drawn(const Tile& area){
+        LayerPlanes& planes = active_layer();
+        planes.drawn = tile_union(planes.drawn, area);
+        planes.dirty = tile_union(planes.dirty, area);
+    }
+
+    template <size_t height_, size_t width_>
+    void Buffer<height_, width_>::wipe(LayerPlanes& planes){
+        const Tile& area = planes.drawn;
+        if(tile_empty(area)){ return; }
+        size_t count = area.col_end - area.col_begin;
+        for(size_t x = area.row_begin; x < area.row_end; x++){
+            std::memset(&planes.glyphs[x, area.col_begin], ' ', count);
+            std::memset(&planes.dots[x, area.col_begin], 0, count);
+            std::memset(&planes.attrs[x, area.col_begin], 0, count);
+        }
+        planes.dirty = tile_union(planes.dirty, area);
+        planes.drawn = Tile{};
+    }
+
+    template <size_t height_, size_t width_>
+    void Buffer<height_, width_>::composite() const{
+        Tile area{};
+        for(const LayerPlanes& planes : layers_){
+            area = tile_union(area, planes.dirty);
+            planes.dirty = Tile{};
+        }
+        for(size_t x = area.row_begin; x < area.row_end; x++){
+            for(size_t y = area.col_begin; y < area.col_end; y++){
+                char glyph = ' ';
+                uint8_t dots = 0, attr = 0;
+                for(const LayerPlanes& planes : layers_){
+                    char layer_glyph = planes.glyphs[x, y];
+                    uint8_t layer_dots = planes.dots[x, y];
+                    if(layer_glyph != ' '){ glyph = layer_glyph; }
+                    dots |= layer_dots;
+                    if(layer_glyph != ' ' || layer_dots != 0){ attr = planes.attrs[x, y]; }
+                }
+                buffer_[x, y] = glyph;
+                dots_[x, y] = dots;
+                attrs_[x, y] = attr;
+            }
+        }
+    }
+
+    template <size_t height_, size_t width_>
+    template <Numeric T>
+    void Buffer<height_, width_>::draw_instances(const Polyline<T>& polyline, std::span<const Transform> transforms){
+        segments_.clear();
+        if(polyline.points_count() == 0){ return; }
+        auto start = std::chrono::steady_clock::now();
+        for(const Transform& transform : transforms){
+            prepare_projectors(&transform);
+            project(polyline);
+            for(size_t view = 0; view < view_count(); view++){
+                clip(polyline, view);
+            }
+        }
+        auto projected = std::chrono::steady_clock::now();
+        draw_segments();
+        stage_times_.projection += projected - start;
+        stage_times_.rasterization += std::chrono::steady_clock::now() - projected;
+    }
+
+    template <size_t height_, size_t width_>
+    template <Numeric T>
+    void Buffer<height_, width_>::draw_cached(const Polyline<T>& polyline){
+        if(polyline.points_count() == 0){ return; }
+        if(!view_versions_match(projection_cache_versions_)){
+            projection_cache_.clear();
+            store_view_versions(projection_cache_versions_);
+        }
+        auto start = std::chrono::steady_clock::now();
+        ProjectionCacheEntry& entry = projection_cache_[polyline.id()];
+        entry.last_used = frame_;
+        if(entry.valid && entry.version == polyline.version()){
+            projection_cache_hits_++;
+            auto replay_start = std::chrono::steady_clock::now();
+            if(entry.rasterized){
+                mark_drawn(entry.extent);
+                LayerPlanes& planes = active_layer();
+                char* glyphs = planes.glyphs.begin();
+                uint8_t* dots = planes.dots.begin();
+                uint8_t* attrs = planes.attrs.begin();
+                for(const RasterOp& op : entry.cells){
+                    if(op.glyph != '\0'){ glyphs[op.cell] = op.glyph; }
+                    dots[op.cell] |= op.dots;
+                    attrs[op.cell] = attr_;
+                }
+            }
+            else{
+                segments_.swap(entry.segments);
+                draw_segments();
+                segments_.swap(entry.segments);
+            }
+            stage_times_.projection += replay_start - start;
+            stage_times_.rasterization += std::chrono::steady_clock::now() - replay_start;
+            return;
+        }
+        segments_.clear();
+        prepare_projectors(nullptr);
+        project(polyline);
+        for(size_t view = 0; view < view_count(); view++){
+            clip(polyline, view);
+        }
+        entry.version = polyline.version();
+        entry.valid = true;
+        entry.segments.clear();
+        entry.cells.clear();
+        entry.extent = segments_extent();
+        auto projected = std::chrono::steady_clock::now();
+        entry.rasterized = segments_.size() < parallel_threshold_ || mode_ != RenderMode::Ascii;
+        if(entry.rasterized){ raster_log_ = &entry.cells; }
+        draw_segments();
+        raster_log_ = nullptr;
+        if(!entry.rasterized){ segments_.swap(entry.segments); }
+        stage_times_.projection += projected - start;
+        stage_times_.rasterization += std::chrono::steady_clock::now() - projected;
+    }
+
+    template <size_t height_, size_t width_>
+    size_t Buffer<height_, width_>::cached_projections() const{
+        return projection_cache_.size();
+    }
+
+    template <size_t height_, size_t width_>
+    size_t Buffer<height_, width_>::projection_cache_hits() const{
+        return projection_cache_hits_;
+    }
+
+    template <size_t height_, size_t width_>
+    template <Numeric T>
+    void Buffer<height_, width_>::fill(const Polyline<T>& polyline, const FillStyle& style){
+        if(polyline.points_count() < 3){ return; }
+        auto start = std::chrono::steady_clock::now();
+        prepare_projectors(nullptr);
+        project(polyline);
+        auto projected = std::chrono::steady_clock::now();
+        size_t size = polyline.points_count();
+        for(size_t view = 0; view < view_count(); view++){
+            fill_scanlines(points_2d_.data() + view * size, size, view_area(view), style);
+        }
+        stage_times_.projection += projected - start;
+        stage_times_.rasterization += std::chrono::steady_clock::now() - projected;
+    }
+
+    template <size_t height_, size_t width_>
+    void Buffer<height_, width_>::fill_scanlines(const BufferPoint* points, size_t size, const Tile& area, const FillStyle& style){
+        bool braille = mode_ == RenderMode::Braille;
+        const long long sample_rows = braille ? braille_rows : 1, sample_cols = braille ? braille_cols : 1;
+        const long long row_first = static_cast<long long>(area.row_begin) * sample_rows;
+        const long long row_count = static_cast<long long>(area.row_end) * sample_rows;
+        const long long col_first = static_cast<long long>(area.col_begin) * sample_cols;
+        const long long col_count = static_cast<long long>(area.col_end) * sample_cols;
+        // Sample row r is centered at x = (r + 0.5) / sample_rows - 0.5 and sample column c
+        // at y = (c + 0.5) / sample_cols, matching the cells lines are drawn into
+        auto first_row_at = [sample_rows](double x){ return static_cast<long long>(std::ceil((x + 0.5) * sample_rows - 0.5)); };
+        auto first_col_at = [sample_cols](double y){ return static_cast<long long>(std::ceil(y * sample_cols - 0.5)); };
+
+        scan_edges_.clear();
+        for(size_t i = 0; i < size; i++){
+            BufferPoint top = points[i], bottom = points[(i + 1) % size];
+            if(!std::isfinite(top.x) || !std::isfinite(top.y) || !std::isfinite(bottom.x) || !std::isfinite(bottom.y)){ return; }
+            int winding = 1;
+            if(top.x > bottom.x){
+                std::swap(top, bottom);
+                winding = -1;
+            }
+            long long row_begin = std::max(first_row_at(top.x), row_first);
+            long long row_end = std::min(first_row_at(bottom.x), row_count);
+            if(row_begin >= row_end){ continue; }
+            double slope = (bottom.y - top.y) / (bottom.x - top.x);
+            double x = (static_cast<double>(row_begin) + 0.5) / static_cast<double>(sample_rows) - 0.5;
+            scan_edges_.push_back({row_begin, row_end, top.y + (x - top.x) * slope, slope / static_cast<double>(sample_rows), winding});
+        }
+        if(scan_edges_.empty()){ return; }
+        std::sort(scan_edges_.begin(), scan_edges_.end(), [](const ScanEdge& a, const ScanEdge& b){ return a.row_begin < b.row_begin; });
+
+        active_edges_.clear();
+        size_t next_edge = 0;
+        for(long long row = scan_edges_.front().row_begin; row < row_count; row++){
+            std::erase_if(active_edges_, [row](const ScanEdge& edge){ return edge.row_end <= row; });
+            while(next_edge < scan_edges_.size() && scan_edges_[next_edge].row_begin == row){
+                active_edges_.push_back(scan_edges_[next_edge++]);
+            }
+            if(active_edges_.empty()){
+                if(next_edge == scan_edges_.size()){ break; }
+                row = scan_edges_[next_edge].row_begin - 1;
+                continue;
+            }
+            // Crossings move little between rows, so insertion sort is close to linear
+            for(size_t i = 1; i < active_edges_.size(); i++){
+                ScanEdge edge = active_edges_[i];
+                size_t j = i;
+                for(; j > 0 && active_edges_[j - 1].col > edge.col; j--){ active_edges_[j] = active_edges_[j - 1]; }
+                active_edges_[j] = edge;
+            }
+            int winding = 0;
+            for(size_t i = 0; i + 1 < active_edges_.size(); i++){
+                winding += style.rule == FillRule::EvenOdd ? 1 : active_edges_[i].winding;
+                bool inside = style.rule == FillRule::EvenOdd ? (winding & 1) != 0 : winding != 0;
+                if(!inside){ continue; }
+                long long col_begin = std::max(first_col_at(active_edges_[i].col), col_first);
+                long long col_end = std::min(first_col_at(active_edges_[i + 1].col), col_count);
+                if(col_begin < col_end){ fill_span(row, col_begin, col_end, style.glyph); }
+            }
+            for(ScanEdge& edge : active_edges_){ edge.col += edge.step; }
+        }
+    }
+
+    template <size_t height_, size_t width_>
+    void Buffer<height_, width_>::fill_span(long long row, long long col_begin, long long col_end, char glyph){
+        LayerPlanes& planes = active_layer();
+        if(mode_ == RenderMode::Ascii){
+            size_t x = static_cast<size_t>(row), y = static_cast<size_t>(col_begin), count = static_cast<size_t>(col_end - col_begin);
+            mark_drawn(Tile{x, x + 1, y, y + count});
+            std::memset(&planes.glyphs[x, y], glyph, count);
+            std::memset(&planes.attrs[x, y], attr_, count);
+            return;
+        }
+        size_t x = static_cast<size_t>(row / braille_rows), dot_row = static_cast<size_t>(row % braille_rows);
+        mark_drawn(Tile{x, x + 1, static_cast<size_t>(col_begin / braille_cols), static_cast<size_t>((col_end - 1) / braille_cols) + 1});
+        for(long long col = col_begin; col < col_end; col++){
+            size_t y = static_cast<size_t>(col / braille_cols);
+            planes.dots[x, y] |= braille_bit(dot_row, static_cast<size_t>(col % braille_cols));
+            planes.attrs[x, y] = attr_;
+        }
+    }
+
+    template <size_t height_, size_t width_>
+    const StageTimes& Buffer<height_, width_>::stage_times() const{
+        return stage_times_;
+    }
+
+    template <size_t height_, size_t width_>
+    void Buffer<height_, width_>::reset_stage_times(){
+        stage_times_ = StageTimes{};
     }
 
     template<size_t height_, size_t width_>
     double Buffer<height_, width_>::distance_to_the_line(const BufferPoint& point, const BufferPoint& start_line, const BufferPoint& end_line){
+        UtilsNameSpace::Profiler::count(UtilsNameSpace::ProfileCounter::DistanceTests);
         double numerator = std::abs((end_line.x - start_line.x)*(start_line.y - point.y) - (start_line.x - point.x)*(end_line.y - start_line.y));
         double denominator = std::sqrt((end_line.x - start_line.x)*(end_line.x - start_line.x) + (end_line.y - start_line.y)*(end_line.y - start_line.y));
         return numerator / denominator;
     }
 
     template<size_t height_, size_t width_>
-    template <Numeric T>
-    void Buffer<height_, width_>::draw_line(const Point<T>& point1, const Point<T>& point2){
-        BufferPoint point_2d_1 = get_point_2d(point1);
-        BufferPoint point_2d_2 = get_point_2d(point2);
-        if(point_2d_1.x < height_ && point_2d_1.x >= 0 && point_2d_1.y < width_ && point_2d_1.y >= 0){
-            buffer_[point_2d_1.x, point_2d_1.y] = point1.name_;
-        }
-        if(point_2d_2.x < height_ && point_2d_2.x >= 0 && point_2d_2.y < width_ && point_2d_2.y >= 0){
-            buffer_[point_2d_2.x, point_2d_2.y] = point2.name_;
-        }
-        size_t min_x = std::min(std::max(std::min(point_2d_1.x, point_2d_2.x), static_cast<double>(0)), static_cast<double>(height_-1));
-        size_t min_y = std::min(std::max(std::min(point_2d_1.y, point_2d_2.y), static_cast<double>(0)), static_cast<double>(width_-1));
-        size_t max_x = std::max(std::min(std::max(point_2d_1.x, point_2d_2.x), static_cast<double>(height_-1)), static_cast<double>(0));
-        size_t max_y = std::max(std::min(std::max(point_2d_1.y, point_2d_2.y), static_cast<double>(width_-1)), static_cast<double>(0));
+    void Buffer<height_, width_>::draw_segment(const Segment2D& segment){
+        if(mode_ == RenderMode::Braille){
+            draw_braille_segment(segment.start, segment.start_name, segment.end, segment.end_name, view_area(segment.view));
+            return;
+        }
+        rasterize_segment(segment, view_area(segment.view));
+    }
+
+    template<size_t height_, size_t width_>
+    Tile Buffer<height_, width_>::segment_bounds(const BufferPoint& point1, const BufferPoint& point2) const{
+        return Tile{
+            static_cast<size_t>(std::min(std::max(std::min(point1.x, point2.x), static_cast<double>(0)), static_cast<double>(height_-1))),
+            static_cast<size_t>(std::max(std::min(std::max(point1.x, point2.x), static_cast<double>(height_-1)), static_cast<double>(0))),
+            static_cast<size_t>(std::min(std::max(std::min(point1.y, point2.y), static_cast<double>(0)), static_cast<double>(width_-1))),
+            static_cast<size_t>(std::max(std::min(std::max(point1.y, point2.y), static_cast<double>(width_-1)), static_cast<double>(0)))
+        };
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::rasterize_segment(const Segment2D& segment, const Tile& tile){
+        const BufferPoint& point1 = segment.start;
+        const BufferPoint& point2 = segment.end;
+        char name1 = segment.start_name, name2 = segment.end_name;
+        auto inside = [&tile](const BufferPoint& point){
+            return point.x < tile.row_end && point.x >= tile.row_begin && point.y < tile.col_end && point.y >= tile.col_begin;
+        };
+        bool label1 = name1 != '\0' && inside(point1), label2 = name2 != '\0' && inside(point2);
+        if(label1){ put(point1.x, point1.y, name1); }
+        if(label2){ put(point2.x, point2.y, name2); }
+        // The line never overwrites the labels; the cell of an endpoint without one,
+        // like the one where a clipped segment leaves the buffer, is drawn as usual
+        size_t label1_x = label1 ? static_cast<size_t>(point1.x) : height_, label1_y = label1 ? static_cast<size_t>(point1.y) : width_;
+        size_t label2_x = label2 ? static_cast<size_t>(point2.x) : height_, label2_y = label2 ? static_cast<size_t>(point2.y) : width_;
+        auto labelled = [label1_x, label1_y, label2_x, label2_y](size_t x, size_t y){
+            return (x == label1_x && y == label1_y) || (x == label2_x && y == label2_y);
+        };
+        size_t min_x = segment.bounds.row_begin, max_x = segment.bounds.row_end;
+        size_t min_y = segment.bounds.col_begin, max_y = segment.bounds.col_end;
+        size_t first_x = std::max(min_x, tile.row_begin);
+        size_t last_x = std::min(max_x + 1, tile.row_end);
         if(min_y == max_y){
-            for(size_t x = min_x+1; x < max_x; x++){
-                buffer_[x, min_y] = '-';
+            if(min_y < tile.col_begin || min_y >= tile.col_end){ return; }
+            uint64_t written = 0;
+            for(size_t x = first_x; x < last_x; x++){
+                if(labelled(x, min_y)){ continue; }
+                put(x, min_y, '-');
+                written++;
             }
+            if(first_x < last_x){ UtilsNameSpace::Profiler::count(UtilsNameSpace::ProfileCounter::CellsTested, last_x - first_x); }
+            UtilsNameSpace::Profiler::count(UtilsNameSpace::ProfileCounter::CellsWritten, written);
             return;
         }
-        for(size_t x = min_x; x <= max_x; x++){
-            for(size_t y = min_y; y <= max_y; y++){
-                if((x == min_x || x == max_x) && (y == min_y || y == max_y)){ continue; }
+        size_t first_y = std::max(min_y, tile.col_begin);
+        size_t last_y = std::min(max_y + 1, tile.col_end);
+        if(first_y >= last_y){ return; }
+        double dx = point2.x - point1.x;
+        double dy = point2.y - point1.y;
+        double half_width = 0.4 * std::sqrt(dx*dx + dy*dy) / std::abs(dx);
+        uint64_t tested = 0, written = 0;
+        for(size_t x = first_x; x < last_x; x++){
+            size_t row_first_y = first_y, row_last_y = last_y;
+            if(dx != 0){
+                // Columns closer than 0.4 to the line form an interval around its center;
+                // one extra cell on each side absorbs rounding, the exact test below decides.
+                double center = (dx * point1.y - (point1.x - static_cast<double>(x)) * dy) / dx;
+                double from = std::floor(center - half_width) - 1;
+                double to = std::ceil(center + half_width) + 2;
+                row_first_y = static_cast<size_t>(std::clamp(from, static_cast<double>(first_y), static_cast<double>(last_y)));
+                row_last_y = static_cast<size_t>(std::clamp(to, static_cast<double>(first_y), static_cast<double>(last_y)));
+            }
+            tested += row_last_y - row_first_y;
+            for(size_t y = row_first_y; y < row_last_y; y++){
+                if(labelled(x, y)){ continue; }
                 BufferPoint current = {static_cast<double>(x), static_cast<double>(y)};
-                if(distance_to_the_line(current, point_2d_1, point_2d_2) < 0.4){
-                    buffer_[x, y] = '-';
+                if(distance_to_the_line(current, point1, point2) < 0.4){
+                    put(x, y, '-');
+                    written++;
                 }
             }
         }
+        UtilsNameSpace::Profiler::count(UtilsNameSpace::ProfileCounter::CellsTested, tested);
+        UtilsNameSpace::Profiler::count(UtilsNameSpace::ProfileCounter::CellsWritten, written);
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::draw_braille_segment(const BufferPoint& point1, char name1, const BufferPoint& point2, char name2, const Tile& area){
+        const long long dot_row_begin = static_cast<long long>(area.row_begin * braille_rows);
+        const long long dot_height = static_cast<long long>(area.row_end * braille_rows);
+        const long long dot_col_begin = static_cast<long long>(area.col_begin * braille_cols);
+        const long long dot_width = static_cast<long long>(area.col_end * braille_cols);
+        LayerPlanes& planes = active_layer();
+        // Cell x covers rows [x - 0.5, x + 0.5) because ASCII mode rounds x, y is truncated
+        long long row = std::llround(std::floor((point1.x + 0.5) * braille_rows));
+        long long col = std::llround(std::floor(point1.y * braille_cols));
+        long long row_end = std::llround(std::floor((point2.x + 0.5) * braille_rows));
+        long long col_end = std::llround(std::floor(point2.y * braille_cols));
+        auto set_label = [this, dot_row_begin, dot_height, dot_col_begin, dot_width](long long dot_row, long long dot_col, char name){
+            if(name != '\0' && dot_row >= dot_row_begin && dot_row < dot_height && dot_col >= dot_col_begin && dot_col < dot_width){
+                put(dot_row / braille_rows, dot_col / braille_cols, name);
+            }
+        };
+        set_label(row, col, name1);
+        set_label(row_end, col_end, name2);
+        long long d_row = std::abs(row_end - row), d_col = -std::abs(col_end - col);
+        long long step_row = row < row_end ? 1 : -1, step_col = col < col_end ? 1 : -1;
+        long long error = d_row + d_col;
+        uint64_t tested = 0, written = 0;
+        while(true){
+            tested++;
+            if(row >= dot_row_begin && row < dot_height && col >= dot_col_begin && col < dot_width){
+                written++;
+                size_t x = static_cast<size_t>(row / braille_rows), y = static_cast<size_t>(col / braille_cols);
+                uint8_t bit = braille_bit(static_cast<size_t>(row % braille_rows), static_cast<size_t>(col % braille_cols));
+                planes.dots[x, y] |= bit;
+                planes.attrs[x, y] = attr_;
+                if(raster_log_){ raster_log_->push_back({static_cast<uint32_t>(x * width_ + y), '\0', bit}); }
+            }
+            if(row == row_end && col == col_end){ break; }
+            long long doubled = 2 * error;
+            if(doubled >= d_col){ error += d_col; row += step_row; }
+            if(doubled <= d_row){ error += d_row; col += step_col; }
+        }
+        UtilsNameSpace::Profiler::count(UtilsNameSpace::ProfileCounter::CellsTested, tested);
+        UtilsNameSpace::Profiler::count(UtilsNameSpace::ProfileCounter::CellsWritten, written);
+    }
+
+    template<size_t height_, size_t width_>
+    UtilsNameSpace::ThreadPool& Buffer<height_, width_>::get_pool(){
+        if(!pool_){ pool_ = std::make_unique<UtilsNameSpace::ThreadPool>(); }
+        return *pool_;
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::draw_tiled(){
+        size_t size = segments_.size();
+        auto for_each_tile = [this](size_t segment, auto&& func){
+            const Tile& bounds = segments_[segment].bounds;
+            for(size_t row = bounds.row_begin / tile_height_; row <= bounds.row_end / tile_height_; row++){
+                for(size_t col = bounds.col_begin / tile_width_; col <= bounds.col_end / tile_width_; col++){
+                    func(row * tile_cols_ + col);
+                }
+            }
+        };
+        tile_offsets_.assign(tile_rows_ * tile_cols_ + 1, 0);
+        for(size_t i = 0; i < size; i++){
+            for_each_tile(i, [this](size_t tile){ tile_offsets_[tile + 1]++; });
+        }
+        std::partial_sum(tile_offsets_.begin(), tile_offsets_.end(), tile_offsets_.begin());
+        tile_segments_.resize(tile_offsets_.back());
+        std::vector<size_t> fill_positions(tile_offsets_.begin(), tile_offsets_.end() - 1);
+        for(size_t i = 0; i < size; i++){
+            for_each_tile(i, [this, &fill_positions, i](size_t tile){ tile_segments_[fill_positions[tile]++] = i; });
+        }
+
+        get_pool().parallel_for(tile_rows_ * tile_cols_, [this](size_t tile_index){
+            size_t row = tile_index / tile_cols_, col = tile_index % tile_cols_;
+            Tile tile = {row * tile_height_, std::min((row + 1) * tile_height_, height_), col * tile_width_, std::min((col + 1) * tile_width_, width_)};
+            for(size_t k = tile_offsets_[tile_index]; k < tile_offsets_[tile_index + 1]; k++){
+                const Segment2D& segment = segments_[tile_segments_[k]];
+                Tile area = view_area(segment.view);
+                Tile clipped = {std::max(tile.row_begin, area.row_begin), std::min(tile.row_end, area.row_end),
+                                std::max(tile.col_begin, area.col_begin), std::min(tile.col_end, area.col_end)};
+                if(clipped.row_begin >= clipped.row_end || clipped.col_begin >= clipped.col_end){ continue; }
+                rasterize_segment(segment, clipped);
+            }
+        });
     }
 
     template<size_t height_, size_t width_>
     void Buffer<height_, width_>::draw_axes(){
         Point<int> O = {0, 0, 0, 'O'};
-        Point<int> X = {height_-1, 0, 0, 'X'};
-        Point<int> Y = {0, height_-1, 0, 'Y'};
-        Point<int> Z = {0, 0, height_-1, 'Z'};
-        draw_line(O, X);
-        draw_line(O, Y);
-        draw_line(O, Z);
+        for(size_t view = 0; view < view_count(); view++){
+            Tile area = view_area(view);
+            int length = static_cast<int>(area.row_end - area.row_begin) - 1;
+            Point<int> ends[3] = {{length, 0, 0, 'X'}, {0, length, 0, 'Y'}, {0, 0, length, 'Z'}};
+            for(const Point<int>& end : ends){
+                Polyline<int> axis;
+                axis.add_point(O);
+                axis.add_point(end);
+                segments_.clear();
+                prepare_projectors(nullptr);
+                project(axis);
+                clip(axis, view);
+                draw_segments();
+            }
+        }
     }
 
     template<size_t height_, size_t width_>
     Buffer<height_, width_>::Buffer(){
+        for(LayerPlanes& planes : layers_){ planes.glyphs.fill(' '); }
         clean_buffer();
     }
 
     template<size_t height_, size_t width_>
-    void Buffer<height_, width_>::clean_buffer(){
-        buffer_.fill(' ');
+    void Buffer<height_, width_>::put(size_t x, size_t y, char glyph){
+        LayerPlanes& planes = active_layer();
+        planes.glyphs[x, y] = glyph;
+        planes.attrs[x, y] = attr_;
+        if(raster_log_){ raster_log_->push_back({static_cast<uint32_t>(x * width_ + y), glyph, 0}); }
+    }
+
+    template<size_t height_, size_t width_>
+    uint8_t Buffer<height_, width_>::palette_index(const Color& color){
+        auto found = std::find(palette_.begin(), palette_.end(), color);
+        if(found != palette_.end()){ return static_cast<uint8_t>(found - palette_.begin()); }
+        if(palette_.size() == 256){
+            // The composited planes are rebuilt from the layers wherever a layer changed,
+            // so an index unused by the layers may be given to another color
+            std::array<bool, 256> used{};
+            used[0] = true;
+            used[attr_] = true;
+            for(const LayerPlanes& planes : layers_){
+                for(uint8_t attr : planes.attrs){ used[attr] = true; }
+            }
+            auto unused = std::find(used.begin(), used.end(), false);
+            if(unused == used.end()){ throw std::length_error("Too many colors in one buffer"); }
+            size_t index = static_cast<size_t>(unused - used.begin());
+            palette_[index] = color;
+            return static_cast<uint8_t>(index);
+        }
+        palette_.push_back(color);
+        return static_cast<uint8_t>(palette_.size() - 1);
+    }
+
+    template<size_t height_, size_t width_>
+    Color Buffer<height_, width_>::cell_color(size_t x, size_t y, bool is_label) const{
+        uint8_t attr = attrs_[x, y];
+        if(attr != 0){ return palette_[attr]; }
+        return is_label ? label_color : line_color;
+    }
+
+    template<size_t height_, size_t width_>
+    bool Buffer<height_, width_>::is_label(char glyph) const{
+        return glyph != '-' || mode_ == RenderMode::Braille;
+    }
+
+    template<size_t height_, size_t width_>
+    template <typename Visit>
+    void Buffer<height_, width_>::visit_cell(size_t x, size_t y, Visit&& visit) const{
+        char glyph = buffer_[x, y];
+        if(mode_ == RenderMode::Braille && glyph == ' ' && dots_[x, y] != 0){
+            visit(braille_char(dots_[x, y]), true, false);
+            return;
+        }
+        visit(glyph, glyph != ' ', glyph != ' ' && is_label(glyph));
+    }
+
+    template<size_t height_, size_t width_>
+    FrameCell Buffer<height_, width_>::frame_cell(size_t x, size_t y) const{
+        FrameCell cell;
+        visit_cell(x, y, [this, x, y, &cell](auto text, bool visible, bool label){
+            if constexpr(std::is_same_v<decltype(text), char>){ cell.text[0] = text; }
+            else{
+                std::copy(text.begin(), text.end(), cell.text.begin());
+                cell.size = static_cast<uint8_t>(text.size());
+            }
+            if(visible){ cell.color = cell_color(x, y, label); }
+        });
+        return cell;
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::cells(std::vector<FrameCell>& out) const{
+        composite();
+        out.resize(height_ * width_);
+        for(size_t x = 0; x < height_; x++){
+            for(size_t y = 0; y < width_; y++){
+                out[x * width_ + y] = frame_cell(x, y);
+            }
+        }
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::encode(std::string& out, FrameFormat format) const{
+        UtilsNameSpace::ScopedTimer timer(UtilsNameSpace::ProfileStage::Encode);
+        composite();
+        switch(format){
+            case FrameFormat::Ansi: encode_text(out, true); break;
+            case FrameFormat::Plain: encode_text(out, false); break;
+            case FrameFormat::Pgm: encode_bitmap(out, false); break;
+            case FrameFormat::Ppm: encode_bitmap(out, true); break;
+        }
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::encode_text(std::string& out, bool colored) const{
+        out.reserve(out.size() + height_ * (width_ * 4 + reset_escape.size() + 1));
+        for(size_t x = 0; x < height_; x++){
+            Color current = Color::automatic();
+            auto switch_color = [&out, &current, colored](const Color& color){
+                if(!colored || color == current){ return; }
+                color.append_escape(out);
+                current = color;
+            };
+            for(size_t y = 0; y < width_; y++){
+                visit_cell(x, y, [this, x, y, &out, &switch_color](auto text, bool visible, bool label){
+                    if(visible){ switch_color(cell_color(x, y, label)); }
+                    out += text;
+                });
+            }
+            if(current != Color::automatic()){ out += reset_escape; }
+            out += '\n';
+        }
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::encode_bitmap(std::string& out, bool colored) const{
+        bool braille = mode_ == RenderMode::Braille;
+        size_t cell_height = braille ? braille_rows : 1, cell_width = braille ? braille_cols : 1;
+        size_t channels = colored ? 3 : 1;
+        std::string header = (colored ? "P6\n" : "P5\n") + std::to_string(width_ * cell_width) + " " + std::to_string(height_ * cell_height) + "\n255\n";
+        size_t start = out.size() + header.size();
+        out += header;
+        out.resize(start + height_ * cell_height * width_ * cell_width * channels, '\0');
+        char* pixels = out.data() + start;
+        for(size_t x = 0; x < height_; x++){
+            for(size_t y = 0; y < width_; y++){
+                char glyph = buffer_[x, y];
+                uint8_t mask = braille ? (glyph != ' ' ? 0xFF : dots_[x, y]) : (glyph != ' ' ? 0x01 : 0x00);
+                if(mask == 0){ continue; }
+                Color color = cell_color(x, y, glyph != ' ' && is_label(glyph)).to_rgb();
+                for(size_t row = 0; row < cell_height; row++){
+                    for(size_t col = 0; col < cell_width; col++){
+                        if(braille && !(mask & braille_bit(row, col))){ continue; }
+                        char* pixel = pixels + ((x * cell_height + row) * width_ * cell_width + y * cell_width + col) * channels;
+                        if(colored){
+                            pixel[0] = static_cast<char>(color.red);
+                            pixel[1] = static_cast<char>(color.green);
+                            pixel[2] = static_cast<char>(color.blue);
+                        }
+                        else{
+                            pixel[0] = static_cast<char>(255);
+                        }
+                    }
+                }
+            }
+        }
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::rebuild_background(){
+        LayerPlanes& background = layers_[static_cast<size_t>(Layer::Background)];
+        background.glyphs.fill(' ');
+        background.dots.fill(0);
+        background.attrs.fill(0);
+        background.drawn = Tile{};
+        background.dirty = Tile{0, height_, 0, width_};
+        uint8_t attr = attr_;
+        Layer layer = layer_;
+        attr_ = 0;
+        layer_ = Layer::Background;
         draw_axes();
+        for(const Polyline<double>& polyline : background_lines_){
+            *this << polyline;
+        }
+        attr_ = attr;
+        layer_ = layer;
+        background_valid_ = true;
+        store_view_versions(background_versions_);
+        background_mode_ = mode_;
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::store_view_versions(std::vector<size_t>& versions) const{
+        versions.assign(1, camera_.version());
+        for(const Viewport& viewport : viewports_){ versions.push_back(viewport.camera.version()); }
+    }
+
+    template<size_t height_, size_t width_>
+    bool Buffer<height_, width_>::view_versions_match(const std::vector<size_t>& versions) const{
+        if(versions.size() != viewports_.size() + 1 || versions[0] != camera_.version()){ return false; }
+        for(size_t i = 0; i < viewports_.size(); i++){
+            if(versions[i + 1] != viewports_[i].camera.version()){ return false; }
+        }
+        return true;
+    }
+
+    template<size_t height_, size_t width_>
+    bool Buffer<height_, width_>::background_stale() const{
+        return !background_valid_ || background_mode_ != mode_ || !view_versions_match(background_versions_);
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::start_frame(){
+        frame_++;
+        if(frame_ % cache_lifetime_ == 0){
+            std::erase_if(projection_cache_, [this](const auto& item){ return item.second.last_used + cache_lifetime_ < frame_; });
+        }
+        if(background_stale()){ rebuild_background(); }
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::clean_buffer(){
+        start_frame();
+        static_valid_ = false;
+        for(size_t layer = static_cast<size_t>(Layer::Background) + 1; layer < layer_count; layer++){
+            wipe(layers_[layer]);
+        }
+    }
+
+    template<size_t height_, size_t width_>
+    bool Buffer<height_, width_>::clean_dynamic(){
+        bool stale = !static_valid_ || static_mode_ != mode_ || !view_versions_match(static_versions_);
+        start_frame();
+        for(size_t layer = static_cast<size_t>(Layer::Background) + 1; layer < layer_count; layer++){
+            if(layer != static_cast<size_t>(Layer::Static) || stale){ wipe(layers_[layer]); }
+        }
+        if(stale){
+            static_valid_ = true;
+            store_view_versions(static_versions_);
+            static_mode_ = mode_;
+        }
+        return stale;
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::clear_layer(Layer layer){
+        if(layer == Layer::Background){ throw std::invalid_argument("The background layer is cleared with clear_background"); }
+        if(layer == Layer::Static){ static_valid_ = false; }
+        wipe(layers_[static_cast<size_t>(layer)]);
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::add_background(Polyline<double> polyline){
+        background_lines_.push_back(std::move(polyline));
+        background_valid_ = false;
+        clean_buffer();
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::clear_background(){
+        background_lines_.clear();
+        background_valid_ = false;
+        clean_buffer();
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::set_mode(RenderMode mode){
+        mode_ = mode;
+        projection_cache_.clear();
+        clean_buffer();
+    }
+
+    template<size_t height_, size_t width_>
+    RenderMode Buffer<height_, width_>::get_mode() const{
+        return mode_;
+    }
+
+    template<size_t height_, size_t width_>
+    Camera& Buffer<height_, width_>::camera(){
+        return camera_;
+    }
+
+    template<size_t height_, size_t width_>
+    const Camera& Buffer<height_, width_>::camera() const{
+        return camera_;
+    }
+
+    template<size_t height_, size_t width_>
+    void Buffer<height_, width_>::set_viewports(std::vector<Viewport> viewports){
+        if(viewports.size() > max_viewports_){ throw std::length_error("Too many viewports"); }
+        for(const Viewport& viewport : viewports){
+            const Tile& area = viewport.area;
+            if(area.row_begin >= area.row_end || area.col_begin >= area.col_end || area.row_end > height_ || area.col_end > width_){
+                throw std::invalid_argument("Viewport must be a non-empty rectangle inside the buffer");
+            }
+        }
+        viewports_ = std::move(viewports);
+        background_valid_ = false;
+        projection_cache_.clear();
+        clean_buffer();
+    }
+
+    template<size_t height_, size_t width_>
+    const std::vector<Viewport>& Buffer<height_, width_>::viewports() const{
+        return viewports_;
+    }
+
+    template<size_t height_, size_t width_>
+    Camera& Buffer<height_, width_>::viewport_camera(size_t index){
+        return viewports_.at(index).camera;
     }
 }
 
-#endif
\ No newline at end of file
+#endif
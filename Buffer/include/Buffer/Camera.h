@@ -0,0 +1,294 @@
+/**
+ * @file Camera.h
+ * @brief Camera with orthographic and perspective projection for Buffer rendering
+ * @author Chesnokov Alexandr
+ * @date 2025
+ * @version 1.0
+ *
+ * This header defines a Camera class that turns zoom, pan, orbit angles and the
+ * projection type into a single 4x3 projection matrix. The default camera reproduces
+ * the isometric view Buffer has always used.
+ */
+
+#ifndef CAMERA_H
+#define CAMERA_H
+
+#include <Matrix/Matrix.h>
+#include <atomic>
+#include <cstddef>
+#include <cmath>
+#include <numbers>
+#include <stdexcept>
+
+namespace BufferNameSpace {
+    using namespace MatrixNameSpace;
+
+    /**
+     * @enum Projection
+     * @brief Projection type of a Camera
+     */
+    enum class Projection{
+        Orthographic, ///< Parallel projection, no foreshortening
+        Perspective   ///< Central projection from an eye at distance() from the origin
+    };
+
+    /**
+     * @enum View
+     * @brief Direction a Camera looks at the scene from before orbiting
+     */
+    enum class View{
+        Isometric, ///< Classic isometric view of all three axes
+        Top,       ///< Looking down the Z axis: X to the right, Y up
+        Front,     ///< Looking along the Y axis: X to the right, Z up
+        Side       ///< Looking against the X axis: Y to the right, Z up
+    };
+
+    /**
+     * @brief Returns a new process-wide unique camera version
+     * @return size_t Version, never 0
+     *
+     * Versions are unique across all cameras, so a camera copied from another
+     * Buffer (see RenderThread) never matches a stale version by accident.
+     */
+    inline size_t next_camera_version(){
+        static std::atomic<size_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    /**
+     * @class Camera
+     * @brief View parameters of a Buffer precomputed into one projection matrix
+     *
+     * A 3D point is projected as [x, y, z, 1] * matrix() = [row, col, w], followed by
+     * division by w. The resulting coordinates are relative to the anchor of the
+     * viewport (the origin is drawn at the anchor when pan is zero).
+     *
+     * Every mutating method rebuilds the matrix and bumps version(), so renderers can
+     * cache anything derived from the camera.
+     */
+    class Camera{
+    private:
+        View view_ = View::Isometric; ///< Base view direction
+        Projection projection_ = Projection::Orthographic; ///< Projection type
+        double zoom_ = 1.0; ///< Scale factor applied to screen coordinates
+        double pan_row_ = 0; ///< Vertical shift of the image in characters
+        double pan_col_ = 0; ///< Horizontal shift of the image in characters
+        double yaw_ = 0; ///< Orbit angle around the vertical Z axis in degrees
+        double pitch_ = 0; ///< Orbit angle around the horizontal screen axis in degrees
+        double distance_ = 150; ///< Distance from the origin to the eye for perspective projection
+        size_t version_ = 0; ///< Replaced by next_camera_version() on every change of the camera
+        Matrix<double, 4, 3> matrix_{}; ///< Cached projection matrix
+
+        /**
+         * @brief Rebuilds the projection matrix and bumps the version
+         */
+        void update();
+
+    public:
+        /**
+         * @brief Constructor
+         * @param view Base view direction
+         *
+         * The default is the classic isometric camera:
+         * row = (x + y) / sqrt(15) - z * 0.6, col = y - x.
+         * The axis-aligned views map one world unit to one column and half a row,
+         * since a character is about twice as tall as it is wide.
+         */
+        explicit Camera(View view = View::Isometric);
+
+        /**
+         * @brief Restores zoom, pan, orbit and projection, keeping the base view
+         */
+        void reset();
+
+        /**
+         * @brief Set the base view direction
+         * @param view New base view
+         */
+        void set_view(View view);
+
+        /**
+         * @brief Set the projection type
+         * @param projection Orthographic or perspective projection
+         */
+        void set_projection(Projection projection);
+
+        /**
+         * @brief Multiply the current zoom
+         * @param factor Zoom factor (> 1 zooms in, < 1 zooms out)
+         * @throws std::invalid_argument if factor is not positive
+         */
+        void zoom(double factor);
+
+        /**
+         * @brief Shift the image on the screen
+         * @param rows Shift down in characters
+         * @param cols Shift right in characters
+         */
+        void pan(double rows, double cols);
+
+        /**
+         * @brief Orbit the camera around the origin
+         * @param yaw_degree Rotation around the vertical Z axis in degrees
+         * @param pitch_degree Rotation around the horizontal screen axis in degrees
+         */
+        void orbit(double yaw_degree, double pitch_degree);
+
+        /**
+         * @brief Set the eye distance used by the perspective projection
+         * @param distance Distance from the origin to the eye
+         * @throws std::invalid_argument if distance is not positive
+         */
+        void set_distance(double distance);
+
+        View get_view() const; ///< Returns the base view direction
+        Projection get_projection() const; ///< Returns the projection type
+        double get_zoom() const; ///< Returns the current zoom factor
+        double get_distance() const; ///< Returns the perspective eye distance
+        size_t version() const; ///< Returns the change counter of the camera
+
+        /**
+         * @brief Get the projection matrix
+         * @return Const reference to the 4x3 matrix mapping [x, y, z, 1] to [row, col, w]
+         */
+        const Matrix<double, 4, 3>& matrix() const;
+    };
+
+    /****************Realization****************/
+    inline Camera::Camera(View view) : view_(view){
+        update();
+    }
+
+    inline void Camera::update(){
+        const double k = 1 / std::sqrt(15);
+        // Screen axes of the base view and the direction towards the viewer
+        double row_axis[3] = {k, k, -0.6};
+        double col_axis[3] = {-1, 1, 0};
+        // Unit vector along the column axis, the axis of pitch rotation
+        double pitch_axis[3] = {-std::numbers::sqrt2_v<double> / 2, std::numbers::sqrt2_v<double> / 2, 0};
+        if(view_ == View::Top){
+            row_axis[0] = 0; row_axis[1] = -0.5; row_axis[2] = 0;
+            col_axis[0] = 1; col_axis[1] = 0; col_axis[2] = 0;
+            pitch_axis[0] = 1; pitch_axis[1] = 0; pitch_axis[2] = 0;
+        }
+        else if(view_ == View::Front){
+            row_axis[0] = 0; row_axis[1] = 0; row_axis[2] = -0.5;
+            col_axis[0] = 1; col_axis[1] = 0; col_axis[2] = 0;
+            pitch_axis[0] = 1; pitch_axis[1] = 0; pitch_axis[2] = 0;
+        }
+        else if(view_ == View::Side){
+            row_axis[0] = 0; row_axis[1] = 0; row_axis[2] = -0.5;
+            col_axis[0] = 0; col_axis[1] = 1; col_axis[2] = 0;
+            pitch_axis[0] = 0; pitch_axis[1] = 1; pitch_axis[2] = 0;
+        }
+        double view_axis[3] = {
+            row_axis[1] * col_axis[2] - row_axis[2] * col_axis[1],
+            row_axis[2] * col_axis[0] - row_axis[0] * col_axis[2],
+            row_axis[0] * col_axis[1] - row_axis[1] * col_axis[0]
+        };
+        double view_len = std::sqrt(view_axis[0]*view_axis[0] + view_axis[1]*view_axis[1] + view_axis[2]*view_axis[2]);
+        double depth = projection_ == Projection::Perspective ? -1 / (view_len * distance_) : 0;
+        Matrix<double, 3, 3> axes = {
+            row_axis[0] * zoom_, col_axis[0] * zoom_, view_axis[0] * depth,
+            row_axis[1] * zoom_, col_axis[1] * zoom_, view_axis[1] * depth,
+            row_axis[2] * zoom_, col_axis[2] * zoom_, view_axis[2] * depth
+        };
+
+        double yaw = yaw_ * std::numbers::pi_v<double> / 180.0;
+        Matrix<double, 3, 3> yaw_matrix = {
+            std::cos(yaw), std::sin(yaw), 0,
+            (-1) * std::sin(yaw), std::cos(yaw), 0,
+            0, 0, 1
+        };
+        // Rodrigues' rotation around the horizontal screen axis
+        double pitch = pitch_ * std::numbers::pi_v<double> / 180.0;
+        double u = pitch_axis[0], v = pitch_axis[1], n = pitch_axis[2];
+        double c = std::cos(pitch), s = std::sin(pitch), t = 1 - c;
+        Matrix<double, 3, 3> pitch_matrix = {
+            t*u*u + c,    t*u*v + s*n,  t*u*n - s*v,
+            t*u*v - s*n,  t*v*v + c,    t*v*n + s*u,
+            t*u*n + s*v,  t*v*n - s*u,  t*n*n + c
+        };
+        Matrix<double, 3, 3> linear = yaw_matrix * pitch_matrix * axes;
+
+        for(size_t i = 0; i < 3; i++){
+            double w = linear[i, 2];
+            matrix_[i, 0] = linear[i, 0] + pan_row_ * w;
+            matrix_[i, 1] = linear[i, 1] + pan_col_ * w;
+            matrix_[i, 2] = w;
+        }
+        matrix_[3, 0] = pan_row_;
+        matrix_[3, 1] = pan_col_;
+        matrix_[3, 2] = 1;
+        version_ = next_camera_version();
+    }
+
+    inline void Camera::reset(){
+        projection_ = Projection::Orthographic;
+        zoom_ = 1.0;
+        pan_row_ = pan_col_ = 0;
+        yaw_ = pitch_ = 0;
+        distance_ = 150;
+        update();
+    }
+
+    inline void Camera::set_view(View view){
+        view_ = view;
+        update();
+    }
+
+    inline void Camera::set_projection(Projection projection){
+        projection_ = projection;
+        update();
+    }
+
+    inline void Camera::zoom(double factor){
+        if(!(factor > 0)){ throw std::invalid_argument("Zoom factor must be positive"); }
+        zoom_ *= factor;
+        update();
+    }
+
+    inline void Camera::pan(double rows, double cols){
+        pan_row_ += rows;
+        pan_col_ += cols;
+        update();
+    }
+
+    inline void Camera::orbit(double yaw_degree, double pitch_degree){
+        yaw_ += yaw_degree;
+        pitch_ += pitch_degree;
+        update();
+    }
+
+    inline void Camera::set_distance(double distance){
+        if(!(distance > 0)){ throw std::invalid_argument("Camera distance must be positive"); }
+        distance_ = distance;
+        update();
+    }
+
+    inline View Camera::get_view() const{
+        return view_;
+    }
+
+    inline Projection Camera::get_projection() const{
+        return projection_;
+    }
+
+    inline double Camera::get_zoom() const{
+        return zoom_;
+    }
+
+    inline double Camera::get_distance() const{
+        return distance_;
+    }
+
+    inline size_t Camera::version() const{
+        return version_;
+    }
+
+    inline const Matrix<double, 4, 3>& Camera::matrix() const{
+        return matrix_;
+    }
+}
+
+#endif
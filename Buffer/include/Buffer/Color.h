@@ -0,0 +1,129 @@
+/**
+ * @file Color.h
+ * @brief Terminal colors for per-polyline styling of Buffer output
+ * @author Chesnokov Alexandr
+ * @date 2025
+ * @version 1.0
+ *
+ * This header defines a compact Color value (24-bit truecolor, 256-color palette
+ * index or the automatic legacy coloring) and its ANSI escape encoding.
+ */
+
+#ifndef COLOR_H
+#define COLOR_H
+
+#include <cstdint>
+#include <charconv>
+#include <string>
+#include <string_view>
+
+namespace BufferNameSpace {
+    /**
+     * @struct Color
+     * @brief Foreground color of a polyline
+     *
+     * Sending a Color to a Buffer (buffer << Color::rgb(255, 0, 0) << polyline)
+     * changes the color of everything drawn afterwards.
+     */
+    struct Color{
+        /**
+         * @enum Kind
+         * @brief Way the color is encoded
+         */
+        enum class Kind : uint8_t{
+            Automatic, ///< Legacy coloring: lines green, labels blue
+            Indexed,   ///< One of the 256 terminal palette colors
+            Rgb        ///< 24-bit truecolor
+        };
+
+        Kind kind = Kind::Automatic; ///< Encoding of the color
+        uint8_t red = 0; ///< Red component, or the palette index for Kind::Indexed
+        uint8_t green = 0; ///< Green component
+        uint8_t blue = 0; ///< Blue component
+
+        /**
+         * @brief Creates a truecolor color
+         * @param r Red component
+         * @param g Green component
+         * @param b Blue component
+         * @return Color of Kind::Rgb
+         */
+        static constexpr Color rgb(uint8_t r, uint8_t g, uint8_t b){
+            return Color{Kind::Rgb, r, g, b};
+        }
+
+        /**
+         * @brief Creates a 256-color palette color
+         * @param index Palette index
+         * @return Color of Kind::Indexed
+         */
+        static constexpr Color indexed(uint8_t index){
+            return Color{Kind::Indexed, index, 0, 0};
+        }
+
+        /**
+         * @brief Returns the automatic (legacy) coloring
+         * @return Color of Kind::Automatic
+         */
+        static constexpr Color automatic(){
+            return Color{};
+        }
+
+        bool operator==(const Color& other) const = default; ///< Equality operator
+
+        /**
+         * @brief Converts the color to truecolor
+         * @return Color of Kind::Rgb; palette indices use the standard xterm colors
+         *
+         * Kind::Automatic has no color of its own and becomes black.
+         */
+        constexpr Color to_rgb() const{
+            if(kind != Kind::Indexed){ return Color::rgb(red, green, blue); }
+            constexpr uint8_t basic[16][3] = {
+                {0, 0, 0}, {128, 0, 0}, {0, 128, 0}, {128, 128, 0}, {0, 0, 128}, {128, 0, 128}, {0, 128, 128}, {192, 192, 192},
+                {128, 128, 128}, {255, 0, 0}, {0, 255, 0}, {255, 255, 0}, {0, 0, 255}, {255, 0, 255}, {0, 255, 255}, {255, 255, 255}
+            };
+            if(red < 16){ return Color::rgb(basic[red][0], basic[red][1], basic[red][2]); }
+            if(red >= 232){
+                uint8_t level = static_cast<uint8_t>(8 + (red - 232) * 10);
+                return Color::rgb(level, level, level);
+            }
+            auto level = [](int step){ return static_cast<uint8_t>(step == 0 ? 0 : 55 + step * 40); };
+            int cube = red - 16;
+            return Color::rgb(level(cube / 36), level(cube / 6 % 6), level(cube % 6));
+        }
+
+        /**
+         * @brief Appends the ANSI escape sequence selecting this color
+         * @param out String to append to
+         *
+         * Appends nothing for Kind::Automatic.
+         */
+        void append_escape(std::string& out) const{
+            if(kind == Kind::Automatic){ return; }
+            auto append_number = [&out](uint8_t value){
+                char digits[3];
+                out.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+            };
+            if(kind == Kind::Indexed){
+                out += "\033[38;5;";
+                append_number(red);
+            }
+            else{
+                out += "\033[38;2;";
+                append_number(red);
+                out += ';';
+                append_number(green);
+                out += ';';
+                append_number(blue);
+            }
+            out += 'm';
+        }
+    };
+
+    constexpr Color line_color = Color::rgb(0, 255, 0); ///< Automatic color of lines (green)
+    constexpr Color label_color = Color::rgb(0, 191, 255); ///< Automatic color of point labels (blue)
+    constexpr std::string_view reset_escape = "\033[0;0m"; ///< Resets color and style
+}
+
+#endif
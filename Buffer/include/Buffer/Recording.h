@@ -0,0 +1,562 @@
+/**
+ * @file Recording.h
+ * @brief Session recording of Buffer frames and timed replay
+ * @author Chesnokov Alexandr
+ * @date 2025
+ * @version 1.0
+ *
+ * This header defines a Recorder that stores the frames of a Buffer as keyframes and
+ * cell-run deltas in the asciicast v2 format, and a Player that replays such files.
+ */
+
+#ifndef RECORDING_H
+#define RECORDING_H
+
+#include <Buffer/Buffer.h>
+#include <Buffer/RenderTarget.h>
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <istream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+
+namespace BufferNameSpace {
+    constexpr std::string_view keyframe_prefix = "\033[0m\033[2J"; ///< Starts the output of every keyframe
+
+    /**
+     * @brief Appends a string as a JSON string literal
+     * @param out String to append to
+     * @param text Bytes to quote; UTF-8 sequences are copied as is
+     */
+    inline void append_json_string(std::string& out, std::string_view text){
+        constexpr char hex[] = "0123456789abcdef";
+        out += '"';
+        for(char c : text){
+            auto byte = static_cast<unsigned char>(c);
+            if(c == '"' || c == '\\'){ out += '\\'; out += c; }
+            else if(c == '\n'){ out += "\\n"; }
+            else if(c == '\r'){ out += "\\r"; }
+            else if(c == '\t'){ out += "\\t"; }
+            else if(byte < 0x20){
+                out += "\\u00";
+                out += hex[byte >> 4];
+                out += hex[byte & 0xF];
+            }
+            else{ out += c; }
+        }
+        out += '"';
+    }
+
+    /**
+     * @brief Appends a number of whole cells as decimal digits
+     * @param out String to append to
+     * @param value Number to append
+     */
+    inline void append_decimal(std::string& out, size_t value){
+        char digits[20];
+        out.append(digits, std::to_chars(digits, digits + sizeof(digits), value).ptr);
+    }
+
+    /**
+     * @struct RecordedEvent
+     * @brief Output written at one moment of a recording
+     */
+    struct RecordedEvent{
+        double time = 0; ///< Seconds since the start of the recording
+        bool keyframe = false; ///< Whether data redraws the whole screen
+        std::string data{}; ///< Terminal output
+    };
+
+    /**
+     * @class FrameDelta
+     * @brief Terminal output that turns the previous frame of a Buffer into the current one
+     *
+     * Keeps the cells of the last encoded frame. A keyframe clears the screen and draws
+     * every non-blank cell; other frames draw only the runs of cells that changed, each
+     * run as a cursor move followed by the new cells. Only the top-left rows x cols
+     * cells are encoded, so one Buffer can feed a smaller terminal.
+     */
+    class FrameDelta{
+    private:
+        static constexpr size_t run_gap_ = 6; ///< Unchanged cells merged into a run rather than paying for a cursor move
+
+        bool colored_ = true; ///< Whether color escapes are written
+        size_t rows_ = 0; ///< Encoded rows, 0 before the first frame
+        size_t cols_ = 0; ///< Encoded columns
+        size_t stride_ = 0; ///< Width of the buffer, the distance between rows of cells
+        std::vector<FrameCell> previous_{}; ///< Cells of the last encoded frame
+        std::vector<FrameCell> current_{}; ///< Cells of the frame being encoded
+
+        /**
+         * @brief Appends the terminal output of one run of cells
+         * @param out String to append to
+         * @param row Row of the run
+         * @param col_begin First column of the run
+         * @param col_end Column after the last one of the run
+         */
+        void append_run(std::string& out, size_t row, size_t col_begin, size_t col_end) const{
+            out += "\033[";
+            append_decimal(out, row + 1);
+            out += ';';
+            append_decimal(out, col_begin + 1);
+            out += 'H';
+            Color color = Color::automatic();
+            for(size_t col = col_begin; col < col_end; col++){
+                const FrameCell& cell = current_[row * stride_ + col];
+                if(colored_ && !cell.blank() && cell.color != color){
+                    cell.color.append_escape(out);
+                    color = cell.color;
+                }
+                out += cell.view();
+            }
+            if(color != Color::automatic()){ out += reset_escape; }
+        }
+
+        /**
+         * @brief Appends the runs of cells that differ from previous_
+         * @param out String to append to
+         * @param keyframe Whether every non-blank cell is drawn after clearing the screen
+         */
+        void append_changes(std::string& out, bool keyframe) const{
+            const FrameCell blank{};
+            for(size_t row = 0; row < rows_; row++){
+                auto changed = [this, keyframe, &blank, row](size_t col){
+                    const FrameCell& cell = current_[row * stride_ + col];
+                    return keyframe ? cell != blank : cell != previous_[row * stride_ + col];
+                };
+                size_t col = 0;
+                while(col < cols_){
+                    if(!changed(col)){ col++; continue; }
+                    size_t run_begin = col, run_end = col + 1;
+                    for(size_t next = run_end; next < cols_ && next <= run_end + run_gap_; next++){
+                        if(changed(next)){ run_end = next + 1; }
+                    }
+                    append_run(out, row, run_begin, run_end);
+                    col = run_end;
+                }
+            }
+        }
+
+    public:
+        /**
+         * @brief Constructor
+         * @param colored Whether color escapes are written
+         */
+        explicit FrameDelta(bool colored = true) : colored_(colored){}
+
+        /**
+         * @brief Appends the output that shows the current frame of a buffer
+         * @tparam height Height of the buffer
+         * @tparam width Width of the buffer
+         * @param buffer Buffer holding the frame
+         * @param out String to append to
+         * @param keyframe Whether to redraw the whole screen
+         * @param rows Number of encoded rows, at most height
+         * @param cols Number of encoded columns, at most width
+         * @return bool Whether a keyframe was appended; the first frame and every size
+         *              change force one
+         */
+        template <size_t height, size_t width>
+        bool encode(const Buffer<height, width>& buffer, std::string& out, bool keyframe, size_t rows = height, size_t cols = width){
+            rows = std::min(rows, height);
+            cols = std::min(cols, width);
+            keyframe = keyframe || rows_ != rows || cols_ != cols || stride_ != width;
+            rows_ = rows;
+            cols_ = cols;
+            stride_ = width;
+            buffer.cells(current_);
+            if(keyframe){ out += keyframe_prefix; }
+            append_changes(out, keyframe);
+            previous_.swap(current_);
+            return keyframe;
+        }
+
+        /**
+         * @brief Forgets the last frame, so the next one is a keyframe
+         */
+        void reset(){
+            rows_ = 0;
+            cols_ = 0;
+        }
+    };
+
+    /**
+     * @class Recorder
+     * @brief Writes the frames of a Buffer to an asciicast v2 file
+     *
+     * The first frame and every keyframe_interval-th frame after it are stored whole
+     * (keyframes); the others store only the runs of cells that changed (see
+     * FrameDelta). Unchanged frames are not stored. Each event is written with one
+     * write call as soon as it is recorded.
+     */
+    class Recorder{
+    private:
+        int fd_ = -1; ///< Destination file descriptor
+        bool owns_fd_ = false; ///< Whether the descriptor is closed by the destructor
+        size_t keyframe_interval_ = 0; ///< Frames from one keyframe to the next
+        size_t height_ = 0; ///< Height of the recorded frames, 0 before the first frame
+        size_t width_ = 0; ///< Width of the recorded frames
+        size_t frames_ = 0; ///< Number of recorded frames
+        std::chrono::steady_clock::time_point start_{}; ///< Time of the first frame
+        FrameDelta delta_; ///< Cells of the last recorded frame and the delta encoder
+        std::string output_{}; ///< Terminal output of the frame being recorded
+        std::string event_{}; ///< Encoded event line
+
+        /**
+         * @brief Writes the file header
+         */
+        void write_header(){
+            event_ = "{\"version\": 2, \"width\": ";
+            append_decimal(event_, width_);
+            event_ += ", \"height\": ";
+            append_decimal(event_, height_);
+            event_ += ", \"keyframe_interval\": ";
+            append_decimal(event_, keyframe_interval_);
+            event_ += "}\n";
+            write_all(fd_, event_);
+        }
+
+    public:
+        /**
+         * @brief Constructor for an already open file descriptor
+         * @param fd Destination file descriptor (not closed by the recorder)
+         * @param keyframe_interval Frames from one keyframe to the next
+         * @param colored Whether color escapes are recorded
+         * @throws std::invalid_argument if keyframe_interval is 0
+         */
+        Recorder(int fd, size_t keyframe_interval = 150, bool colored = true) : fd_(fd), keyframe_interval_(keyframe_interval), delta_(colored){
+            if(keyframe_interval_ == 0){ throw std::invalid_argument("Keyframe interval must be positive"); }
+        }
+
+        /**
+         * @brief Constructor creating (or truncating) a file
+         * @param path Path of the file
+         * @param keyframe_interval Frames from one keyframe to the next
+         * @param colored Whether color escapes are recorded
+         * @throws std::invalid_argument if keyframe_interval is 0
+         * @throws std::runtime_error if the file cannot be opened
+         */
+        Recorder(const std::string& path, size_t keyframe_interval = 150, bool colored = true) : Recorder(-1, keyframe_interval, colored){
+            fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if(fd_ < 0){ throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno)); }
+            owns_fd_ = true;
+        }
+
+        Recorder(const Recorder&) = delete;
+        Recorder& operator=(const Recorder&) = delete;
+
+        /**
+         * @brief Destructor
+         *
+         * Closes the file opened by the path constructor.
+         */
+        ~Recorder(){
+            if(owns_fd_){ ::close(fd_); }
+        }
+
+        /**
+         * @brief Get the number of recorded frames
+         * @return size_t Frames passed to record, including unchanged ones
+         */
+        size_t frames() const{
+            return frames_;
+        }
+
+        /**
+         * @brief Records a frame at the current time
+         * @tparam height Height of the buffer
+         * @tparam width Width of the buffer
+         * @param buffer Buffer holding the frame
+         * @throws std::invalid_argument if the buffer size differs from the first frame
+         * @throws std::runtime_error if write fails
+         *
+         * Time is measured from the first recorded frame.
+         */
+        template <size_t height, size_t width>
+        void record(const Buffer<height, width>& buffer){
+            auto now = std::chrono::steady_clock::now();
+            if(frames_ == 0){ start_ = now; }
+            record(buffer, std::chrono::duration<double>(now - start_).count());
+        }
+
+        /**
+         * @brief Records a frame at a given time
+         * @tparam height Height of the buffer
+         * @tparam width Width of the buffer
+         * @param buffer Buffer holding the frame
+         * @param time Seconds since the start of the recording
+         * @throws std::invalid_argument if the buffer size differs from the first frame
+         * @throws std::runtime_error if write fails
+         */
+        template <size_t height, size_t width>
+        void record(const Buffer<height, width>& buffer, double time){
+            if(height_ == 0){
+                height_ = height;
+                width_ = width;
+                write_header();
+            }
+            else if(height_ != height || width_ != width){
+                throw std::invalid_argument("All recorded frames must have the same size");
+            }
+            output_.clear();
+            bool keyframe = delta_.encode(buffer, output_, frames_ % keyframe_interval_ == 0);
+            frames_++;
+            if(!keyframe && output_.empty()){ return; }
+
+            event_ = "[";
+            char digits[32];
+            event_.append(digits, std::to_chars(digits, digits + sizeof(digits), time, std::chars_format::fixed, 6).ptr);
+            event_ += ", \"o\", ";
+            append_json_string(event_, output_);
+            event_ += "]\n";
+            write_all(fd_, event_);
+        }
+    };
+
+    /**
+     * @class Player
+     * @brief Replays an asciicast v2 recording
+     *
+     * Events of other types than output ("o") are ignored, so recordings made by other
+     * tools play as well; keyframes are recognized by keyframe_prefix.
+     */
+    class Player{
+    private:
+        size_t height_ = 0; ///< Height of the recorded screen
+        size_t width_ = 0; ///< Width of the recorded screen
+        std::vector<RecordedEvent> events_{}; ///< Output events in time order
+
+        /**
+         * @brief Reads an unsigned integer field of the header
+         * @param header Header line
+         * @param key Name of the field
+         * @return size_t Value of the field, 0 if it is missing
+         */
+        static size_t header_field(std::string_view header, std::string_view key){
+            std::string quoted = "\"" + std::string(key) + "\"";
+            size_t position = header.find(quoted);
+            if(position == std::string_view::npos){ return 0; }
+            position = header.find_first_of("0123456789", position + quoted.size());
+            size_t value = 0;
+            if(position != std::string_view::npos){ std::from_chars(header.data() + position, header.data() + header.size(), value); }
+            return value;
+        }
+
+        /**
+         * @brief Appends a code point as UTF-8
+         * @param out String to append to
+         * @param code Unicode code point
+         */
+        static void append_utf8(std::string& out, uint32_t code){
+            if(code < 0x80){ out += static_cast<char>(code); }
+            else if(code < 0x800){
+                out += static_cast<char>(0xC0 | (code >> 6));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else if(code < 0x10000){
+                out += static_cast<char>(0xE0 | (code >> 12));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+            else{
+                out += static_cast<char>(0xF0 | (code >> 18));
+                out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+                out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+                out += static_cast<char>(0x80 | (code & 0x3F));
+            }
+        }
+
+        /**
+         * @brief Parses a JSON string literal
+         * @param line Text being parsed
+         * @param position Index of the opening quote, moved past the closing quote
+         * @param out String receiving the unescaped bytes
+         * @return bool False if the literal is malformed
+         */
+        static bool parse_string(std::string_view line, size_t& position, std::string& out){
+            if(position >= line.size() || line[position] != '"'){ return false; }
+            position++;
+            auto hex4 = [&line](size_t at, uint32_t& value){
+                if(at + 4 > line.size()){ return false; }
+                return std::from_chars(line.data() + at, line.data() + at + 4, value, 16).ptr == line.data() + at + 4;
+            };
+            while(position < line.size()){
+                char c = line[position++];
+                if(c == '"'){ return true; }
+                if(c != '\\'){ out += c; continue; }
+                if(position >= line.size()){ return false; }
+                char escape = line[position++];
+                switch(escape){
+                    case 'n': out += '\n'; break;
+                    case 'r': out += '\r'; break;
+                    case 't': out += '\t'; break;
+                    case 'b': out += '\b'; break;
+                    case 'f': out += '\f'; break;
+                    case 'u':{
+                        uint32_t code = 0;
+                        if(!hex4(position, code)){ return false; }
+                        position += 4;
+                        uint32_t low = 0;
+                        if(code >= 0xD800 && code < 0xDC00 && line.substr(position, 2) == "\\u" && hex4(position + 2, low)){
+                            code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                            position += 6;
+                        }
+                        append_utf8(out, code);
+                        break;
+                    }
+                    default: out += escape;
+                }
+            }
+            return false;
+        }
+
+        /**
+         * @brief Skips blanks
+         * @param line Text being parsed
+         * @param position Index moved to the first non-blank character
+         */
+        static void skip_spaces(std::string_view line, size_t& position){
+            while(position < line.size() && (line[position] == ' ' || line[position] == '\t')){ position++; }
+        }
+
+        /**
+         * @brief Parses one event line
+         * @param line Text of the line, [time, "type", "data"]
+         * @param event Event receiving time and data
+         * @param type String receiving the event type
+         * @return bool False if the line is malformed
+         */
+        static bool parse_event(std::string_view line, RecordedEvent& event, std::string& type){
+            size_t position = 0;
+            auto skip = [&line, &position](char expected){
+                skip_spaces(line, position);
+                if(position >= line.size() || line[position] != expected){ return false; }
+                position++;
+                skip_spaces(line, position);
+                return true;
+            };
+            if(!skip('[')){ return false; }
+            auto [end, error] = std::from_chars(line.data() + position, line.data() + line.size(), event.time);
+            if(error != std::errc{}){ return false; }
+            position = static_cast<size_t>(end - line.data());
+            type.clear();
+            event.data.clear();
+            return skip(',') && parse_string(line, position, type) && skip(',') && parse_string(line, position, event.data) && skip(']');
+        }
+
+    public:
+        /**
+         * @brief Constructor reading a whole recording
+         * @param in Stream holding an asciicast v2 file
+         * @throws std::runtime_error if the header or an event is malformed
+         */
+        explicit Player(std::istream& in){
+            std::string line;
+            if(!std::getline(in, line) || header_field(line, "version") != 2){
+                throw std::runtime_error("Not an asciicast v2 recording");
+            }
+            height_ = header_field(line, "height");
+            width_ = header_field(line, "width");
+            std::string type;
+            size_t line_number = 1;
+            while(std::getline(in, line)){
+                line_number++;
+                if(line.find_first_not_of(" \t\r") == std::string::npos){ continue; }
+                RecordedEvent event;
+                if(!parse_event(line, event, type)){
+                    throw std::runtime_error("Bad event in recording line " + std::to_string(line_number));
+                }
+                if(type != "o"){ continue; }
+                event.keyframe = std::string_view(event.data).starts_with(keyframe_prefix);
+                events_.push_back(std::move(event));
+            }
+        }
+
+        /**
+         * @brief Get the height of the recorded screen
+         * @return size_t Rows, 0 if the header does not say
+         */
+        size_t height() const{
+            return height_;
+        }
+
+        /**
+         * @brief Get the width of the recorded screen
+         * @return size_t Columns, 0 if the header does not say
+         */
+        size_t width() const{
+            return width_;
+        }
+
+        /**
+         * @brief Get the output events
+         * @return Const reference to the events in time order
+         */
+        const std::vector<RecordedEvent>& events() const{
+            return events_;
+        }
+
+        /**
+         * @brief Get the length of the recording
+         * @return double Time of the last event in seconds
+         */
+        double duration() const{
+            return events_.empty() ? 0 : events_.back().time;
+        }
+
+        /**
+         * @brief Appends the output that shows the screen as it was at a given time
+         * @param out String to append to
+         * @param time Seconds since the start of the recording
+         * @return size_t Index of the first event after time
+         *
+         * Starts from the last keyframe at or before time, so seeking never replays
+         * more than one keyframe interval.
+         */
+        size_t frame_at(std::string& out, double time) const{
+            size_t end = 0;
+            while(end < events_.size() && events_[end].time <= time){ end++; }
+            size_t begin = end;
+            while(begin > 0 && !events_[begin - 1].keyframe){ begin--; }
+            if(begin > 0){ begin--; }
+            for(size_t i = begin; i < end; i++){ out += events_[i].data; }
+            return end;
+        }
+
+        /**
+         * @brief Replays the recording in real time
+         * @param fd Destination file descriptor
+         * @param speed Playback speed, 2 plays twice as fast; infinity plays without waiting
+         * @param from Seconds of the recording to skip
+         * @throws std::invalid_argument if speed is not positive
+         * @throws std::runtime_error if write fails
+         *
+         * The screen at from is written with one write call, then every event with
+         * its own at its scheduled time.
+         */
+        void play(int fd, double speed = 1, double from = 0) const{
+            if(!(speed > 0)){ throw std::invalid_argument("Playback speed must be positive"); }
+            std::string output;
+            size_t next = frame_at(output, from);
+            write_all(fd, output);
+            if(std::isinf(speed)){
+                for(size_t i = next; i < events_.size(); i++){ write_all(fd, events_[i].data); }
+                return;
+            }
+            auto start = std::chrono::steady_clock::now();
+            for(size_t i = next; i < events_.size(); i++){
+                auto delay = std::chrono::duration<double>((events_[i].time - from) / speed);
+                std::this_thread::sleep_until(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(delay));
+                write_all(fd, events_[i].data);
+            }
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,132 @@
+/**
+ * @file RenderTarget.h
+ * @brief Headless output of Buffer frames to files and file descriptors
+ * @author Chesnokov Alexandr
+ * @date 2025
+ * @version 1.0
+ *
+ * This header defines a RenderTarget class that encodes Buffer frames as plain text,
+ * ANSI text or PGM/PPM bitmaps and writes them without needing a terminal.
+ */
+
+#ifndef RENDERTARGET_H
+#define RENDERTARGET_H
+
+#include <Buffer/Buffer.h>
+#include <Utils/Profiler.h>
+#include <cerrno>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace BufferNameSpace {
+    /**
+     * @brief Parses a frame format name
+     * @param name One of "ansi", "plain", "pgm", "ppm"
+     * @return FrameFormat with that name
+     * @throws std::invalid_argument for an unknown name
+     */
+    inline FrameFormat frame_format_from_name(std::string_view name){
+        if(name == "ansi"){ return FrameFormat::Ansi; }
+        if(name == "plain"){ return FrameFormat::Plain; }
+        if(name == "pgm"){ return FrameFormat::Pgm; }
+        if(name == "ppm"){ return FrameFormat::Ppm; }
+        throw std::invalid_argument("Unknown frame format: " + std::string(name));
+    }
+
+    /**
+     * @brief Writes a whole byte range to a file descriptor
+     * @param fd Destination file descriptor
+     * @param data Bytes to write
+     * @throws std::runtime_error if write fails
+     *
+     * Retries after partial writes and interrupted system calls.
+     */
+    inline void write_all(int fd, std::string_view data){
+        UtilsNameSpace::ScopedTimer timer(UtilsNameSpace::ProfileStage::Output);
+        UtilsNameSpace::Profiler::count(UtilsNameSpace::ProfileCounter::BytesWritten, data.size());
+        while(!data.empty()){
+            ssize_t written = ::write(fd, data.data(), data.size());
+            if(written < 0){
+                if(errno == EINTR){ continue; }
+                throw std::runtime_error(std::string("Write failed: ") + std::strerror(errno));
+            }
+            data.remove_prefix(static_cast<size_t>(written));
+        }
+    }
+
+    /**
+     * @class RenderTarget
+     * @brief Destination for encoded frames
+     *
+     * Every frame is encoded into a reused string and written with one write call
+     * (more only after partial writes).
+     */
+    class RenderTarget{
+    private:
+        int fd_ = -1; ///< Destination file descriptor
+        bool owns_fd_ = false; ///< Whether the descriptor is closed by the destructor
+        FrameFormat format_ = FrameFormat::Plain; ///< Encoding of written frames
+        std::string frame_{}; ///< Encoding scratch buffer
+
+    public:
+        /**
+         * @brief Constructor for an already open file descriptor
+         * @param fd Destination file descriptor (not closed by the target)
+         * @param format Encoding of written frames
+         */
+        RenderTarget(int fd, FrameFormat format) : fd_(fd), format_(format){}
+
+        /**
+         * @brief Constructor creating (or truncating) a file
+         * @param path Path of the file
+         * @param format Encoding of written frames
+         * @throws std::runtime_error if the file cannot be opened
+         */
+        RenderTarget(const std::string& path, FrameFormat format) : format_(format){
+            fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+            if(fd_ < 0){ throw std::runtime_error("Cannot open " + path + ": " + std::strerror(errno)); }
+            owns_fd_ = true;
+        }
+
+        RenderTarget(const RenderTarget&) = delete;
+        RenderTarget& operator=(const RenderTarget&) = delete;
+
+        /**
+         * @brief Destructor
+         *
+         * Closes the file opened by the path constructor.
+         */
+        ~RenderTarget(){
+            if(owns_fd_){ ::close(fd_); }
+        }
+
+        /**
+         * @brief Get the encoding of written frames
+         * @return FrameFormat of the target
+         */
+        FrameFormat get_format() const{
+            return format_;
+        }
+
+        /**
+         * @brief Encodes and writes one frame
+         * @tparam height Height of the buffer
+         * @tparam width Width of the buffer
+         * @param buffer Buffer holding the frame
+         * @throws std::runtime_error if write fails
+         */
+        template <size_t height, size_t width>
+        void write(const Buffer<height, width>& buffer){
+            frame_.clear();
+            buffer.encode(frame_, format_);
+            write_all(fd_, frame_);
+            UtilsNameSpace::Profiler::frame();
+        }
+    };
+}
+
+#endif
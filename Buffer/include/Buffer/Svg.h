@@ -0,0 +1,263 @@
+/**
+ * @file Svg.h
+ * @brief SVG export of polylines projected through the views of a Buffer
+ * @author Chesnokov Alexandr
+ * @date 2025
+ * @version 1.0
+ *
+ * This header writes the scene a Buffer would draw as an SVG document: every view
+ * (the whole buffer or each viewport) gets its axes and the polylines projected by
+ * its camera, clipped to its rectangle. Coordinates stay fractional, so the image is
+ * as sharp as the output resolution allows instead of being snapped to cells.
+ */
+
+#ifndef SVG_H
+#define SVG_H
+
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <utility>
+#include <vector>
+#include <Polyline/Polyline.h>
+#include <Buffer/Buffer.h>
+#include <Buffer/Color.h>
+
+namespace BufferNameSpace {
+    /**
+     * @struct SvgOptions
+     * @brief Layout of an SVG export
+     */
+    struct SvgOptions{
+        double cell_width = 8; ///< Width of one buffer cell in SVG pixels
+        double cell_height = 16; ///< Height of one buffer cell in SVG pixels
+        bool simplify = true; ///< Drop points closer than tolerance to the previous kept point
+        double tolerance = 0.5; ///< Smallest distance between kept points in SVG pixels
+        bool axes = true; ///< Draw the X, Y and Z axes of every view
+        bool labels = true; ///< Write point names next to the kept points
+    };
+
+    /**
+     * @class SvgWriter
+     * @brief Builder of one SVG document in a single string
+     *
+     * Used by write_svg; everything is appended to one buffer and written at once.
+     */
+    class SvgWriter{
+    private:
+        std::string text_{}; ///< Document built so far
+        SvgOptions options_; ///< Layout of the document
+
+        static void number(std::string& out, double value){
+            char digits[32];
+            out.append(digits, std::to_chars(digits, digits + sizeof(digits), std::round(value * 100) / 100).ptr);
+        }
+
+        static void color(std::string& out, const Color& color){
+            Color rgb = color.to_rgb();
+            char hex[8];
+            std::snprintf(hex, sizeof(hex), "#%02x%02x%02x", rgb.red, rgb.green, rgb.blue);
+            out.append(hex);
+        }
+
+        void point(const BufferPoint& point){
+            number(text_, point.y * options_.cell_width);
+            text_.push_back(',');
+            number(text_, point.x * options_.cell_height);
+        }
+
+    public:
+        /**
+         * @brief Constructor
+         * @param options Layout of the document
+         */
+        explicit SvgWriter(const SvgOptions& options) : options_(options){}
+
+        /**
+         * @brief Opens the document and declares the clip rectangles of the views
+         * @param height Buffer height in cells
+         * @param width Buffer width in cells
+         * @param areas Rectangle of every view
+         */
+        void begin(size_t height, size_t width, std::span<const Tile> areas){
+            text_.append("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"");
+            number(text_, static_cast<double>(width) * options_.cell_width);
+            text_.append("\" height=\"");
+            number(text_, static_cast<double>(height) * options_.cell_height);
+            text_.append("\" font-family=\"monospace\" font-size=\"");
+            number(text_, options_.cell_height * 0.8);
+            text_.append("\">\n<rect width=\"100%\" height=\"100%\" fill=\"black\"/>\n<defs>\n");
+            for(size_t view = 0; view < areas.size(); view++){
+                const Tile& area = areas[view];
+                text_.append("<clipPath id=\"view");
+                text_.append(std::to_string(view));
+                text_.append("\"><rect x=\"");
+                number(text_, static_cast<double>(area.col_begin) * options_.cell_width);
+                text_.append("\" y=\"");
+                number(text_, static_cast<double>(area.row_begin) * options_.cell_height);
+                text_.append("\" width=\"");
+                number(text_, static_cast<double>(area.col_end - area.col_begin) * options_.cell_width);
+                text_.append("\" height=\"");
+                number(text_, static_cast<double>(area.row_end - area.row_begin) * options_.cell_height);
+                text_.append("\"/></clipPath>\n");
+            }
+            text_.append("</defs>\n");
+        }
+
+        /**
+         * @brief Opens the group of one view
+         * @param view Index of the view
+         */
+        void begin_view(size_t view){
+            text_.append("<g clip-path=\"url(#view");
+            text_.append(std::to_string(view));
+            text_.append(")\" fill=\"none\" stroke-linejoin=\"round\">\n");
+        }
+
+        /**
+         * @brief Closes the group of a view
+         */
+        void end_view(){ text_.append("</g>\n"); }
+
+        /**
+         * @brief Appends one projected polyline with its labels
+         * @tparam T Numeric type of point coordinates
+         * @param polyline Polyline to write
+         * @param projector Projection of the view, with round_rows cleared
+         * @param line Stroke color
+         * @param label Color of the point names
+         */
+        template<Numeric T>
+        void polyline(const Polyline<T>& polyline, const Projector& projector, const Color& line, const Color& label){
+            size_t size = polyline.points_count();
+            if(size == 0){ return; }
+            double tolerance_rows = options_.tolerance / options_.cell_height;
+            double tolerance_cols = options_.tolerance / options_.cell_width;
+            std::string labels{};
+            BufferPoint kept{};
+            bool open = false;
+            auto vertex = [this, &kept, &open, &line](const BufferPoint& projected){
+                if(!open){
+                    text_.append("<polyline stroke=\"");
+                    color(text_, line);
+                    text_.append("\" points=\"");
+                    open = true;
+                }
+                else{ text_.push_back(' '); }
+                point(projected);
+                kept = projected;
+            };
+            auto close = [this, &open](){
+                if(open){ text_.append("\"/>\n"); }
+                open = false;
+            };
+            // Parts behind the near plane are cut off in perspective projection, which
+            // splits the polyline into separate elements
+            for(size_t i = 0; i < size; i++){
+                if(projector.behind(polyline[i])){
+                    if(i != 0 && !projector.behind(polyline[i - 1])){ vertex(projector.near_point(polyline[i], polyline[i - 1])); }
+                    close();
+                    continue;
+                }
+                if(i != 0 && projector.behind(polyline[i - 1])){ vertex(projector.near_point(polyline[i - 1], polyline[i])); }
+                BufferPoint projected = projector(polyline[i]);
+                if(open && options_.simplify && i + 1 != size && !projector.behind(polyline[i + 1])){
+                    double rows = (projected.x - kept.x) / tolerance_rows, cols = (projected.y - kept.y) / tolerance_cols;
+                    if(rows * rows + cols * cols < 1){ continue; }
+                }
+                vertex(projected);
+                if(options_.labels){
+                    // Labels follow the polyline element, so they are collected separately
+                    labels.append("<text x=\"");
+                    number(labels, projected.y * options_.cell_width);
+                    labels.append("\" y=\"");
+                    number(labels, projected.x * options_.cell_height);
+                    labels.append("\" fill=\"");
+                    color(labels, label);
+                    labels.append("\">");
+                    char name = polyline[i].name_;
+                    if(name == '<'){ labels.append("&lt;"); }
+                    else if(name == '>'){ labels.append("&gt;"); }
+                    else if(name == '&'){ labels.append("&amp;"); }
+                    else if(name >= ' ' && name != 127){ labels.push_back(name); }
+                    labels.append("</text>\n");
+                }
+            }
+            close();
+            text_.append(labels);
+        }
+
+        /**
+         * @brief Closes the document and returns it
+         * @return std::string The SVG text
+         */
+        std::string finish(){
+            text_.append("</svg>\n");
+            return std::move(text_);
+        }
+    };
+
+    /**
+     * @brief Renders polylines as an SVG document through the views of a buffer
+     * @tparam height_ Buffer height
+     * @tparam width_ Buffer width
+     * @tparam T Numeric type of point coordinates
+     * @param buffer Buffer whose cameras and viewports are used; it is not modified
+     * @param lines Polylines to export
+     * @param colors Color of every polyline, cycled; empty for the automatic colors
+     * @param options Layout of the document
+     * @return std::string The SVG document
+     */
+    template<size_t height_, size_t width_, Numeric T>
+    std::string render_svg(const Buffer<height_, width_>& buffer, const std::vector<Polyline<T>>& lines, std::span<const Color> colors = {}, const SvgOptions& options = {}){
+        SvgWriter writer(options);
+        std::vector<Tile> areas{};
+        for(size_t view = 0; view < buffer.view_count(); view++){ areas.push_back(buffer.view_area(view)); }
+        writer.begin(height_, width_, areas);
+        for(size_t view = 0; view < buffer.view_count(); view++){
+            Projector projector = buffer.view_projector(view);
+            projector.round_rows = false;
+            writer.begin_view(view);
+            if(options.axes){
+                int length = static_cast<int>(areas[view].row_end - areas[view].row_begin) - 1;
+                Point<int> ends[3] = {{length, 0, 0, 'X'}, {0, length, 0, 'Y'}, {0, 0, length, 'Z'}};
+                for(const Point<int>& end : ends){
+                    Polyline<int> axis;
+                    axis.add_point(0, 0, 0, 'O');
+                    axis.add_point(end);
+                    writer.polyline(axis, projector, Color::rgb(128, 128, 128), label_color);
+                }
+            }
+            for(size_t i = 0; i < lines.size(); i++){
+                Color color = colors.empty() ? line_color : colors[i % colors.size()];
+                writer.polyline(lines[i], projector, color, colors.empty() ? label_color : color);
+            }
+            writer.end_view();
+        }
+        return writer.finish();
+    }
+
+    /**
+     * @brief Writes polylines as an SVG file through the views of a buffer
+     * @param path Path of the file, replaced if it exists
+     * @throws std::runtime_error if the file cannot be written
+     *
+     * See render_svg for the other parameters. The document is written in one call.
+     */
+    template<size_t height_, size_t width_, Numeric T>
+    void write_svg(const std::string& path, const Buffer<height_, width_>& buffer, const std::vector<Polyline<T>>& lines, std::span<const Color> colors = {}, const SvgOptions& options = {}){
+        std::string document = render_svg(buffer, lines, colors, options);
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if(!file){ throw std::runtime_error("Cannot open SVG file " + path); }
+        file.write(document.data(), static_cast<std::streamsize>(document.size()));
+        file.flush();
+        if(!file){ throw std::runtime_error("Cannot write SVG file " + path); }
+    }
+}
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * @file Transform.h
+ * @brief Affine transforms for instanced polyline rendering
+ * @author Chesnokov Alexandr
+ * @date 2025
+ * @version 1.0
+ *
+ * A Transform maps a point as [x, y, z, 1] * transform = [x', y', z'], the same
+ * row-vector convention Polyline uses for its rotations.
+ */
+
+#ifndef TRANSFORM_H
+#define TRANSFORM_H
+
+#include <Matrix/Matrix.h>
+#include <cmath>
+#include <numbers>
+
+namespace BufferNameSpace {
+    using namespace MatrixNameSpace;
+
+    using Transform = Matrix<double, 4, 3>; ///< Affine transform: 3x3 linear part and a translation row
+
+    /**
+     * @brief Creates the identity transform
+     * @return Transform leaving points unchanged
+     */
+    inline Transform identity_transform(){
+        return Transform{
+            1, 0, 0,
+            0, 1, 0,
+            0, 0, 1,
+            0, 0, 0
+        };
+    }
+
+    /**
+     * @brief Creates a translation
+     * @param x Shift along X-axis
+     * @param y Shift along Y-axis
+     * @param z Shift along Z-axis
+     * @return Transform equivalent to Polyline::shift(x, y, z)
+     */
+    inline Transform translation(double x, double y, double z){
+        Transform result = identity_transform();
+        result[3, 0] = x;
+        result[3, 1] = y;
+        result[3, 2] = z;
+        return result;
+    }
+
+    /**
+     * @brief Creates a uniform scaling around the origin
+     * @param factor Scale factor
+     * @return Transform multiplying all coordinates by factor
+     */
+    inline Transform scaling(double factor){
+        Transform result{};
+        result[0, 0] = result[1, 1] = result[2, 2] = factor;
+        return result;
+    }
+
+    /**
+     * @brief Creates a rotation around the origin
+     * @param x_degree Rotation angle around X-axis in degrees
+     * @param y_degree Rotation angle around Y-axis in degrees
+     * @param z_degree Rotation angle around Z-axis in degrees
+     * @return Transform equivalent to Polyline::rotate_from_origin
+     */
+    inline Transform rotation(double x_degree, double y_degree, double z_degree){
+        double x_radians = x_degree * std::numbers::pi_v<double> / 180.0;
+        double y_radians = y_degree * std::numbers::pi_v<double> / 180.0;
+        double z_radians = z_degree * std::numbers::pi_v<double> / 180.0;
+        Matrix<double, 3, 3> x_matrix = {
+            1, 0, 0,
+            0, std::cos(x_radians), std::sin(x_radians),
+            0, (-1) * std::sin(x_radians), std::cos(x_radians)
+        };
+        Matrix<double, 3, 3> y_matrix = {
+            std::cos(y_radians), 0, (-1) * std::sin(y_radians),
+            0, 1, 0,
+            std::sin(y_radians), 0, std::cos(y_radians)
+        };
+        Matrix<double, 3, 3> z_matrix = {
+            std::cos(z_radians), std::sin(z_radians), 0,
+            (-1) * std::sin(z_radians), std::cos(z_radians), 0,
+            0, 0, 1
+        };
+        Matrix<double, 3, 3> linear = x_matrix * y_matrix * z_matrix;
+        Transform result{};
+        for(size_t i = 0; i < 3; i++){
+            for(size_t j = 0; j < 3; j++){
+                result[i, j] = linear[i, j];
+            }
+        }
+        return result;
+    }
+
+    /**
+     * @brief Extends an affine 4x3 matrix to a square 4x4 matrix
+     * @param transform Affine transform
+     * @return Matrix<double, 4, 4> with the column (0, 0, 0, 1) appended
+     */
+    inline Matrix<double, 4, 4> homogeneous(const Transform& transform){
+        Matrix<double, 4, 4> result{};
+        for(size_t i = 0; i < 4; i++){
+            for(size_t j = 0; j < 3; j++){
+                result[i, j] = transform[i, j];
+            }
+        }
+        result[3, 3] = 1;
+        return result;
+    }
+
+    /**
+     * @brief Composes two transforms
+     * @param first Transform applied first
+     * @param second Transform applied second
+     * @return Transform equal to applying first, then second
+     */
+    inline Transform compose(const Transform& first, const Transform& second){
+        return homogeneous(first) * second;
+    }
+}
+
+#endif
@@ -0,0 +1,253 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstddef>
+#include <cstdio>
+#include <fstream>
+#include <span>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <Polyline/Polyline.h>
+#include <Polyline/Scene.h>
+#include <Polyline/Obj.h>
+#include <Polyline/SharedScene.h>
+#include <Buffer/Buffer.h>
+#include <Buffer/RenderTarget.h>
+#include <Buffer/Recording.h>
+#include <Dialogue/Dialogue.h>
+#include <Dialogue/Script.h>
+#include <Dialogue/Server.h>
+
+namespace DialogueNameSpace {
+    struct BatchOptions{
+        std::string scene_path{};
+        size_t frames = 1;
+        FrameFormat format = FrameFormat::Plain;
+        std::string output = "-";
+        double orbit = 0;
+        bool braille = false;
+        std::string play_path{};
+        std::string script_path{};
+        double speed = 1;
+        std::string serve_path{};
+        std::string load_path{};
+        std::string files_path{};
+        std::string view_name{};
+        double fps = 10;
+    };
+
+    inline const char* batch_usage =
+        "Usage: Main --render SCENE [--frames N] [--format plain|ansi|pgm|ppm]\n"
+        "            [--output PATH] [--orbit DEGREES] [--braille]\n"
+        "       Main --play RECORDING [--speed FACTOR]\n"
+        "       Main --script FILE\n"
+        "       Main --serve SOCKET [--load SCENE] [--files DIR]\n"
+        "       Main --view NAME [--frames N] [--fps RATE] [--format plain|ansi|pgm|ppm]\n"
+        "            [--output PATH] [--braille]\n"
+        "SCENE holds one point per line (x y z name), polylines are separated by empty lines;\n"
+        "a SCENE ending in .obj is read as Wavefront OBJ vertex and line records.\n"
+        "PATH '-' is the standard output; '{}' in PATH is replaced by the frame number.\n"
+        "FILE holds one command per line ('-' reads them from the standard input):\n"
+        "  create X Y Z NAME [X Y Z NAME ...]   shift TARGET DX DY DZ   join ID ID   prune ID\n"
+        "  rotate TARGET AX AY AZ                rotate TARGET X1 Y1 Z1 X2 Y2 Z2 DEGREES   group ID [GROUP]\n"
+        "  camera [VIEW] zoom F|pan ROWS COLS|orbit YAW PITCH|perspective|reset\n"
+        "  mode ascii|braille   viewports single|quad   clear   render [ansi|plain|pgm|ppm] [PATH]\n"
+        "  import OBJ   export OBJ   svg PATH\n"
+        "Lines get IDs 1, 2, ... in order of creation and keep them; TARGET is an ID or a group name.\n"
+        "SOCKET is a Unix socket path; its clients send the commands of FILE and get frames of\n"
+        "their own size ('size ROWS COLS', 24 80 at first) with a status line below; 'frame'\n"
+        "redraws the whole frame and 'quit' disconnects. Only the owner may connect; import,\n"
+        "export, svg and render PATH name plain files in DIR and are refused without --files.\n"
+        "NAME is a shared memory segment published by menu option 20; --view draws every new\n"
+        "version of its lines, checking RATE times a second, N of them (0 for no limit, until\n"
+        "the publishing process stops).\n"
+        "RECORDING is an asciicast v2 file, such as session.cast written by the animation menu option.\n";
+
+    // The whole value has to be the number; "-1" is no count and "10x" no rate
+    template<typename N>
+    N option_number(std::string_view option, std::string_view text){
+        N value{};
+        auto [end, error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        if(text.empty() || error != std::errc{} || end != text.data() + text.size()){
+            throw std::invalid_argument(std::string(option) + (std::is_integral_v<N> ? " expects a whole number, not '" : " expects a number, not '") + std::string(text) + "'");
+        }
+        return value;
+    }
+
+    inline BatchOptions parse_batch_options(int argc, char** argv){
+        BatchOptions options;
+        std::vector<std::string_view> modes{};
+        for(int i = 1; i < argc; i++){
+            std::string_view arg = argv[i];
+            auto value = [&i, argc, argv, arg]() -> std::string{
+                if(i + 1 >= argc){ throw std::invalid_argument("Missing value for " + std::string(arg)); }
+                return argv[++i];
+            };
+            if(arg == "--render" || arg == "--play" || arg == "--script" || arg == "--serve" || arg == "--view"){
+                if(std::ranges::find(modes, arg) == modes.end()){ modes.push_back(arg); }
+            }
+            if(arg == "--render"){ options.scene_path = value(); }
+            else if(arg == "--frames"){ options.frames = option_number<size_t>(arg, value()); }
+            else if(arg == "--format"){ options.format = frame_format_from_name(value()); }
+            else if(arg == "--output"){ options.output = value(); }
+            else if(arg == "--orbit"){ options.orbit = option_number<double>(arg, value()); }
+            else if(arg == "--braille"){ options.braille = true; }
+            else if(arg == "--play"){ options.play_path = value(); }
+            else if(arg == "--speed"){ options.speed = option_number<double>(arg, value()); }
+            else if(arg == "--script"){ options.script_path = value(); }
+            else if(arg == "--serve"){ options.serve_path = value(); }
+            else if(arg == "--load"){ options.load_path = value(); }
+            else if(arg == "--files"){ options.files_path = value(); }
+            else if(arg == "--view"){ options.view_name = value(); }
+            else if(arg == "--fps"){ options.fps = option_number<double>(arg, value()); }
+            else{ throw std::invalid_argument("Unknown option " + std::string(arg)); }
+        }
+        if(modes.size() > 1){
+            throw std::invalid_argument("Only one of --render, --play, --script, --serve and --view can be given, not " + std::string(modes[0]) + " and " + std::string(modes[1]));
+        }
+        if(options.scene_path.empty() && options.play_path.empty() && options.script_path.empty() && options.serve_path.empty() && options.view_name.empty()){ throw std::invalid_argument("No scene file given"); }
+        return options;
+    }
+
+    template<Numeric T>
+    std::vector<Polyline<T>> load_scene(std::istream& in){
+        std::vector<Polyline<T>> lines{};
+        Polyline<T> polyline;
+        std::string line;
+        size_t line_number = 0;
+        while(std::getline(in, line)){
+            line_number++;
+            size_t first = line.find_first_not_of(" \t\r");
+            if(first != std::string::npos && line[first] == '#'){ continue; }
+            if(first == std::string::npos){
+                if(polyline.points_count() != 0){ lines.push_back(std::move(polyline)); }
+                polyline = Polyline<T>();
+                continue;
+            }
+            std::istringstream fields(line);
+            T x = 0, y = 0, z = 0;
+            char name = '*';
+            if(!(fields >> x >> y >> z)){
+                throw std::runtime_error("Bad point in scene line " + std::to_string(line_number));
+            }
+            fields >> name;
+            polyline.add_point(x, y, z, name);
+        }
+        if(polyline.points_count() != 0){ lines.push_back(std::move(polyline)); }
+        return lines;
+    }
+
+    // A path ending in .obj is read as OBJ, anything else as the plain scene format
+    inline void load_scene_file(const std::string& path, Scene<double>& scene){
+        if(path.ends_with(".obj")){
+            read_obj(path, scene);
+            return;
+        }
+        std::ifstream scene_file(path);
+        if(!scene_file){ throw std::runtime_error("Cannot open scene " + path); }
+        for(Polyline<double>& polyline : load_scene<double>(scene_file)){ scene.insert(std::move(polyline)); }
+    }
+
+    inline std::string frame_path(const std::string& pattern, size_t frame){
+        size_t position = pattern.find("{}");
+        if(position == std::string::npos){ return pattern; }
+        char number[32];
+        std::snprintf(number, sizeof(number), "%04zu", frame);
+        return pattern.substr(0, position) + number + pattern.substr(position + 2);
+    }
+
+    // Where the frames of --render and --view go: one target for all of them, or
+    // a new file for every frame when the output path holds '{}'
+    class FrameOutput{
+    private:
+        std::string path_;
+        FrameFormat format_;
+        std::unique_ptr<RenderTarget> target_{};
+
+    public:
+        FrameOutput(const std::string& path, FrameFormat format) : path_(path), format_(format){
+            if(path_ == "-"){ target_ = std::make_unique<RenderTarget>(STDOUT_FILENO, format_); }
+            else if(path_.find("{}") == std::string::npos){ target_ = std::make_unique<RenderTarget>(path_, format_); }
+        }
+
+        template<size_t height, size_t width>
+        void write(const Buffer<height, width>& buffer, size_t frame){
+            if(target_){
+                target_->write(buffer);
+                return;
+            }
+            RenderTarget(frame_path(path_, frame), format_).write(buffer);
+        }
+    };
+
+    // Draws the lines published by another process straight from shared memory
+    inline void View(const BatchOptions& options){
+        if(!(options.fps > 0)){ throw std::invalid_argument("--fps must be positive"); }
+        SharedSceneReader<double> reader(options.view_name);
+        auto buffer = std::make_unique<Buffer<74, 313>>();
+        if(options.braille){ buffer->set_mode(RenderMode::Braille); }
+        FrameOutput output(options.output, options.format);
+        auto period = std::chrono::duration<double>(1 / options.fps);
+        auto draw = [&buffer](std::span<const Polyline<double>> lines, std::span<const LineId> ids){
+            buffer->clean_buffer();
+            for(size_t i = 0; i < lines.size(); i++){ *buffer << trace_colors[ids[i].index % std::size(trace_colors)] << lines[i]; }
+            *buffer << Color::automatic();
+        };
+        for(size_t frame = 0; options.frames == 0 || frame < options.frames; frame++){
+            while(frame != 0 && reader.published() == reader.sequence()){
+                // Without a frame limit the view ends with the writer
+                if(!reader.writer_alive()){
+                    if(options.frames == 0){ return; }
+                    throw std::runtime_error("The writer of " + options.view_name + " is gone after " + std::to_string(frame) + " frames");
+                }
+                std::this_thread::sleep_for(period);
+            }
+            if(!reader.read(draw)){ throw std::runtime_error("The writer of " + options.view_name + " stopped while publishing"); }
+            output.write(*buffer, frame);
+        }
+    }
+
+    inline void Batch(const BatchOptions& options){
+        if(!options.script_path.empty()){
+            Script(options.script_path);
+            return;
+        }
+        if(!options.play_path.empty()){
+            std::ifstream recording(options.play_path, std::ios::binary);
+            if(!recording){ throw std::runtime_error("Cannot open recording " + options.play_path); }
+            Player(recording).play(STDOUT_FILENO, options.speed);
+            return;
+        }
+        if(!options.view_name.empty()){
+            View(options);
+            return;
+        }
+        Scene<double> scene{};
+        if(!options.serve_path.empty()){
+            if(!options.load_path.empty()){ load_scene_file(options.load_path, scene); }
+            Serve(options.serve_path, std::move(scene), options.files_path);
+            return;
+        }
+        load_scene_file(options.scene_path, scene);
+
+        auto buffer = std::make_unique<Buffer<74, 313>>();
+        if(options.braille){ buffer->set_mode(RenderMode::Braille); }
+        FrameOutput output(options.output, options.format);
+        for(size_t frame = 0; frame < options.frames; frame++){
+            if(frame != 0 && options.orbit != 0){ buffer->camera().orbit(options.orbit, 0); }
+            buffer->clean_buffer();
+            draw_lines(scene, *buffer);
+            output.write(*buffer, frame);
+        }
+    }
+}
+
+#endif
@@ -1,78 +1,110 @@
 #ifndef DIALOGUE_H
 #define DIALOGUE_H
 
+#include <algorithm>
 #include <cstddef>
+#include <iomanip>
+#include <memory>
+#include <optional>
+#include <sstream>
+#include <span>
+#include <string>
+#include <string_view>
 #include <vector>
 #include <Matrix/Matrix.h>
 #include <Polyline/Polyline.h>
+#include <Polyline/Scene.h>
+#include <Polyline/Obj.h>
+#include <Polyline/SharedScene.h>
 #include <Buffer/Buffer.h>
+#include <Buffer/Svg.h>
 #include <Utils/GetNumber.h>
-
-#define GREEN "\033[38;2;0;255;0m"
-#define RED "\033[38;2;255;0;0m"
-#define BLUE "\033[38;2;0;191;255m"
-#define ORANGE "\033[38;2;255;165;0m"
-#define MAGENTA "\033[38;2;255;20;147m"
-#define YELLOW "\033[38;2;255;255;0m"
-#define RESET "\033[0;0m"
+#include <Utils/Colors.h>
+#include <Utils/Profiler.h>
+#include <Dialogue/RenderLoop.h>
+#include <Dialogue/History.h>
+#include <Dialogue/RenderThread.h>
+#include <unistd.h>
 
 namespace DialogueNameSpace {
     using namespace PolylineNameSpace;
     using namespace BufferNameSpace;
     using namespace UtilsNameSpace;
 
+    // Reads line IDs until one names a line of the scene
+    template<Numeric T>
+    LineId get_line_id(const Scene<T>& scene){
+        while(true){
+            std::optional<LineId> id = parse_line_id(get_word());
+            if(id && scene.contains(*id)){ return *id; }
+            std::cout << "Нет линии с таким ID, повторите: ";
+        }
+    }
+
+    // Reads a line ID or a group name and returns the lines it names
+    template<Numeric T>
+    std::vector<LineId> get_targets(const Scene<T>& scene){
+        while(true){
+            std::string word = get_word();
+            std::optional<LineId> id = parse_line_id(word);
+            if(id && scene.contains(*id)){ return {*id}; }
+            std::vector<LineId> ids = scene.group(word);
+            if(!ids.empty()){ return ids; }
+            std::cout << "Нет линии или группы с таким именем, повторите: ";
+        }
+    }
+
     template<Numeric T, size_t height, size_t width>
-    void D_create_popyline(std::vector<Polyline<T>>& lines, __attribute__((unused)) Buffer<height, width>& buffer){
+    void D_create_popyline(Scene<T>& scene, __attribute__((unused)) Buffer<height, width>& buffer, History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
         std::cout << "Введите количество точек ломаной: ";
-        size_t dots_count = get_num(1);
+        size_t dots_count = get_num<size_t>(1);
+        std::cout << "Введите точки в виде \"x y z название\" (по одной на строке, можно вставить списком):" << std::endl;
         Polyline<T> polyline;
+        polyline.resize(std::min<size_t>(dots_count, 1 << 20));
         for(size_t i = 0; i < dots_count; i++){
-            std::cout << "Введите координату x точки " << i+1 << ": ";
-            T x = get_num<T>();
-            std::cout << "Введите координату y точки " << i+1 << ": ";
-            T y = get_num<T>();
-            std::cout << "Введите координату z точки " << i+1 << ": ";
-            T z = get_num<T>();
-            std::cout << "Введите название точки " << i+1 << ": ";
-            char name = get_num<char>('A', 'z');
-            polyline.add_point(x, y, z, name);
+            polyline.add_point(get_point<Point<T>>('A', 'z'));
         }
-        lines.push_back(polyline);
+        history.snapshot(scene, "создание линии");
+        std::cout << "ID новой линии: " << to_string(scene.insert(std::move(polyline))) << std::endl;
     }
 
     template<Numeric T, size_t height, size_t width>
-    void D_shift_polyline(std::vector<Polyline<T>>& lines, __attribute__((unused)) Buffer<height, width>& buffer){
-        if(lines.size() == 0){ std::cout << "Буфер пуст :(" << std::endl; return; }
-        std::cout << "Введите номер линии для сдвига (от 1 до " << lines.size() << "): ";
-        size_t polyline_num = get_num<size_t>(1, lines.size());
+    void D_shift_polyline(Scene<T>& scene, __attribute__((unused)) Buffer<height, width>& buffer, History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        if(scene.empty()){ std::cout << "Буфер пуст :(" << std::endl; return; }
+        std::cout << "Введите ID линии или имя группы для сдвига: ";
+        std::vector<LineId> targets = get_targets(scene);
         std::cout << "Введите сдвиг по x: ";
         double x = get_num<double>();
         std::cout << "Введите сдвиг по y: ";
         double y = get_num<double>();
         std::cout << "Введите сдвиг по z: ";
         double z = get_num<double>();
-        lines[polyline_num - 1].shift(x, y, z);
+        if(targets.size() == 1){ history.record_shift(scene, targets[0], x, y, z); }
+        else{ history.snapshot(scene, "сдвиг группы"); }
+        for(LineId id : targets){ scene.at(id).shift(x, y, z); }
     }
 
     template<Numeric T, size_t height, size_t width>
-    void D_rotate_polyline_from_origin(std::vector<Polyline<T>>& lines, __attribute__((unused)) Buffer<height, width>& buffer){
-        if(lines.size() == 0){ std::cout << "Буфер пуст :(" << std::endl; return; }
-        std::cout << "Введите номер линии для поворота (от 1 до " << lines.size() << "): ";
-        size_t polyline_num = get_num<size_t>(1, lines.size());
+    void D_rotate_polyline_from_origin(Scene<T>& scene, __attribute__((unused)) Buffer<height, width>& buffer, History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        if(scene.empty()){ std::cout << "Буфер пуст :(" << std::endl; return; }
+        std::cout << "Введите ID линии или имя группы для поворота: ";
+        std::vector<LineId> targets = get_targets(scene);
         std::cout << "Введите поворот по x: ";
         double x = get_num<double>();
         std::cout << "Введите поворот по y: ";
         double y = get_num<double>();
         std::cout << "Введите поворот по z: ";
         double z = get_num<double>();
-        lines[polyline_num - 1].rotate_from_origin(x, y, z);
+        if(targets.size() == 1){ history.record_rotate(scene, targets[0], x, y, z); }
+        else{ history.snapshot(scene, "поворот группы"); }
+        for(LineId id : targets){ scene.at(id).rotate_from_origin(x, y, z); }
     }
 
     template<Numeric T, size_t height, size_t width>
-    void D_rotate_polyline_by_vector(std::vector<Polyline<T>>& lines, __attribute__((unused)) Buffer<height, width>& buffer){
-        if(lines.size() == 0){ std::cout << "Буфер пуст :(" << std::endl; return; }
-        std::cout << "Введите номер линии для поворота (от 1 до " << lines.size() << "): ";
-        size_t polyline_num = get_num<size_t>(1, lines.size());
+    void D_rotate_polyline_by_vector(Scene<T>& scene, __attribute__((unused)) Buffer<height, width>& buffer, History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        if(scene.empty()){ std::cout << "Буфер пуст :(" << std::endl; return; }
+        std::cout << "Введите ID линии или имя группы для поворота: ";
+        std::vector<LineId> targets = get_targets(scene);
         std::cout << "Введите координату x начала вектора: ";
         T x1 = get_num<T>();
         std::cout << "Введите координату y начала вектора: ";
@@ -87,48 +119,341 @@ namespace DialogueNameSpace {
         T z2 = get_num<T>();
         std::cout << "Введите угол поворота: ";
         double degree = get_num<double>();
-        lines[polyline_num - 1].rotate_by_vector(Point<T>{x1, y1, z1}, Point<T>{x2, y2, z2}, degree);
+        Point<T> start{x1, y1, z1}, finish{x2, y2, z2};
+        if(targets.size() == 1){ history.record_rotate_by_vector(scene, targets[0], start, finish, degree); }
+        else{ history.snapshot(scene, "поворот группы вокруг оси"); }
+        for(LineId id : targets){ scene.at(id).rotate_by_vector(start, finish, degree); }
+    }
+
+    // Appends line second to line first and erases it; first keeps its ID
+    template<Numeric T>
+    void join_lines(Scene<T>& scene, LineId first, LineId second){
+        scene.at(first).add_polyline(scene.at(second));
+        if(first != second){ scene.erase(second); }
+    }
+
+    template<Numeric T, size_t height, size_t width>
+    void D_join_polyline(Scene<T>& scene, __attribute__((unused)) Buffer<height, width>& buffer, History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        if(scene.empty()){ std::cout << "Буфер пуст :(" << std::endl; return; }
+        std::cout << "Введите ID линии к которой присоединить: ";
+        LineId first = get_line_id(scene);
+        std::cout << "Введите ID линии которую присоединить: ";
+        LineId second = get_line_id(scene);
+        history.snapshot(scene, "объединение линий");
+        join_lines(scene, first, second);
+        std::cout << RED << scene.at(first).points_count() << RESET << std::endl;
     }
 
     template<Numeric T, size_t height, size_t width>
-    void D_join_polyline(std::vector<Polyline<T>>& lines, __attribute__((unused)) Buffer<height, width>& buffer){
-        if(lines.size() == 0){ std::cout << "Буфер пуст :(" << std::endl; return; }
-        std::cout << "Введите номер линии к которой присоединить (от 1 до " << lines.size() << "): ";
-        size_t polyline1_num = get_num<size_t>(1, lines.size());
-        std::cout << "Введите номер линии которую присоединить (от 1 до " << lines.size() << "): ";
-        size_t polyline2_num = get_num<size_t>(1, lines.size());
-        lines[polyline1_num - 1].add_polyline(lines[polyline2_num - 1]);
-        if(polyline1_num != polyline2_num){ lines.erase(lines.begin() + polyline2_num - 1); }
-        std::cout << RED << lines[polyline1_num - 1].points_count() << RESET << std::endl;
+    void D_remove_distant(Scene<T>& scene, __attribute__((unused)) Buffer<height, width>& buffer, History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        if(scene.empty()){ std::cout << "Буфер пуст :(" << std::endl; return; }
+        std::cout << "Введите ID линии: ";
+        LineId id = get_line_id(scene);
+        history.snapshot(scene, "удаление точки");
+        scene.at(id).remove_distant();
     }
 
     template<Numeric T, size_t height, size_t width>
-    void D_remove_distant(std::vector<Polyline<T>>& lines, __attribute__((unused)) Buffer<height, width>& buffer){
-        if(lines.size() == 0){ std::cout << "Буфер пуст :(" << std::endl; return; }
-        std::cout << "Введите номер линии к которой присоединить (от 1 до " << lines.size() << "): ";
-        size_t polyline_num = get_num<size_t>(1, lines.size());
-        lines[polyline_num - 1].remove_distant();
+    void D_print(Scene<T>& scene, Buffer<height, width>& buffer, __attribute__((unused)) History<T>& history, RenderThread<T, height, width>& renderer){
+        std::cout << std::flush;
+        renderer.submit(scene, buffer);
     }
 
     template<Numeric T, size_t height, size_t width>
-    void D_print(std::vector<Polyline<T>>& lines, Buffer<height, width>& buffer){
-        std::for_each(lines.begin(), lines.end(), [&buffer](const Polyline<T>& polyline){
-            buffer << polyline;
-        });
-        std::cout << buffer;
+    void D_clean(Scene<T>& scene, Buffer<height, width>& buffer, History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        if(!scene.empty()){ history.snapshot(scene, "очистка"); }
         buffer.clean_buffer();
+        scene.clear();
+    }
+
+    template<Numeric T, size_t height, size_t width>
+    void D_list(Scene<T>& scene, __attribute__((unused)) Buffer<height, width>& buffer, __attribute__((unused)) History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        if(scene.empty()){ std::cout << "Буфер пуст :(" << std::endl; return; }
+        std::cout << "ID        точек     группа\n";
+        for(size_t i = 0; i < scene.size(); i++){
+            LineId id = scene.id_at(i);
+            std::cout << std::left << std::setw(10) << to_string(id) << std::setw(10) << scene.lines()[i].points_count()
+                      << scene.group_of(id) << "\n" << std::right;
+        }
+        std::cout << std::flush;
     }
 
     template<Numeric T, size_t height, size_t width>
-    void D_clean(__attribute__((unused)) std::vector<Polyline<T>>& lines, Buffer<height, width>& buffer){
+    void D_set_group(Scene<T>& scene, __attribute__((unused)) Buffer<height, width>& buffer, History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        if(scene.empty()){ std::cout << "Буфер пуст :(" << std::endl; return; }
+        std::cout << "Введите ID линии: ";
+        LineId id = get_line_id(scene);
+        std::cout << "Введите имя группы (- чтобы убрать линию из группы): ";
+        std::string group = get_word();
+        history.snapshot(scene, "смена группы");
+        scene.set_group(id, group == "-" ? std::string_view{} : std::string_view(group));
+    }
+
+    template<Numeric T, size_t height, size_t width>
+    void D_import_obj(Scene<T>& scene, __attribute__((unused)) Buffer<height, width>& buffer, History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        std::cout << "Введите путь к OBJ файлу: ";
+        std::string path = get_word();
+        Scene<T> imported = scene;
+        size_t count = 0;
+        // A bad path or file is reported, the session and its scene go on
+        try{
+            count = read_obj(path, imported);
+        }
+        catch(const std::runtime_error& e){
+            std::cout << RED << "Не удалось загрузить: " << e.what() << RESET << std::endl;
+            return;
+        }
+        history.snapshot(scene, "загрузка OBJ");
+        scene = std::move(imported);
+        std::cout << "Загружено линий: " << count << std::endl;
+    }
+
+    template<Numeric T, size_t height, size_t width>
+    void D_export_obj(Scene<T>& scene, __attribute__((unused)) Buffer<height, width>& buffer, __attribute__((unused)) History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        std::cout << "Введите путь к OBJ файлу: ";
+        std::string path = get_word();
+        try{
+            write_obj(scene, path);
+        }
+        catch(const std::runtime_error& e){
+            std::cout << RED << "Не удалось сохранить: " << e.what() << RESET << std::endl;
+            return;
+        }
+        std::cout << "Сохранено линий: " << scene.size() << std::endl;
+    }
+
+    template<Numeric T, size_t height, size_t width>
+    void D_export_svg(Scene<T>& scene, Buffer<height, width>& buffer, __attribute__((unused)) History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        std::cout << "Введите путь к SVG файлу: ";
+        std::string path = get_word();
+        std::vector<Color> colors = line_colors(scene);
+        try{
+            write_svg(path, buffer, scene.lines(), std::span<const Color>(colors));
+        }
+        catch(const std::runtime_error& e){
+            std::cout << RED << "Не удалось сохранить: " << e.what() << RESET << std::endl;
+            return;
+        }
+        std::cout << "Сохранено: " << path << std::endl;
+    }
+
+    template<Numeric T, size_t height, size_t width>
+    void D_undo(Scene<T>& scene, __attribute__((unused)) Buffer<height, width>& buffer, History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        std::optional<std::string> label = history.undo(scene);
+        if(label){ std::cout << "Отменено: " << *label << std::endl; }
+        else{ std::cout << "Нечего отменять" << std::endl; }
+    }
+
+    template<Numeric T, size_t height, size_t width>
+    void D_redo(Scene<T>& scene, __attribute__((unused)) Buffer<height, width>& buffer, History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        std::optional<std::string> label = history.redo(scene);
+        if(label){ std::cout << "Повторено: " << *label << std::endl; }
+        else{ std::cout << "Нечего повторять" << std::endl; }
+    }
+
+    template<Numeric T, size_t height, size_t width>
+    void D_switch_mode(__attribute__((unused)) Scene<T>& scene, Buffer<height, width>& buffer, __attribute__((unused)) History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        if(buffer.get_mode() == RenderMode::Ascii){
+            buffer.set_mode(RenderMode::Braille);
+            std::cout << "Режим отрисовки: шрифт Брайля" << std::endl;
+        }
+        else{
+            buffer.set_mode(RenderMode::Ascii);
+            std::cout << "Режим отрисовки: ASCII" << std::endl;
+        }
+    }
+
+    template<Numeric T, size_t height, size_t width>
+    void D_camera(__attribute__((unused)) Scene<T>& scene, Buffer<height, width>& buffer, __attribute__((unused)) History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        size_t viewports = buffer.viewports().size();
+        if(viewports != 0){ std::cout << "Введите номер окна (1 - сверху, 2 - спереди, 3 - сбоку, 4 - изометрия): "; }
+        Camera& camera = viewports == 0 ? buffer.camera() : buffer.viewport_camera(get_num<size_t>(1, viewports) - 1);
+        std::cout << "Настройка камеры:\n1: приближение\n2: сдвиг изображения\n3: облёт вокруг начала координат\n4: переключить перспективу\n5: сбросить камеру\n";
+        std::cout << "Выберите действие: ";
+        int action = get_num(1, 5);
+        if(action == 1){
+            std::cout << "Введите коэффициент приближения (больше 1 - ближе, меньше 1 - дальше): ";
+            camera.zoom(get_num<double>(std::numeric_limits<double>::min()));
+        }
+        else if(action == 2){
+            std::cout << "Введите сдвиг вниз (в символах): ";
+            double rows = get_num<double>();
+            std::cout << "Введите сдвиг вправо (в символах): ";
+            double cols = get_num<double>();
+            camera.pan(rows, cols);
+        }
+        else if(action == 3){
+            std::cout << "Введите поворот вокруг вертикальной оси (в градусах): ";
+            double yaw = get_num<double>();
+            std::cout << "Введите наклон (в градусах): ";
+            double pitch = get_num<double>();
+            camera.orbit(yaw, pitch);
+        }
+        else if(action == 4){
+            bool perspective = camera.get_projection() == Projection::Orthographic;
+            camera.set_projection(perspective ? Projection::Perspective : Projection::Orthographic);
+            std::cout << (perspective ? "Перспективная проекция" : "Ортографическая проекция") << std::endl;
+        }
+        else{
+            camera.reset();
+        }
+        buffer.clean_buffer();
+    }
+
+    template<Numeric T, size_t height, size_t width>
+    void D_switch_viewports(__attribute__((unused)) Scene<T>& scene, Buffer<height, width>& buffer, __attribute__((unused)) History<T>& history, __attribute__((unused)) RenderThread<T, height, width>& renderer){
+        if(buffer.viewports().empty()){
+            buffer.set_viewports(quad_viewports(height, width));
+            std::cout << "Четыре окна: сверху, спереди, сбоку и изометрия" << std::endl;
+        }
+        else{
+            buffer.set_viewports({});
+            std::cout << "Одно окно" << std::endl;
+        }
+    }
+
+    // Not in func_array: the writer outlives the call and publishes after every option
+    template<Numeric T>
+    void D_share(const Scene<T>& scene, std::unique_ptr<SharedSceneWriter<T>>& shared){
+        if(shared){
+            std::cout << "Публикация в " << shared->name() << " остановлена" << std::endl;
+            shared.reset();
+            return;
+        }
+        std::cout << "Введите имя сегмента разделяемой памяти: ";
+        std::string name = get_word();
+        try{
+            shared = std::make_unique<SharedSceneWriter<T>>(name);
+            shared->publish(scene);
+        }
+        catch(const std::runtime_error& e){
+            shared.reset();
+            std::cout << RED << "Не удалось начать публикацию: " << e.what() << RESET << std::endl;
+            return;
+        }
+        std::cout << "Линии публикуются в " << shared->name() << ", просмотр: Main --view " << shared->name() << std::endl;
+    }
+
+    template<Numeric T, size_t height, size_t width>
+    void D_render_loop(Scene<T>& scene, Buffer<height, width>& buffer, __attribute__((unused)) History<T>& history, RenderThread<T, height, width>& renderer){
+        RenderLoopOptions options;
+        std::cout << "Введите частоту кадров (от 1 до 240): ";
+        options.fps = get_num<double>(1, 240);
+        std::cout << "Введите количество кадров: ";
+        options.frames = get_num<size_t>(1);
+        std::cout << "Введите скорость вращения вокруг оси X (градусов в секунду): ";
+        options.x_speed = get_num<double>();
+        std::cout << "Введите скорость вращения вокруг оси Y (градусов в секунду): ";
+        options.y_speed = get_num<double>();
+        std::cout << "Введите скорость вращения вокруг оси Z (градусов в секунду): ";
+        options.z_speed = get_num<double>();
+        std::cout << "Введите группу вращаемых линий, остальные стоят на месте (- чтобы вращать все): ";
+        std::string group = get_word();
+        // Colors follow the identifiers as in draw_lines: rotating lines first, then the still ones
+        std::vector<Polyline<T>> moving{}, still{};
+        std::vector<Color> moving_colors{}, still_colors{};
+        std::vector<Color> colors = line_colors(scene);
+        for(size_t i = 0; i < scene.size(); i++){
+            bool rotates = group == "-" || scene.group_of(scene.id_at(i)) == group;
+            (rotates ? moving : still).push_back(scene.lines()[i]);
+            (rotates ? moving_colors : still_colors).push_back(colors[i]);
+        }
+        moving_colors.insert(moving_colors.end(), still_colors.begin(), still_colors.end());
+        std::cout << "Пропускать кадры и упрощать линии при нехватке времени? (1 - да, 0 - нет): ";
+        options.adaptive = get_num(0, 1) == 1;
+        std::cout << "Записать анимацию в файл session.cast? (1 - да, 0 - нет): ";
+        std::unique_ptr<Recorder> recorder{};
+        if(get_num(0, 1) == 1){ recorder = std::make_unique<Recorder>("session.cast"); }
+        std::cout << std::flush;
+        // The animation takes over the terminal, so let the last frame finish first
+        renderer.wait_idle();
+
+        RenderLoopReport report = run_render_loop(moving, buffer, std::span<const Color>(moving_colors), options, STDOUT_FILENO, recorder.get(), still);
         buffer.clean_buffer();
-        lines.clear();
+
+        std::cout << "\nКадров выведено: " << report.rendered << ", пропущено: " << report.skipped
+                  << ", упрощено: " << report.degraded << " (наибольший шаг прореживания " << report.max_stride << ")\n";
+        std::cout << "Этап          p50 (мс)   p99 (мс)   max (мс)\n" << std::fixed << std::setprecision(3);
+        auto print_stage = [](const char* name, const LatencyStats& stats){
+            std::cout << std::left << std::setw(12) << name << std::right << std::setw(10) << stats.percentile(50)
+                      << std::setw(11) << stats.percentile(99) << std::setw(11) << stats.max() << "\n";
+        };
+        print_stage("projection", report.projection);
+        print_stage("raster", report.rasterization);
+        print_stage("output", report.output);
+        print_stage("frame", report.frame);
+        std::cout << std::defaultfloat << std::flush;
+    }
+
+    // Totals, counters and log2 histograms of one profile sample
+    inline void print_profile(const char* title, const ProfileSample& sample){
+        static constexpr const char* stage_names[profile_stages] = {"projection", "raster", "transform", "encode", "output"};
+        static constexpr const char* counter_names[profile_counters] = {"точек спроецировано", "клеток проверено", "проверок расстояния",
+                                                                        "клеток нарисовано", "точек преобразовано", "байт выведено"};
+        auto duration = [](double nanoseconds){
+            std::ostringstream text;
+            text << std::fixed << std::setprecision(nanoseconds < 1000 ? 0 : 1);
+            if(nanoseconds < 1000){ text << nanoseconds << " нс"; }
+            else if(nanoseconds < 1e6){ text << nanoseconds / 1e3 << " мкс"; }
+            else{ text << nanoseconds / 1e6 << " мс"; }
+            return text.str();
+        };
+        std::cout << MAGENTA << title << RESET << "\n";
+        std::cout << "Этап          вызовов    всего (мс)   среднее\n" << std::fixed << std::setprecision(3);
+        for(size_t i = 0; i < profile_stages; i++){
+            ProfileStage stage = static_cast<ProfileStage>(i);
+            uint64_t calls = sample.calls(stage);
+            double total = static_cast<double>(sample.time(stage).count());
+            std::cout << std::left << std::setw(12) << stage_names[i] << std::right << std::setw(9) << calls
+                      << std::setw(14) << total / 1e6 << "   " << (calls == 0 ? "-" : duration(total / static_cast<double>(calls))) << "\n";
+        }
+        for(size_t i = 0; i < profile_counters; i++){
+            std::cout << counter_names[i] << ": " << sample.count(static_cast<ProfileCounter>(i)) << "\n";
+        }
+        for(size_t i = 0; i < profile_stages; i++){
+            ProfileStage stage = static_cast<ProfileStage>(i);
+            if(sample.calls(stage) == 0){ continue; }
+            uint64_t largest = 0;
+            for(size_t bucket = 0; bucket < profile_buckets; bucket++){ largest = std::max(largest, sample.bucket(stage, bucket)); }
+            std::cout << "Распределение " << stage_names[i] << ":\n";
+            for(size_t bucket = 0; bucket < profile_buckets; bucket++){
+                uint64_t calls = sample.bucket(stage, bucket);
+                if(calls == 0){ continue; }
+                // Padded by characters, not bytes: the units are in Cyrillic
+                std::string from = duration(static_cast<double>(uint64_t{1} << bucket));
+                size_t characters = static_cast<size_t>(std::count_if(from.begin(), from.end(), [](char c){ return (c & 0xC0) != 0x80; }));
+                std::cout << "  от " << from << std::string(characters < 12 ? 12 - characters : 1, ' ')
+                          << std::string(static_cast<size_t>((calls * 40 + largest - 1) / largest), '#') << " " << calls << "\n";
+            }
+        }
+        std::cout << std::defaultfloat;
+    }
+
+    // Not in func_array: it needs only the render thread
+    template<Numeric T, size_t height, size_t width>
+    void D_profile(RenderThread<T, height, width>& renderer){
+        if constexpr(!profiling_enabled){
+            std::cout << "Профилирование не собрано в программу, пересоберите с cmake -DPROFILING=ON" << std::endl;
+            return;
+        }
+        // The last frame is drawn by the render thread
+        renderer.wait_idle();
+        print_profile("Последний кадр", Profiler::last_frame());
+        std::cout << "\n";
+        print_profile("Вся сессия", Profiler::session());
+        std::cout << "Сбросить статистику сессии? (1 - да, 0 - нет): ";
+        if(get_num(0, 1) == 1){ Profiler::reset(); }
     }
 
     void Dialogue(){
-        void (*func_array[])(std::vector<Polyline<double>>&, Buffer<74, 313>&) = {D_create_popyline, D_shift_polyline, D_rotate_polyline_from_origin, D_rotate_polyline_by_vector, D_join_polyline, D_remove_distant, D_print, D_clean};
+        void (*func_array[])(Scene<double>&, Buffer<74, 313>&, History<double>&, RenderThread<double, 74, 313>&) = {D_create_popyline, D_shift_polyline, D_rotate_polyline_from_origin, D_rotate_polyline_by_vector, D_join_polyline, D_remove_distant, D_print, D_clean, D_switch_mode, D_camera, D_render_loop, D_switch_viewports, D_undo, D_redo, D_list, D_set_group, D_import_obj, D_export_obj, D_export_svg};
         Buffer<74, 313> buffer;
-        std::vector<Polyline<double>> lines{};
+        Scene<double> scene{};
+        History<double> history;
+        RenderThread<double, 74, 313> renderer;
+        // Menu text goes through the render thread, so frames never land between a prompt and its answer
+        StreamRedirect console(std::cout, renderer.console());
+        std::unique_ptr<SharedSceneWriter<double>> shared{};
         int option = -1;
 	    do{
             std::cout << MAGENTA << "\n\n---------- МЕНЮ ----------\nВозможные команды:\n\n" << RESET;
@@ -140,10 +465,23 @@ namespace DialogueNameSpace {
             std::cout << RED << "6: Удаление из линии точки, которая находится от своих соседей дальше всего\n" << RESET;
             std::cout << BLUE << "7: Вывод всех линий в трёхмерном виде в консоль\n" << RESET;
             std::cout << ORANGE << "8: Очистить буфер\n" << RESET;
+            std::cout << BLUE << "9: Переключить режим отрисовки (ASCII / шрифт Брайля)\n" << RESET;
+            std::cout << BLUE << "10: Настройка камеры (приближение, сдвиг, облёт, перспектива)\n" << RESET;
+            std::cout << BLUE << "11: Анимация с заданной частотой кадров и статистикой времени кадра\n" << RESET;
+            std::cout << BLUE << "12: Переключить вид (одно окно / четыре проекции)\n" << RESET;
+            std::cout << ORANGE << "13: Отменить последнее изменение линий\n" << RESET;
+            std::cout << ORANGE << "14: Повторить отменённое изменение\n" << RESET;
+            std::cout << GREEN << "15: Список линий с их ID и группами\n" << RESET;
+            std::cout << GREEN << "16: Назначить линии группу\n" << RESET;
+            std::cout << GREEN << "17: Загрузить линии из OBJ файла\n" << RESET;
+            std::cout << GREEN << "18: Сохранить линии в OBJ файл\n" << RESET;
+            std::cout << BLUE << "19: Сохранить изображение в векторном формате SVG\n" << RESET;
+            std::cout << GREEN << "20: Публиковать линии в разделяемой памяти для других процессов (вкл / выкл)\n" << RESET;
+            std::cout << BLUE << "21: Профиль отрисовки: время этапов, счётчики и гистограммы за кадр и за сессию\n" << RESET;
             std::cout << RED << "\n0: завершение программы\n\n" << RESET;
             std::cout << MAGENTA << "Выберите опцию: " << RESET;
             try {
-                option = get_num(0, 8);
+                option = get_num(0, 21);
             }
             catch(const std::runtime_error& e){
                 std::cerr << "Input failed: " << RED << e.what() << RESET << std::endl;
@@ -154,7 +492,19 @@ namespace DialogueNameSpace {
             if(option == 0){ return; }
 
             try {
-                func_array[option-1](lines, buffer);
+                if(option == 20){ D_share(scene, shared); }
+                else if(option == 21){ D_profile(renderer); }
+                else{ func_array[option-1](scene, buffer, history, renderer); }
+                if(shared){
+                    // A segment that cannot grow stops the publishing, not the session
+                    try{
+                        shared->publish(scene);
+                    }
+                    catch(const std::runtime_error& e){
+                        std::cout << RED << "Публикация в " << shared->name() << " остановлена: " << e.what() << RESET << std::endl;
+                        shared.reset();
+                    }
+                }
             }
             catch(const std::exception& e){
                 std::cerr << "Something went wrong: " << RED << e.what() << RESET << std::endl;
@@ -0,0 +1,123 @@
+#ifndef HISTORY_H
+#define HISTORY_H
+
+#include <cstddef>
+#include <deque>
+#include <optional>
+#include <string>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <Polyline/Polyline.h>
+#include <Polyline/Scene.h>
+
+namespace DialogueNameSpace {
+    using namespace PolylineNameSpace;
+
+    // Undo/redo of edits to a scene. Structural edits keep a snapshot of the whole
+    // scene, which is cheap because polylines share their points until written;
+    // floating point transforms are kept as operations and undone by their inverse.
+    template<Numeric T>
+    class History{
+    private:
+        enum class Kind{ Scene, Shift, Rotate, RotateAxis };
+
+        struct Entry{
+            Kind kind = Kind::Scene;
+            std::string label{};
+            Scene<T> scene{};
+            LineId line{};
+            double x = 0, y = 0, z = 0;
+            Point<T> start{}, finish{};
+        };
+
+        // Shifting or rotating integer points rounds them, so the inverse would not restore them
+        static constexpr bool invertible = std::is_floating_point_v<T>;
+
+        std::deque<Entry> undo_{};
+        std::vector<Entry> redo_{};
+        size_t limit_;
+
+        void push(Entry&& entry){
+            redo_.clear();
+            undo_.push_back(std::move(entry));
+            if(undo_.size() > limit_){ undo_.pop_front(); }
+        }
+
+        static void apply(Entry& entry, Scene<T>& scene, bool forward){
+            double sign = forward ? 1 : -1;
+            switch(entry.kind){
+            case Kind::Scene:
+                std::swap(entry.scene, scene);
+                break;
+            case Kind::Shift:
+                scene.at(entry.line).shift(sign * entry.x, sign * entry.y, sign * entry.z);
+                break;
+            case Kind::Rotate:
+                if(forward){ scene.at(entry.line).rotate_from_origin(entry.x, entry.y, entry.z); }
+                else{
+                    scene.at(entry.line).rotate_from_origin(0, 0, -entry.z);
+                    scene.at(entry.line).rotate_from_origin(0, -entry.y, 0);
+                    scene.at(entry.line).rotate_from_origin(-entry.x, 0, 0);
+                }
+                break;
+            case Kind::RotateAxis:
+                scene.at(entry.line).rotate_by_vector(entry.start, entry.finish, sign * entry.x);
+                break;
+            }
+        }
+
+        static std::optional<std::string> move_entry(auto& from, auto& to, Scene<T>& scene, bool forward){
+            if(from.empty()){ return std::nullopt; }
+            Entry entry = std::move(from.back());
+            from.pop_back();
+            apply(entry, scene, forward);
+            std::string label = entry.label;
+            to.push_back(std::move(entry));
+            return label;
+        }
+
+    public:
+        explicit History(size_t limit = 100) : limit_(limit){}
+
+        // Call before an edit that adds, removes or reorders lines
+        void snapshot(const Scene<T>& scene, std::string label){
+            push(Entry{Kind::Scene, std::move(label), scene});
+        }
+
+        // The record_* calls go before the transform they describe
+        void record_shift(const Scene<T>& scene, LineId line, double x, double y, double z){
+            if constexpr(!invertible){ snapshot(scene, "сдвиг"); }
+            else{ push(Entry{Kind::Shift, "сдвиг", {}, line, x, y, z}); }
+        }
+
+        void record_rotate(const Scene<T>& scene, LineId line, double x, double y, double z){
+            if constexpr(!invertible){ snapshot(scene, "поворот"); }
+            else{ push(Entry{Kind::Rotate, "поворот", {}, line, x, y, z}); }
+        }
+
+        void record_rotate_by_vector(const Scene<T>& scene, LineId line, const Point<T>& start, const Point<T>& finish, double degree){
+            if constexpr(!invertible){ snapshot(scene, "поворот вокруг оси"); }
+            else{ push(Entry{Kind::RotateAxis, "поворот вокруг оси", {}, line, degree, 0, 0, start, finish}); }
+        }
+
+        // Return the label of the reverted edit, or nothing if there is none
+        std::optional<std::string> undo(Scene<T>& scene){
+            return move_entry(undo_, redo_, scene, false);
+        }
+
+        std::optional<std::string> redo(Scene<T>& scene){
+            return move_entry(redo_, undo_, scene, true);
+        }
+
+        size_t undo_count() const{ return undo_.size(); }
+        size_t redo_count() const{ return redo_.size(); }
+
+        void clear(){
+            undo_.clear();
+            redo_.clear();
+        }
+    };
+}
+
+#endif
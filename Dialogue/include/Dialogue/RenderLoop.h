@@ -0,0 +1,170 @@
+#ifndef RENDERLOOP_H
+#define RENDERLOOP_H
+
+#include <algorithm>
+#include <chrono>
+#include <cstddef>
+#include <span>
+#include <string>
+#include <thread>
+#include <vector>
+#include <Polyline/Polyline.h>
+#include <Polyline/Scene.h>
+#include <Buffer/Buffer.h>
+#include <Buffer/RenderTarget.h>
+#include <Buffer/Recording.h>
+#include <Buffer/Transform.h>
+#include <Utils/FrameStats.h>
+#include <Utils/Profiler.h>
+
+namespace DialogueNameSpace {
+    using namespace PolylineNameSpace;
+    using namespace BufferNameSpace;
+    using namespace UtilsNameSpace;
+
+    struct RenderLoopOptions{
+        double fps = 30;
+        size_t frames = 300;
+        double x_speed = 0; // degrees per second
+        double y_speed = 0;
+        double z_speed = 30;
+        bool adaptive = true; // drop late frames and lower the level of detail on overruns
+        size_t max_stride = 16; // coarsest level of detail: every max_stride-th point
+    };
+
+    struct RenderLoopReport{
+        LatencyStats projection{};
+        LatencyStats rasterization{};
+        LatencyStats output{};
+        LatencyStats frame{};
+        size_t rendered = 0;
+        size_t skipped = 0;
+        size_t degraded = 0;
+        size_t max_stride = 1;
+    };
+
+    constexpr Color trace_colors[] = {
+        Color::rgb(0, 255, 0), Color::rgb(255, 165, 0), Color::rgb(255, 20, 147),
+        Color::rgb(255, 255, 0), Color::rgb(0, 191, 255), Color::rgb(190, 120, 255)
+    };
+
+    template<Numeric T, size_t height, size_t width>
+    void draw_lines(const std::vector<Polyline<T>>& lines, Buffer<height, width>& buffer){
+        for(size_t i = 0; i < lines.size(); i++){
+            buffer << trace_colors[i % std::size(trace_colors)];
+            buffer.draw_cached(lines[i]);
+        }
+        buffer << Color::automatic();
+    }
+
+    // Colors follow the identifiers, so erasing a line does not recolor the others
+    template<Numeric T, size_t height, size_t width>
+    void draw_lines(const Scene<T>& scene, Buffer<height, width>& buffer){
+        for(size_t i = 0; i < scene.size(); i++){
+            buffer << trace_colors[scene.id_at(i).index % std::size(trace_colors)];
+            buffer.draw_cached(scene.lines()[i]);
+        }
+        buffer << Color::automatic();
+    }
+
+    // The colors draw_lines gives the lines of a scene, in storage order
+    template<Numeric T>
+    std::vector<Color> line_colors(const Scene<T>& scene){
+        std::vector<Color> colors(scene.size());
+        for(size_t i = 0; i < scene.size(); i++){ colors[i] = trace_colors[scene.id_at(i).index % std::size(trace_colors)]; }
+        return colors;
+    }
+
+    template<Numeric T>
+    Polyline<T> decimate(const Polyline<T>& polyline, size_t stride){
+        Polyline<T> result;
+        size_t size = polyline.points_count();
+        for(size_t i = 0; i < size; i += stride){
+            result.add_point(polyline[i]);
+        }
+        if(size != 0 && (size - 1) % stride != 0){ result.add_point(polyline[size - 1]); }
+        return result;
+    }
+
+    // scenery stays still and is drawn on Layer::Static, only when a view camera or the
+    // mode changed; so are the lines when no rotation speed is set. Colors go on from
+    // the lines to the scenery.
+    template<Numeric T, size_t height, size_t width>
+    RenderLoopReport run_render_loop(const std::vector<Polyline<T>>& lines, Buffer<height, width>& buffer, std::span<const Color> colors, const RenderLoopOptions& options, int fd, Recorder* recorder = nullptr, const std::vector<Polyline<T>>& scenery = {}){
+        using clock = std::chrono::steady_clock;
+        RenderLoopReport report;
+        bool rotating = options.x_speed != 0 || options.y_speed != 0 || options.z_speed != 0;
+        auto select_color = [&buffer, colors](size_t i){
+            if(!colors.empty()){ buffer << colors[i % colors.size()]; }
+        };
+        auto budget = std::chrono::duration_cast<clock::duration>(std::chrono::duration<double>(1.0 / options.fps));
+        size_t stride = 1;
+        std::vector<Polyline<T>> reduced{};
+        std::string frame_text;
+        write_all(fd, "\033[2J");
+        auto start = clock::now();
+        for(size_t frame = 0; frame < options.frames; frame++){
+            auto scheduled = start + budget * static_cast<long>(frame);
+            if(options.adaptive && clock::now() >= scheduled + budget){
+                report.skipped++;
+                continue;
+            }
+            double seconds = std::chrono::duration<double>(scheduled - start).count();
+            Transform transform = rotation(options.x_speed * seconds, options.y_speed * seconds, options.z_speed * seconds);
+
+            auto frame_start = clock::now();
+            buffer.reset_stage_times();
+            if(buffer.clean_dynamic()){
+                buffer << Layer::Static;
+                for(size_t i = 0; i < scenery.size(); i++){
+                    select_color(lines.size() + i);
+                    buffer << scenery[i];
+                }
+                for(size_t i = 0; !rotating && i < lines.size(); i++){
+                    select_color(i);
+                    buffer << lines[i];
+                }
+                buffer << Layer::Dynamic;
+            }
+            const std::vector<Polyline<T>>& drawn = stride == 1 ? lines : reduced;
+            for(size_t i = 0; rotating && i < drawn.size(); i++){
+                select_color(i);
+                buffer.draw_instances(drawn[i], std::span<const Transform>(&transform, 1));
+            }
+            buffer << Color::automatic();
+
+            auto output_start = clock::now();
+            frame_text.assign("\033[H");
+            buffer.encode(frame_text);
+            write_all(fd, frame_text);
+            if(recorder){ recorder->record(buffer, seconds); }
+            UtilsNameSpace::Profiler::frame();
+            auto frame_end = clock::now();
+
+            report.projection.add(to_milliseconds(buffer.stage_times().projection));
+            report.rasterization.add(to_milliseconds(buffer.stage_times().rasterization));
+            report.output.add(to_milliseconds(frame_end - output_start));
+            report.frame.add(to_milliseconds(frame_end - frame_start));
+            report.rendered++;
+            if(stride != 1){ report.degraded++; }
+
+            if(options.adaptive){
+                size_t next_stride = stride;
+                if(frame_end - frame_start > budget){ next_stride = std::min(stride * 2, std::max<size_t>(options.max_stride, 1)); }
+                else if(stride > 1 && (frame_end - frame_start) * 2 < budget){ next_stride = stride / 2; }
+                if(next_stride != stride){
+                    stride = next_stride;
+                    reduced.clear();
+                    if(stride != 1){
+                        for(const Polyline<T>& polyline : lines){ reduced.push_back(decimate(polyline, stride)); }
+                    }
+                    report.max_stride = std::max(report.max_stride, stride);
+                }
+            }
+            std::this_thread::sleep_until(scheduled + budget);
+        }
+        return report;
+    }
+}
+
+#endif
@@ -0,0 +1,223 @@
+#ifndef RENDERTHREAD_H
+#define RENDERTHREAD_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <utility>
+#include <vector>
+#include <Polyline/Polyline.h>
+#include <Polyline/Scene.h>
+#include <Buffer/Buffer.h>
+#include <Buffer/RenderTarget.h>
+#include <Utils/Mailbox.h>
+#include <Utils/Profiler.h>
+#include <Dialogue/RenderLoop.h>
+#include <unistd.h>
+
+namespace DialogueNameSpace {
+    using namespace PolylineNameSpace;
+    using namespace BufferNameSpace;
+    using namespace UtilsNameSpace;
+
+    // Sends a stream through another buffer until the end of the scope
+    class StreamRedirect{
+    private:
+        std::ostream& stream_;
+        std::streambuf* previous_;
+
+    public:
+        StreamRedirect(std::ostream& stream, std::streambuf& buffer) : stream_(stream), previous_(stream.rdbuf(&buffer)){}
+
+        StreamRedirect(const StreamRedirect&) = delete;
+        StreamRedirect& operator=(const StreamRedirect&) = delete;
+
+        ~StreamRedirect(){
+            stream_.flush();
+            stream_.rdbuf(previous_);
+        }
+    };
+
+    // Draws and prints scenes on a thread of its own. submit() only copies the scene
+    // (the polylines share their points) and never waits for the terminal; scenes
+    // submitted while a frame is being printed replace each other, so only the newest
+    // one is drawn next.
+    //
+    // The thread owns its output: console text sent through console() is written
+    // between frames, and its unfinished last line (the question waiting for an
+    // answer) is written again after every frame, so the prompt stays below the
+    // picture without the input thread ever waiting for a frame.
+    template<Numeric T, size_t height, size_t width>
+    class RenderThread{
+    private:
+        struct Snapshot{
+            Scene<T> scene{};
+            Camera camera{};
+            RenderMode mode = RenderMode::Ascii;
+            std::vector<Viewport> viewports{};
+            uint64_t sequence = 0;
+        };
+
+        class Console : public std::streambuf{
+        private:
+            RenderThread& owner_;
+            std::string pending_{};
+
+        protected:
+            int_type overflow(int_type c) override{
+                if(!traits_type::eq_int_type(c, traits_type::eof())){ pending_ += traits_type::to_char_type(c); }
+                return traits_type::not_eof(c);
+            }
+
+            std::streamsize xsputn(const char* text, std::streamsize count) override{
+                pending_.append(text, static_cast<size_t>(count));
+                return count;
+            }
+
+            int sync() override{
+                try{ owner_.print(pending_); }
+                catch(const std::exception&){ return -1; }
+                pending_.clear();
+                return 0;
+            }
+
+        public:
+            explicit Console(RenderThread& owner) : owner_(owner){}
+        };
+
+        Mailbox<Snapshot> mailbox_{};
+        std::unique_ptr<Buffer<height, width>> buffer_ = std::make_unique<Buffer<height, width>>();
+        std::string frame_{};
+        int fd_;
+        std::mutex output_mutex_{}; // orders frames and console text on fd_
+        std::string prompt_{}; // unfinished last console line, written again after every frame
+        Console console_{*this};
+        uint64_t submitted_ = 0;
+        std::atomic<uint64_t> done_{0}; // sequence of the last scene printed
+        std::atomic<uint64_t> rendered_{0};
+        std::exception_ptr error_{}; // written before done_ by the render thread
+        std::atomic<bool> failed_{false};
+        std::jthread thread_{}; // last, so it is joined before the rest is destroyed
+
+        static bool same_areas(const std::vector<Viewport>& first, const std::vector<Viewport>& second){
+            if(first.size() != second.size()){ return false; }
+            for(size_t i = 0; i < first.size(); i++){
+                const Tile& a = first[i].area;
+                const Tile& b = second[i].area;
+                if(a.row_begin != b.row_begin || a.row_end != b.row_end || a.col_begin != b.col_begin || a.col_end != b.col_end){ return false; }
+            }
+            return true;
+        }
+
+        void render(Snapshot& snapshot){
+            Buffer<height, width>& buffer = *buffer_;
+            if(buffer.get_mode() != snapshot.mode){ buffer.set_mode(snapshot.mode); }
+            if(!same_areas(buffer.viewports(), snapshot.viewports)){ buffer.set_viewports(snapshot.viewports); }
+            else{
+                for(size_t i = 0; i < snapshot.viewports.size(); i++){ buffer.viewport_camera(i) = snapshot.viewports[i].camera; }
+            }
+            buffer.camera() = snapshot.camera;
+            buffer.clean_buffer();
+            draw_lines(snapshot.scene, buffer);
+            frame_.clear();
+            buffer.encode(frame_);
+            {
+                std::lock_guard lock(output_mutex_);
+                frame_ += prompt_;
+                write_all(fd_, frame_);
+            }
+            UtilsNameSpace::Profiler::frame();
+            // Let the input thread write to the points again without copying them
+            snapshot.scene.clear();
+        }
+
+        void run(){
+            while(mailbox_.take()){
+                Snapshot& snapshot = mailbox_.front();
+                try{
+                    render(snapshot);
+                    rendered_.fetch_add(1, std::memory_order_relaxed);
+                }
+                catch(...){
+                    snapshot.scene.clear();
+                    if(!failed_.load(std::memory_order_relaxed)){
+                        error_ = std::current_exception();
+                        failed_.store(true, std::memory_order_release);
+                    }
+                }
+                done_.store(snapshot.sequence, std::memory_order_release);
+                done_.notify_all();
+            }
+        }
+
+        void print(std::string_view text){
+            std::lock_guard lock(output_mutex_);
+            write_all(fd_, text);
+            size_t line_end = text.rfind('\n');
+            if(line_end == std::string_view::npos){ prompt_.append(text); }
+            else{ prompt_.assign(text.substr(line_end + 1)); }
+        }
+
+        void rethrow_failure(){
+            if(failed_.load(std::memory_order_acquire) && error_){
+                std::exception_ptr error = std::exchange(error_, nullptr);
+                std::rethrow_exception(error);
+            }
+        }
+
+    public:
+        explicit RenderThread(int fd = STDOUT_FILENO) : fd_(fd){
+            thread_ = std::jthread([this]{ run(); });
+        }
+
+        RenderThread(const RenderThread&) = delete;
+        RenderThread& operator=(const RenderThread&) = delete;
+
+        // Prints the scenes still waiting, then stops the thread
+        ~RenderThread(){
+            mailbox_.close();
+        }
+
+        // Throws the first error of the render thread, if any
+        void submit(const Scene<T>& scene, const Buffer<height, width>& settings){
+            rethrow_failure();
+            Snapshot& snapshot = mailbox_.back();
+            snapshot.scene = scene;
+            snapshot.camera = settings.camera();
+            snapshot.mode = settings.get_mode();
+            snapshot.viewports = settings.viewports();
+            snapshot.sequence = ++submitted_;
+            mailbox_.publish();
+            // The slot got back may hold a dropped scene; release its points right away
+            mailbox_.back().scene.clear();
+        }
+
+        // Blocks until the last submitted scene is printed
+        void wait_idle(){
+            for(uint64_t done = done_.load(std::memory_order_acquire); done < submitted_; done = done_.load(std::memory_order_acquire)){
+                done_.wait(done, std::memory_order_acquire);
+            }
+            rethrow_failure();
+        }
+
+        // Console text written in order with the frames; flush it to have it written
+        std::streambuf& console(){ return console_; }
+
+        uint64_t submitted() const{ return submitted_; }
+        uint64_t rendered() const{ return rendered_.load(std::memory_order_relaxed); }
+
+        // Projection cache of the render thread; read only after wait_idle()
+        size_t cached_projections() const{ return buffer_->cached_projections(); }
+        size_t projection_cache_hits() const{ return buffer_->projection_cache_hits(); }
+    };
+}
+
+#endif
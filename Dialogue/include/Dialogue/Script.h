@@ -0,0 +1,258 @@
+#ifndef SCRIPT_H
+#define SCRIPT_H
+
+#include <charconv>
+#include <cstddef>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <Polyline/Polyline.h>
+#include <Polyline/Scene.h>
+#include <Polyline/Obj.h>
+#include <Buffer/Buffer.h>
+#include <Buffer/RenderTarget.h>
+#include <Buffer/Svg.h>
+#include <Dialogue/Dialogue.h>
+#include <unistd.h>
+
+namespace DialogueNameSpace {
+    struct ScriptCommand{
+        std::vector<std::string_view> tokens{};
+        size_t line = 0;
+
+        [[noreturn]] void fail(const std::string& message) const{
+            throw std::runtime_error("Script line " + std::to_string(line) + ": " + message);
+        }
+
+        void expect_arguments(size_t min, size_t max) const{
+            if(tokens.size() < min + 1 || tokens.size() > max + 1){
+                fail("wrong number of arguments for " + std::string(tokens[0]));
+            }
+        }
+
+        template<typename T>
+        T number(size_t index, T min = std::numeric_limits<T>::lowest(), T max = std::numeric_limits<T>::max()) const{
+            std::string_view token = tokens[index];
+            T value{};
+            auto [end, error] = std::from_chars(token.data(), token.data() + token.size(), value);
+            if(error != std::errc{} || end != token.data() + token.size() || value < min || value > max){
+                fail("bad number '" + std::string(token) + "'");
+            }
+            return value;
+        }
+
+        template<Numeric T>
+        LineId line_id(size_t index, const Scene<T>& scene) const{
+            std::optional<LineId> id = parse_line_id(tokens[index]);
+            if(!id || !scene.contains(*id)){ fail("no line with ID '" + std::string(tokens[index]) + "'"); }
+            return *id;
+        }
+
+        // A line ID or a group name
+        template<Numeric T>
+        std::vector<LineId> targets(size_t index, const Scene<T>& scene) const{
+            std::optional<LineId> id = parse_line_id(tokens[index]);
+            if(id && scene.contains(*id)){ return {*id}; }
+            std::vector<LineId> ids = scene.group(tokens[index]);
+            if(ids.empty()){ fail("no line or group '" + std::string(tokens[index]) + "'"); }
+            return ids;
+        }
+
+        char name(size_t index) const{
+            std::string_view token = tokens[index];
+            if(token.size() != 1 || token[0] < 'A' || token[0] > 'z'){ fail("bad point name '" + std::string(token) + "'"); }
+            return token[0];
+        }
+    };
+
+    // Splits a line at blanks; '#' starts a comment
+    inline void tokenize(std::string_view text, std::vector<std::string_view>& tokens){
+        tokens.clear();
+        size_t position = 0;
+        while(true){
+            position = text.find_first_not_of(" \t\r", position);
+            if(position == std::string_view::npos || text[position] == '#'){ return; }
+            size_t end = std::min(text.find_first_of(" \t\r", position), text.size());
+            tokens.push_back(text.substr(position, end - position));
+            position = end;
+        }
+    }
+
+    template<size_t height, size_t width>
+    void run_camera_command(const ScriptCommand& command, Buffer<height, width>& buffer){
+        size_t action = 1;
+        Camera* camera = &buffer.camera();
+        if(command.tokens.size() > 1 && command.tokens[1].find_first_not_of("0123456789") == std::string_view::npos){
+            if(buffer.viewports().empty()){ command.fail("there are no viewports"); }
+            camera = &buffer.viewport_camera(command.number<size_t>(1, 1, buffer.viewports().size()) - 1);
+            action = 2;
+        }
+        if(command.tokens.size() <= action){ command.fail("missing camera action"); }
+        std::string_view name = command.tokens[action];
+        size_t arguments = command.tokens.size() - action - 1;
+        auto expect = [&command, arguments](size_t count){
+            if(arguments != count){ command.fail("wrong number of arguments for camera action"); }
+        };
+        if(name == "zoom"){
+            expect(1);
+            camera->zoom(command.number<double>(action + 1, std::numeric_limits<double>::min()));
+        }
+        else if(name == "pan"){
+            expect(2);
+            camera->pan(command.number<double>(action + 1), command.number<double>(action + 2));
+        }
+        else if(name == "orbit"){
+            expect(2);
+            camera->orbit(command.number<double>(action + 1), command.number<double>(action + 2));
+        }
+        else if(name == "perspective"){
+            expect(0);
+            bool perspective = camera->get_projection() == Projection::Orthographic;
+            camera->set_projection(perspective ? Projection::Perspective : Projection::Orthographic);
+        }
+        else if(name == "reset"){
+            expect(0);
+            camera->reset();
+        }
+        else{
+            command.fail("unknown camera action '" + std::string(name) + "'");
+        }
+        buffer.clean_buffer();
+    }
+
+    inline bool is_frame_format(std::string_view token){
+        return token == "ansi" || token == "plain" || token == "pgm" || token == "ppm";
+    }
+
+    template<Numeric T, size_t height, size_t width>
+    void run_render_command(const ScriptCommand& command, const Scene<T>& scene, Buffer<height, width>& buffer, int fd){
+        command.expect_arguments(0, 2);
+        FrameFormat format = FrameFormat::Ansi;
+        std::string path{};
+        for(size_t i = 1; i < command.tokens.size(); i++){
+            std::string_view token = command.tokens[i];
+            if(is_frame_format(token)){ format = frame_format_from_name(token); }
+            else{ path = token; }
+        }
+        draw_lines(scene, buffer);
+        if(path.empty()){ RenderTarget(fd, format).write(buffer); }
+        else{ RenderTarget(path, format).write(buffer); }
+        buffer.clean_buffer();
+    }
+
+    template<Numeric T, size_t height, size_t width>
+    void run_command(const ScriptCommand& command, Scene<T>& scene, Buffer<height, width>& buffer, int fd){
+        std::string_view name = command.tokens[0];
+        size_t arguments = command.tokens.size() - 1;
+        if(name == "create"){
+            if(arguments == 0 || arguments % 4 != 0){ command.fail("create takes points as X Y Z NAME"); }
+            Polyline<T> polyline;
+            polyline.resize(arguments / 4);
+            for(size_t i = 1; i < command.tokens.size(); i += 4){
+                polyline.add_point(command.number<T>(i), command.number<T>(i + 1), command.number<T>(i + 2), command.name(i + 3));
+            }
+            scene.insert(std::move(polyline));
+        }
+        else if(name == "shift"){
+            command.expect_arguments(4, 4);
+            double x = command.number<double>(2), y = command.number<double>(3), z = command.number<double>(4);
+            for(LineId id : command.targets(1, scene)){ scene.at(id).shift(x, y, z); }
+        }
+        else if(name == "rotate" && arguments == 4){
+            double x = command.number<double>(2), y = command.number<double>(3), z = command.number<double>(4);
+            for(LineId id : command.targets(1, scene)){ scene.at(id).rotate_from_origin(x, y, z); }
+        }
+        else if(name == "rotate"){
+            command.expect_arguments(8, 8);
+            Point<T> start{command.number<T>(2), command.number<T>(3), command.number<T>(4)};
+            Point<T> end{command.number<T>(5), command.number<T>(6), command.number<T>(7)};
+            double degree = command.number<double>(8);
+            for(LineId id : command.targets(1, scene)){ scene.at(id).rotate_by_vector(start, end, degree); }
+        }
+        else if(name == "join"){
+            command.expect_arguments(2, 2);
+            join_lines(scene, command.line_id(1, scene), command.line_id(2, scene));
+        }
+        else if(name == "prune"){
+            command.expect_arguments(1, 1);
+            scene.at(command.line_id(1, scene)).remove_distant();
+        }
+        else if(name == "group"){
+            command.expect_arguments(1, 2);
+            scene.set_group(command.line_id(1, scene), command.tokens.size() == 3 ? command.tokens[2] : std::string_view{});
+        }
+        else if(name == "import"){
+            command.expect_arguments(1, 1);
+            read_obj(std::string(command.tokens[1]), scene);
+        }
+        else if(name == "export"){
+            command.expect_arguments(1, 1);
+            write_obj(scene, std::string(command.tokens[1]));
+        }
+        else if(name == "svg"){
+            command.expect_arguments(1, 1);
+            std::vector<Color> colors = line_colors(scene);
+            write_svg(std::string(command.tokens[1]), buffer, scene.lines(), std::span<const Color>(colors));
+        }
+        else if(name == "render"){
+            run_render_command(command, scene, buffer, fd);
+        }
+        else if(name == "clear"){
+            command.expect_arguments(0, 0);
+            buffer.clean_buffer();
+            scene.clear();
+        }
+        else if(name == "mode"){
+            command.expect_arguments(1, 1);
+            if(command.tokens[1] == "ascii"){ buffer.set_mode(RenderMode::Ascii); }
+            else if(command.tokens[1] == "braille"){ buffer.set_mode(RenderMode::Braille); }
+            else{ command.fail("unknown mode '" + std::string(command.tokens[1]) + "'"); }
+        }
+        else if(name == "viewports"){
+            command.expect_arguments(1, 1);
+            if(command.tokens[1] == "single"){ buffer.set_viewports({}); }
+            else if(command.tokens[1] == "quad"){ buffer.set_viewports(quad_viewports(height, width)); }
+            else{ command.fail("unknown viewport layout '" + std::string(command.tokens[1]) + "'"); }
+        }
+        else if(name == "camera"){
+            run_camera_command(command, buffer);
+        }
+        else{
+            command.fail("unknown command '" + std::string(name) + "'");
+        }
+    }
+
+    // Runs the commands of a script without prompts; frames are written to fd
+    template<Numeric T, size_t height, size_t width>
+    void run_script(std::istream& in, Scene<T>& scene, Buffer<height, width>& buffer, int fd = STDOUT_FILENO){
+        ScriptCommand command;
+        std::string text;
+        while(std::getline(in, text)){
+            command.line++;
+            tokenize(text, command.tokens);
+            if(command.tokens.empty()){ continue; }
+            run_command(command, scene, buffer, fd);
+        }
+    }
+
+    inline void Script(const std::string& path){
+        auto buffer = std::make_unique<Buffer<74, 313>>();
+        Scene<double> scene{};
+        if(path == "-"){
+            run_script(std::cin, scene, *buffer);
+            return;
+        }
+        std::ifstream file(path);
+        if(!file){ throw std::runtime_error("Cannot open script " + path); }
+        run_script(file, scene, *buffer);
+    }
+}
+
+#endif
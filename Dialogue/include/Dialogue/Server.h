@@ -0,0 +1,469 @@
+#ifndef SERVER_H
+#define SERVER_H
+
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <memory>
+#include <ranges>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <Polyline/Polyline.h>
+#include <Polyline/Scene.h>
+#include <Buffer/Buffer.h>
+#include <Buffer/Recording.h>
+#include <Dialogue/RenderLoop.h>
+#include <Dialogue/Script.h>
+#include <pthread.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/signalfd.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+namespace DialogueNameSpace {
+    using namespace PolylineNameSpace;
+    using namespace BufferNameSpace;
+
+    // Serves one scene to local clients over a Unix stream socket. Clients send script
+    // commands, one per line; scene commands change the scene of everyone, camera, mode
+    // and viewports only the view of the client that sent them. Every client gets
+    // terminal output for its own frame size ("size ROWS COLS"): a keyframe first, then
+    // only the cells that changed. A client whose output is not read yet is not drawn
+    // for and not read from; once it catches up it gets the newest frame only.
+    // Anyone who can open the socket runs commands as the server user, so the socket
+    // is created with the given mode and file commands only name files in one directory.
+    template<Numeric T, size_t height, size_t width>
+    class RenderServer{
+    private:
+        static constexpr size_t output_limit_ = 1 << 20; // pending bytes that stop reading commands
+        static constexpr size_t line_limit_ = 64 << 20; // longest accepted command
+        static constexpr size_t read_size_ = 64 << 10;
+
+        struct Client{
+            int fd = -1;
+            std::unique_ptr<Buffer<height, width>> buffer = std::make_unique<Buffer<height, width>>();
+            FrameDelta delta{};
+            size_t rows = 0;
+            size_t cols = 0;
+            bool quad = false;
+            bool dirty = true; // the scene or the view changed since the last frame
+            bool keyframe = true;
+            bool eof = false; // the client sent everything; its commands are still run
+            bool quit = false; // no more commands are run; close once everything is sent
+            bool broken = false;
+            uint32_t events = 0; // interest registered with epoll
+            std::string input{};
+            size_t parsed = 0; // bytes of input already executed
+            std::string output{};
+            size_t sent = 0; // bytes of output already written
+            ScriptCommand command{};
+
+            size_t pending() const{ return output.size() - sent; }
+        };
+
+        std::string path_;
+        std::string files_; // directory of import, export, svg and render files; empty refuses them
+        mode_t mode_;
+        std::string file_path_{};
+        int listen_fd_ = -1;
+        int epoll_fd_ = -1;
+        int wake_fd_ = -1;
+        std::vector<int> stop_fds_{};
+        Scene<T> scene_{};
+        std::unordered_map<int, std::unique_ptr<Client>> clients_{};
+        std::string chunk_ = std::string(read_size_, '\0');
+        bool stopping_ = false;
+
+        [[noreturn]] static void fail(const std::string& what){
+            throw std::runtime_error(what + ": " + std::strerror(errno));
+        }
+
+        void watch(int fd, uint32_t events){
+            epoll_event event{};
+            event.events = events;
+            event.data.fd = fd;
+            if(::epoll_ctl(epoll_fd_, EPOLL_CTL_ADD, fd, &event) < 0){ fail("Cannot watch descriptor"); }
+        }
+
+        sockaddr_un address() const{
+            sockaddr_un address{};
+            address.sun_family = AF_UNIX;
+            if(path_.empty() || path_.size() >= sizeof(address.sun_path)){ throw std::invalid_argument("Bad socket path '" + path_ + "'"); }
+            std::memcpy(address.sun_path, path_.c_str(), path_.size() + 1);
+            return address;
+        }
+
+        void listen_on(){
+            sockaddr_un local = address();
+            listen_fd_ = ::socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+            if(listen_fd_ < 0){ fail("Cannot create socket"); }
+            if(::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) < 0){
+                if(errno != EADDRINUSE){ fail("Cannot bind " + path_); }
+                // A socket file nobody listens on is left over from a server that died
+                int probe = ::socket(AF_UNIX, SOCK_STREAM | SOCK_CLOEXEC, 0);
+                bool alive = probe >= 0 && ::connect(probe, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) == 0;
+                if(probe >= 0){ ::close(probe); }
+                if(alive){ throw std::runtime_error("Another server is listening on " + path_); }
+                ::unlink(path_.c_str());
+                if(::bind(listen_fd_, reinterpret_cast<const sockaddr*>(&local), sizeof(local)) < 0){ fail("Cannot bind " + path_); }
+            }
+            // Nobody can connect before listen(), so no client gets in under the default mode
+            if(::chmod(path_.c_str(), mode_) < 0){ fail("Cannot set the mode of " + path_); }
+            if(::listen(listen_fd_, 64) < 0){ fail("Cannot listen on " + path_); }
+        }
+
+        void set_interest(Client& client){
+            uint32_t events = 0;
+            if(!client.eof && !client.quit && client.pending() < output_limit_){ events |= EPOLLIN; }
+            if(client.pending() != 0){ events |= EPOLLOUT; }
+            if(events == client.events){ return; }
+            epoll_event event{};
+            event.events = events;
+            event.data.fd = client.fd;
+            if(::epoll_ctl(epoll_fd_, EPOLL_CTL_MOD, client.fd, &event) < 0){ client.broken = true; }
+            client.events = events;
+        }
+
+        void accept_clients(){
+            while(true){
+                int fd = ::accept4(listen_fd_, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+                if(fd < 0){
+                    if(errno == EINTR || errno == ECONNABORTED){ continue; }
+                    if(errno == EAGAIN || errno == EWOULDBLOCK){ return; }
+                    fail("Cannot accept a client");
+                }
+                auto client = std::make_unique<Client>();
+                client->fd = fd;
+                set_layout(*client, 24, 80, false);
+                client->events = EPOLLIN;
+                watch(fd, client->events);
+                clients_.emplace(fd, std::move(client));
+            }
+        }
+
+        // The whole frame of a single view is one viewport, so its origin is in the
+        // middle of the client's screen rather than of the buffer
+        void set_layout(Client& client, size_t rows, size_t cols, bool quad){
+            std::vector<Viewport> viewports = quad ? quad_viewports(rows, cols) : std::vector<Viewport>{Viewport{Tile{0, rows, 0, cols}, Camera()}};
+            const std::vector<Viewport>& current = client.buffer->viewports();
+            if(client.quad == quad && current.size() == viewports.size()){
+                for(size_t i = 0; i < viewports.size(); i++){ viewports[i].camera = current[i].camera; }
+            }
+            client.buffer->set_viewports(std::move(viewports));
+            client.rows = rows;
+            client.cols = cols;
+            client.quad = quad;
+            client.dirty = true;
+            client.keyframe = true;
+        }
+
+        // The status line is the one under the frame
+        void report(Client& client, std::string_view message){
+            std::string& out = client.output;
+            out += "\033[";
+            append_decimal(out, client.rows + 1);
+            out += ";1H\033[0m\033[2K";
+            out += message;
+            out += '\n';
+        }
+
+        void mark_all_dirty(){
+            for(auto& [fd, client] : clients_){ client->dirty = true; }
+        }
+
+        // File names of clients are taken relative to files_ and may not leave it
+        void confine_file(ScriptCommand& command){
+            std::string name(command.tokens[0]);
+            if(files_.empty()){ command.fail(name + " is disabled; the server was started without a files directory"); }
+            size_t file = 0;
+            for(size_t i = 1; i < command.tokens.size(); i++){
+                if(name == "render" && is_frame_format(command.tokens[i])){ continue; }
+                if(file != 0){ command.fail(name + " takes one file name"); }
+                file = i;
+            }
+            if(file == 0){ return; }
+            std::string_view token = command.tokens[file];
+            if(token == "." || token == ".." || token.find('/') != std::string_view::npos){
+                command.fail("file name '" + std::string(token) + "' is not a plain name in the files directory");
+            }
+            file_path_ = files_ + "/" + std::string(token);
+            command.tokens[file] = file_path_;
+        }
+
+        void execute(Client& client, std::string_view line){
+            ScriptCommand& command = client.command;
+            command.line++;
+            tokenize(line, command.tokens);
+            if(command.tokens.empty()){ return; }
+            std::string_view name = command.tokens[0];
+            if(name == "size"){
+                command.expect_arguments(2, 2);
+                size_t rows = command.number<size_t>(1, 1, height), cols = command.number<size_t>(2, 1, width);
+                set_layout(client, rows, cols, client.quad);
+            }
+            else if(name == "frame"){
+                command.expect_arguments(0, 0);
+                client.dirty = true;
+                client.keyframe = true;
+            }
+            else if(name == "quit"){
+                command.expect_arguments(0, 0);
+                client.quit = true;
+            }
+            else if(name == "viewports"){
+                command.expect_arguments(1, 1);
+                if(command.tokens[1] == "single"){ set_layout(client, client.rows, client.cols, false); }
+                else if(command.tokens[1] == "quad"){ set_layout(client, client.rows, client.cols, true); }
+                else{ command.fail("unknown viewport layout '" + std::string(command.tokens[1]) + "'"); }
+            }
+            else if(name == "camera"){
+                // A single view is viewport 1
+                if(!client.quad && (command.tokens.size() < 2 || command.tokens[1].find_first_not_of("0123456789") != std::string_view::npos)){
+                    command.tokens.insert(command.tokens.begin() + 1, "1");
+                }
+                run_camera_command(command, *client.buffer);
+                client.dirty = true;
+            }
+            else if(name == "mode"){
+                run_command(command, scene_, *client.buffer, -1);
+                client.dirty = true;
+            }
+            else if(name == "render" && std::ranges::all_of(command.tokens | std::views::drop(1), is_frame_format)){
+                command.fail("frames are sent without asking; render needs a PATH on the server");
+            }
+            else if(name == "import" || name == "export" || name == "svg" || name == "render"){
+                confine_file(command);
+                run_command(command, scene_, *client.buffer, -1);
+                mark_all_dirty();
+            }
+            else{
+                run_command(command, scene_, *client.buffer, -1);
+                mark_all_dirty();
+            }
+        }
+
+        void run_input(Client& client){
+            while(!client.quit && client.pending() < output_limit_){
+                size_t end = client.input.find('\n', client.parsed);
+                if(end == std::string::npos){ break; }
+                std::string_view line(client.input.data() + client.parsed, end - client.parsed);
+                client.parsed = end + 1;
+                try{
+                    execute(client, line);
+                }
+                catch(const std::exception& e){
+                    report(client, e.what());
+                }
+            }
+            if(client.quit || client.parsed == client.input.size()){
+                client.input.clear();
+                client.parsed = 0;
+            }
+        }
+
+        void read_client(Client& client){
+            ssize_t received = ::recv(client.fd, chunk_.data(), chunk_.size(), 0);
+            if(received < 0){
+                if(errno != EINTR && errno != EAGAIN && errno != EWOULDBLOCK){ client.broken = true; }
+                return;
+            }
+            if(received == 0){
+                // A last command without a line break still counts
+                if(client.input.size() != client.parsed){ client.input += '\n'; }
+                client.eof = true;
+                run_input(client);
+                return;
+            }
+            if(client.parsed != 0){
+                client.input.erase(0, client.parsed);
+                client.parsed = 0;
+            }
+            client.input.append(chunk_.data(), static_cast<size_t>(received));
+            if(client.input.size() > line_limit_ && client.input.find('\n') == std::string::npos){
+                report(client, "Command too long");
+                client.input.clear();
+                client.quit = true;
+                return;
+            }
+            run_input(client);
+        }
+
+        void write_client(Client& client){
+            while(client.pending() != 0){
+                ssize_t written = ::send(client.fd, client.output.data() + client.sent, client.pending(), MSG_NOSIGNAL | MSG_DONTWAIT);
+                if(written < 0){
+                    if(errno == EINTR){ continue; }
+                    if(errno != EAGAIN && errno != EWOULDBLOCK){ client.broken = true; }
+                    return;
+                }
+                client.sent += static_cast<size_t>(written);
+            }
+            client.output.clear();
+            client.sent = 0;
+            // Commands held back while the output was full
+            run_input(client);
+        }
+
+        void draw(Client& client){
+            Buffer<height, width>& buffer = *client.buffer;
+            buffer.clean_buffer();
+            draw_lines(scene_, buffer);
+            client.delta.encode(buffer, client.output, client.keyframe, client.rows, client.cols);
+            // Park the cursor on the status line
+            client.output += "\033[";
+            append_decimal(client.output, client.rows + 1);
+            client.output += ";1H";
+            client.dirty = false;
+            client.keyframe = false;
+        }
+
+        void serve_clients(){
+            for(auto it = clients_.begin(); it != clients_.end();){
+                Client& client = *it->second;
+                write_client(client);
+                // Writing may run held back commands, which may change the frame again
+                while(!client.broken && client.dirty && client.pending() == 0){
+                    try{
+                        draw(client);
+                    }
+                    catch(const std::exception& e){
+                        client.dirty = false;
+                        report(client, e.what());
+                    }
+                    write_client(client);
+                }
+                bool done = client.quit || (client.eof && client.input.empty());
+                if(client.broken || (done && client.pending() == 0 && !client.dirty)){
+                    ::close(client.fd);
+                    it = clients_.erase(it);
+                    continue;
+                }
+                set_interest(client);
+                ++it;
+            }
+        }
+
+    public:
+        explicit RenderServer(std::string path, std::string files = {}, mode_t mode = 0600) : path_(std::move(path)), files_(std::move(files)), mode_(mode){
+            try{
+                listen_on();
+                epoll_fd_ = ::epoll_create1(EPOLL_CLOEXEC);
+                if(epoll_fd_ < 0){ fail("Cannot create epoll instance"); }
+                wake_fd_ = ::eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+                if(wake_fd_ < 0){ fail("Cannot create eventfd"); }
+                watch(listen_fd_, EPOLLIN);
+                watch(wake_fd_, EPOLLIN);
+            }
+            catch(...){
+                close_all();
+                throw;
+            }
+        }
+
+        RenderServer(const RenderServer&) = delete;
+        RenderServer& operator=(const RenderServer&) = delete;
+
+        ~RenderServer(){
+            close_all();
+        }
+
+        void close_all(){
+            for(auto& [fd, client] : clients_){ ::close(fd); }
+            clients_.clear();
+            if(listen_fd_ >= 0){
+                ::close(listen_fd_);
+                ::unlink(path_.c_str());
+                listen_fd_ = -1;
+            }
+            if(epoll_fd_ >= 0){ ::close(epoll_fd_); epoll_fd_ = -1; }
+            if(wake_fd_ >= 0){ ::close(wake_fd_); wake_fd_ = -1; }
+        }
+
+        // Only before run() or from the thread running it
+        Scene<T>& scene(){ return scene_; }
+        size_t clients() const{ return clients_.size(); }
+
+        // run() returns once fd becomes readable, for example a signalfd
+        void stop_on(int fd){
+            watch(fd, EPOLLIN);
+            stop_fds_.push_back(fd);
+        }
+
+        // Safe from any thread and from signal handlers
+        void stop(){
+            uint64_t one = 1;
+            [[maybe_unused]] ssize_t written = ::write(wake_fd_, &one, sizeof(one));
+        }
+
+        void run(){
+            std::vector<epoll_event> events(64);
+            stopping_ = false;
+            while(!stopping_){
+                int count = ::epoll_wait(epoll_fd_, events.data(), static_cast<int>(events.size()), -1);
+                if(count < 0){
+                    if(errno == EINTR){ continue; }
+                    fail("epoll_wait failed");
+                }
+                for(int i = 0; i < count; i++){
+                    int fd = events[i].data.fd;
+                    if(fd == listen_fd_){ accept_clients(); continue; }
+                    if(fd == wake_fd_ || std::ranges::find(stop_fds_, fd) != stop_fds_.end()){
+                        stopping_ = true;
+                        continue;
+                    }
+                    auto it = clients_.find(fd);
+                    if(it == clients_.end()){ continue; }
+                    Client& client = *it->second;
+                    if(events[i].events & EPOLLIN){ read_client(client); }
+                    else if(events[i].events & (EPOLLERR | EPOLLHUP)){ client.broken = true; }
+                }
+                serve_clients();
+            }
+            uint64_t wakeups = 0;
+            [[maybe_unused]] ssize_t drained = ::read(wake_fd_, &wakeups, sizeof(wakeups));
+        }
+    };
+
+    // Serves until SIGINT, SIGTERM or SIGHUP
+    inline void Serve(const std::string& path, Scene<double> scene = {}, const std::string& files = {}){
+        auto server = std::make_unique<RenderServer<double, 74, 313>>(path, files);
+        server->scene() = std::move(scene);
+        sigset_t signals, previous;
+        sigemptyset(&signals);
+        sigaddset(&signals, SIGINT);
+        sigaddset(&signals, SIGTERM);
+        sigaddset(&signals, SIGHUP);
+        pthread_sigmask(SIG_BLOCK, &signals, &previous);
+        int signal_fd = ::signalfd(-1, &signals, SFD_NONBLOCK | SFD_CLOEXEC);
+        if(signal_fd < 0){
+            pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+            throw std::runtime_error(std::string("Cannot create signalfd: ") + std::strerror(errno));
+        }
+        std::cout << "Serving " << server->scene().size() << " lines on " << path << std::endl;
+        try{
+            server->stop_on(signal_fd);
+            server->run();
+        }
+        catch(...){
+            ::close(signal_fd);
+            pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+            throw;
+        }
+        server.reset();
+        ::close(signal_fd);
+        pthread_sigmask(SIG_SETMASK, &previous, nullptr);
+    }
+}
+
+#endif
@@ -1,7 +1,18 @@
 #include <iostream>
 #include <Dialogue/Dialogue.h>
+#include <Dialogue/Batch.h>
 
-int main(){
+int main(int argc, char** argv){
+    if(argc > 1){
+        try{
+            DialogueNameSpace::Batch(DialogueNameSpace::parse_batch_options(argc, argv));
+        }
+        catch(const std::exception& e){
+            std::cerr << e.what() << std::endl << DialogueNameSpace::batch_usage;
+            return 1;
+        }
+        return 0;
+    }
     DialogueNameSpace::Dialogue();
     return 0;
-}
\ No newline at end of file
+}
@@ -501,7 +501,7 @@ namespace MatrixNameSpace {
             auto a_row = a.row_iters(res_row).first;
             auto b_row = b_transposed.row_iters(res_col).first;
 
-            result[res_row, res_col] = std::inner_product(a_row, a_row + N, b_row, 0);
+            result[res_row, res_col] = std::inner_product(a_row, a_row + N, b_row, T{});
         }
 
         return result;
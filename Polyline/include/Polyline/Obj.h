@@ -0,0 +1,332 @@
+/**
+ * @file Obj.h
+ * @brief Streaming Wavefront OBJ import and export of polyline scenes
+ * @author Chesnokov Alexandr
+ * @date 2025
+ * @version 1.0
+ *
+ * This header reads the vertex ("v") and line ("l") records of OBJ files into a Scene
+ * and writes a Scene back in the same form. The reader parses fixed-size chunks with
+ * std::from_chars, so it never holds more of the text in memory than one chunk and
+ * the line being parsed; the writer fills one buffer and hands it to the stream in
+ * large blocks.
+ *
+ * Point names, which OBJ has no place for, are written as a one-character comment
+ * after the vertex ("v 1 2 3 # A") and read back from there. Groups ("g" or "o")
+ * become Scene groups. Other records (faces, normals, materials) are skipped.
+ */
+
+#ifndef OBJ_H
+#define OBJ_H
+
+#include <algorithm>
+#include <charconv>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <vector>
+#include <Polyline/Polyline.h>
+#include <Polyline/Scene.h>
+
+namespace PolylineNameSpace {
+    /**
+     * @class ObjReader
+     * @brief One-pass parser of OBJ text into a Scene
+     * @tparam T Numeric type of point coordinates; integral types round the coordinates
+     *
+     * Feed the text with parse_chunk() in pieces of any size, then call finish().
+     */
+    template<Numeric T>
+    class ObjReader{
+    private:
+        Scene<T>& scene_; ///< Receives the polylines
+        std::vector<Point<T>> vertices_{}; ///< All vertices read so far, indexed from 0
+        std::string group_{}; ///< Group of the following line records
+        std::string tail_{}; ///< Incomplete last line of the previous chunk
+        size_t line_number_ = 0; ///< Number of the line being parsed, for errors
+        size_t added_ = 0; ///< Polylines added to the scene
+
+        [[noreturn]] void fail(const std::string& message) const{
+            throw std::runtime_error("OBJ line " + std::to_string(line_number_) + ": " + message);
+        }
+
+        static bool blank(char c){
+            return c == ' ' || c == '\t' || c == '\r' || c == '\v' || c == '\f';
+        }
+
+        static const char* skip_blanks(const char* first, const char* last){
+            while(first != last && blank(*first)){ first++; }
+            return first;
+        }
+
+        static const char* skip_token(const char* first, const char* last){
+            while(first != last && !blank(*first)){ first++; }
+            return first;
+        }
+
+        /**
+         * @brief Parses one coordinate
+         * @param first Start of the coordinate, after blanks
+         * @param last End of the line
+         * @param value Receives the coordinate
+         * @return const char* Position after the coordinate
+         */
+        const char* parse_coordinate(const char* first, const char* last, T& value) const{
+            if(first != last && *first == '+'){ first++; }
+            double number = 0;
+            auto [end, error] = std::from_chars(first, last, number);
+            if(error != std::errc{}){ fail("bad coordinate"); }
+            if constexpr(std::is_integral_v<T>){ value = static_cast<T>(std::lround(number)); }
+            else{ value = static_cast<T>(number); }
+            return end;
+        }
+
+        void parse_vertex(const char* first, const char* last){
+            Point<T> point;
+            first = parse_coordinate(skip_blanks(first, last), last, point.x);
+            first = parse_coordinate(skip_blanks(first, last), last, point.y);
+            first = parse_coordinate(skip_blanks(first, last), last, point.z);
+            first = skip_blanks(first, last);
+            // An optional w coordinate is ignored
+            if(first != last && *first != '#'){ first = skip_blanks(skip_token(first, last), last); }
+            if(first != last && *first == '#'){
+                const char* name = skip_blanks(first + 1, last);
+                if(name != last && skip_blanks(name + 1, last) == last){ point.name_ = *name; }
+            }
+            vertices_.push_back(point);
+        }
+
+        void parse_line_element(const char* first, const char* last){
+            size_t count = 0;
+            for(const char* at = skip_blanks(first, last); at != last && *at != '#'; at = skip_blanks(skip_token(at, last), last)){ count++; }
+            if(count == 0){ fail("line element without vertices"); }
+            Polyline<T> polyline;
+            polyline.resize(count);
+            for(first = skip_blanks(first, last); first != last && *first != '#'; first = skip_blanks(first, last)){
+                int64_t index = 0;
+                auto [end, error] = std::from_chars(first, last, index);
+                if(error != std::errc{}){ fail("bad vertex index"); }
+                // Negative indices count back from the last vertex
+                int64_t resolved = index < 0 ? static_cast<int64_t>(vertices_.size()) + index : index - 1;
+                if(index == 0 || resolved < 0 || resolved >= static_cast<int64_t>(vertices_.size())){
+                    fail("vertex index " + std::to_string(index) + " out of range");
+                }
+                polyline.add_point(vertices_[static_cast<size_t>(resolved)]);
+                // Texture indices ("l 1/1 2/2") are skipped
+                first = skip_token(end, last);
+            }
+            scene_.insert(std::move(polyline), group_);
+            added_++;
+        }
+
+        void parse_line(const char* first, const char* last){
+            line_number_++;
+            first = skip_blanks(first, last);
+            const char* keyword_end = skip_token(first, last);
+            std::string_view keyword(first, static_cast<size_t>(keyword_end - first));
+            if(keyword == "v"){ parse_vertex(keyword_end, last); }
+            else if(keyword == "l"){ parse_line_element(keyword_end, last); }
+            else if(keyword == "g" || keyword == "o"){
+                const char* name = skip_blanks(keyword_end, last);
+                group_.assign(name, skip_token(name, last));
+            }
+        }
+
+    public:
+        /**
+         * @brief Constructor
+         * @param scene Scene receiving the polylines
+         * @param expected_vertices Number of vertices to reserve memory for
+         */
+        explicit ObjReader(Scene<T>& scene, size_t expected_vertices = 0) : scene_(scene){
+            vertices_.reserve(expected_vertices);
+        }
+
+        /**
+         * @brief Parses the next piece of the text
+         * @param chunk Text following the previous chunk
+         * @throws std::runtime_error on a malformed vertex or line record
+         */
+        void parse_chunk(std::string_view chunk){
+            size_t start = 0;
+            if(!tail_.empty()){
+                size_t end = chunk.find('\n');
+                if(end == std::string_view::npos){
+                    tail_.append(chunk);
+                    return;
+                }
+                tail_.append(chunk.substr(0, end));
+                parse_line(tail_.data(), tail_.data() + tail_.size());
+                tail_.clear();
+                start = end + 1;
+            }
+            for(size_t end = chunk.find('\n', start); end != std::string_view::npos; end = chunk.find('\n', start)){
+                parse_line(chunk.data() + start, chunk.data() + end);
+                start = end + 1;
+            }
+            tail_.assign(chunk.substr(start));
+        }
+
+        /**
+         * @brief Parses the last line if it had no line break
+         * @return size_t Number of polylines added to the scene
+         * @throws std::runtime_error on a malformed vertex or line record
+         *
+         * The vertex table is released here, since the polylines hold copies of the points.
+         */
+        size_t finish(){
+            if(!tail_.empty()){
+                parse_line(tail_.data(), tail_.data() + tail_.size());
+                tail_.clear();
+            }
+            std::vector<Point<T>>().swap(vertices_);
+            return added_;
+        }
+    };
+
+    /**
+     * @brief Reads the polylines of an OBJ stream into a scene
+     * @tparam T Numeric type of point coordinates
+     * @param in Stream to read from
+     * @param scene Scene receiving the polylines
+     * @param expected_vertices Number of vertices to reserve memory for
+     * @param chunk_size Number of bytes read at once
+     * @return size_t Number of polylines added
+     * @throws std::runtime_error on malformed records or if the stream fails
+     */
+    template<Numeric T>
+    size_t read_obj(std::istream& in, Scene<T>& scene, size_t expected_vertices = 0, size_t chunk_size = 1 << 20){
+        ObjReader<T> reader(scene, expected_vertices);
+        std::string chunk(chunk_size, '\0');
+        while(in){
+            in.read(chunk.data(), static_cast<std::streamsize>(chunk.size()));
+            reader.parse_chunk(std::string_view(chunk.data(), static_cast<size_t>(in.gcount())));
+        }
+        if(in.bad()){ throw std::runtime_error("Cannot read OBJ stream"); }
+        return reader.finish();
+    }
+
+    /**
+     * @brief Reads the polylines of an OBJ file into a scene
+     * @tparam T Numeric type of point coordinates
+     * @param path Path of the file
+     * @param scene Scene receiving the polylines
+     * @param reserve_by_size Reserve memory for the vertices from the file size up front
+     * @return size_t Number of polylines added
+     * @throws std::runtime_error if the file cannot be read or has malformed records
+     *
+     * By default the vertex table grows geometrically while reading, so files with
+     * long comments, faces or normals do not reserve memory for vertices they lack.
+     * With reserve_by_size a part of the table is reserved from the file size, which
+     * saves the reallocations on files holding little more than vertices and lines.
+     */
+    template<Numeric T>
+    size_t read_obj(const std::string& path, Scene<T>& scene, bool reserve_by_size = false){
+        std::ifstream file(path, std::ios::binary);
+        if(!file){ throw std::runtime_error("Cannot open OBJ file " + path); }
+        size_t expected_vertices = 0;
+        if(reserve_by_size){
+            std::error_code error;
+            uintmax_t bytes = std::filesystem::file_size(path, error);
+            // Vertex records with their share of the line records take about 32 bytes;
+            // half of that estimate is reserved, the vector grows further if needed
+            if(!error){ expected_vertices = static_cast<size_t>(bytes / 64); }
+        }
+        return read_obj(file, scene, expected_vertices);
+    }
+
+    /**
+     * @brief Writes a scene as OBJ vertex and line records
+     * @tparam T Numeric type of point coordinates
+     * @param scene Scene to write
+     * @param out Stream to write to
+     * @param block_size Number of buffered bytes handed to the stream at once
+     * @throws std::runtime_error if the stream fails
+     *
+     * Empty polylines are skipped, since OBJ has no empty line elements.
+     */
+    template<Numeric T>
+    void write_obj(const Scene<T>& scene, std::ostream& out, size_t block_size = 1 << 20){
+        std::string text;
+        text.reserve(block_size + 256);
+        auto flush = [&text, &out]{
+            out.write(text.data(), static_cast<std::streamsize>(text.size()));
+            text.clear();
+        };
+        auto append_number = [&text](auto value){
+            char digits[32];
+            auto [end, error] = std::to_chars(digits, digits + sizeof(digits), value);
+            text.append(digits, end);
+        };
+        text.append("# Terminal-3D polylines\n");
+        std::string_view group{};
+        uint64_t vertex_count = 0;
+        for(size_t i = 0; i < scene.size(); i++){
+            const Polyline<T>& polyline = scene.lines()[i];
+            if(polyline.points_count() == 0){ continue; }
+            std::string_view line_group = scene.group_of(scene.id_at(i));
+            if(line_group != group){
+                // A bare "g" returns to the default group
+                text.push_back('g');
+                if(!line_group.empty()){
+                    text.push_back(' ');
+                    text.append(line_group);
+                }
+                text.push_back('\n');
+                group = line_group;
+            }
+            for(const Point<T>& point : polyline){
+                text.append("v ");
+                append_number(point.x);
+                text.push_back(' ');
+                append_number(point.y);
+                text.push_back(' ');
+                append_number(point.z);
+                // '*' is the default name of a point
+                if(point.name_ > ' ' && point.name_ != '*' && point.name_ != '#' && point.name_ != 127){
+                    text.append(" # ");
+                    text.push_back(point.name_);
+                }
+                text.push_back('\n');
+                if(text.size() >= block_size){ flush(); }
+            }
+            text.push_back('l');
+            for(size_t j = 0; j < polyline.points_count(); j++){
+                text.push_back(' ');
+                append_number(vertex_count + j + 1);
+                if(text.size() >= block_size){ flush(); }
+            }
+            text.push_back('\n');
+            vertex_count += polyline.points_count();
+        }
+        flush();
+        if(!out){ throw std::runtime_error("Cannot write OBJ stream"); }
+    }
+
+    /**
+     * @brief Writes a scene to an OBJ file
+     * @tparam T Numeric type of point coordinates
+     * @param scene Scene to write
+     * @param path Path of the file, replaced if it exists
+     * @throws std::runtime_error if the file cannot be written
+     */
+    template<Numeric T>
+    void write_obj(const Scene<T>& scene, const std::string& path){
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if(!file){ throw std::runtime_error("Cannot open OBJ file " + path); }
+        write_obj(scene, file);
+        file.flush();
+        if(!file){ throw std::runtime_error("Cannot write OBJ file " + path); }
+    }
+}
+
+#endif
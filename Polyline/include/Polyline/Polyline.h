@@ -13,12 +13,16 @@
 #define POLYLINE_H
 
 #include <concepts>
+#include <atomic>
+#include <cstdint>
 #include <array>
 #include <cstddef>
 #include <cmath>
 #include <numbers>
 #include <cstring>
+#include <memory>
 #include <Matrix/Matrix.h>
+#include <Utils/Profiler.h>
 
 namespace PolylineNameSpace {
     using namespace MatrixNameSpace;
@@ -71,6 +75,27 @@ namespace PolylineNameSpace {
         return Point<T>{matrix[0, 0], matrix[0, 1], matrix[0, 2], name};
     }
 
+    /**
+     * @brief Returns a new process-wide unique polyline identifier
+     * @return uint64_t Identifier, never 0
+     */
+    inline uint64_t next_polyline_id(){
+        static std::atomic<uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
+    /**
+     * @brief Returns a new process-wide unique polyline version
+     * @return uint64_t Version, never 0
+     *
+     * Versions are unique across all polylines, so two copies with the same id()
+     * that were changed separately never report the same version.
+     */
+    inline uint64_t next_polyline_version(){
+        static std::atomic<uint64_t> counter{0};
+        return counter.fetch_add(1, std::memory_order_relaxed) + 1;
+    }
+
     /**
      * @class Polyline
      * @brief 3D polyline composed of connected points with geometric operations
@@ -78,14 +103,34 @@ namespace PolylineNameSpace {
      * 
      * The Polyline class represents a sequence of connected 3D points with support
      * for various geometric transformations, point management, and mathematical operations.
-     * Uses dynamic memory allocation for point storage.
+     * Point storage is copy-on-write: copies share the points until one of them is
+     * modified, so copying a polyline (for example into an undo snapshot) is O(1) and
+     * only polylines that actually change are duplicated.
+     *
+     * Every polyline has an id() and a version() that changes with each change of
+     * its points, so renderers can cache derived data keyed by (id, version). Copies
+     * keep the id() and version() of the original, as they hold the same points;
+     * a change takes a new process-wide version, so an (id, version) pair always
+     * names the same points. Mutable access (non-const operator[] and iterators)
+     * counts as a change.
      */
     template <Numeric T>
     class Polyline{
     private:
-        Point<T>* dots_ = nullptr; ///< Dynamic array storing the polyline points
+        std::shared_ptr<Point<T>[]> dots_{}; ///< Point array, shared between copies until one of them writes
         size_t capacity_ = 0; ///< Current capacity of the dynamic array
         size_t size_ = 0; ///< Current number of points in the polyline
+        uint64_t id_ = next_polyline_id(); ///< Identity of the polyline, shared with its copies
+        uint64_t version_ = 0; ///< Replaced by next_polyline_version() on every operation that may change the points
+        bool borrowed_ = false; ///< Whether dots_ is memory the polyline may not write (see borrow)
+
+        /**
+         * @brief Prepares the points for writing
+         *
+         * Copies the shared or borrowed points into an array of its own if another
+         * polyline still uses them, and counts the write in version().
+         */
+        void detach();
 
     public:
         // Iterator type definitions
@@ -116,10 +161,29 @@ namespace PolylineNameSpace {
          * @brief Copy constructor
          * @param other Polyline to copy from
          * 
-         * Creates a deep copy of the other polyline with separate memory allocation.
+         * Shares the points of the other polyline; they are copied on the first write
+         * to either of them. The copy keeps the id() and version() of the original,
+         * so caches keyed by them (see Buffer::draw_cached) still hit for copies.
+         */
+        Polyline(const Polyline& other) : dots_(other.dots_), capacity_(other.capacity_), size_(other.size_), id_(other.id_), version_(other.version_), borrowed_(other.borrowed_){}
+
+        /**
+         * @brief Creates a polyline over points it does not own
+         * @param owner Keeps the memory of the points alive as long as the polyline uses it
+         * @param points First point
+         * @param count Number of points
+         * @return Polyline reading the points in place
+         *
+         * Nothing is copied; the first write copies the points into an array of the
+         * polyline's own, so read-only memory (a shared mapping) is never written.
          */
-        Polyline(const Polyline& other) : dots_(new Point<T>[other.capacity_]), capacity_(other.capacity_), size_(other.size_){
-            std::copy(other.dots_, other.dots_ + size_, dots_);
+        static Polyline borrow(std::shared_ptr<const void> owner, const Point<T>* points, size_t count){
+            Polyline polyline;
+            polyline.dots_ = std::shared_ptr<Point<T>[]>(std::const_pointer_cast<void>(std::move(owner)), const_cast<Point<T>*>(points));
+            polyline.capacity_ = count;
+            polyline.size_ = count;
+            polyline.borrowed_ = true;
+            return polyline;
         }
 
         /**
@@ -168,9 +232,16 @@ namespace PolylineNameSpace {
         /**
          * @brief Destructor
          * 
-         * Releases all allocated memory for points.
+         * Releases the points unless another copy still shares them.
+         */
+        ~Polyline() = default;
+
+        /**
+         * @brief Checks whether two polylines share their point storage
+         * @param other Polyline to compare with
+         * @return bool True if neither was modified since one was copied from the other
          */
-        ~Polyline();
+        bool shares_points(const Polyline& other) const;
 
         // Capacity management
         /**
@@ -178,7 +249,8 @@ namespace PolylineNameSpace {
          * @param new_capacity New capacity for the point array
          * 
          * Reallocates memory to the new capacity, preserving existing points.
-         * If new capacity is smaller than current size, excess points are lost.
+         * If new capacity is smaller than current size, excess points are lost
+         * and the version changes. The new array is never shared.
          */
         void resize(size_t new_capacity);
 
@@ -264,6 +336,20 @@ namespace PolylineNameSpace {
          */
         size_t points_count() const;
 
+        /**
+         * @brief Get the identifier of the polyline
+         * @return uint64_t Identifier, shared only by copies of one polyline
+         *
+         * The identifier moves together with the points (move and swap).
+         */
+        uint64_t id() const;
+
+        /**
+         * @brief Get the change counter of the polyline
+         * @return uint64_t Version, replaced by a new process-wide one in every mutating method
+         */
+        uint64_t version() const;
+
         /**
          * @brief Find the index of the most "distant" point
          * @return size_t Index of the point with maximum sum of distances to neighbors
@@ -295,32 +381,34 @@ namespace PolylineNameSpace {
     /*----------------ITERATORS----------------*/
     template <Numeric T>
     Polyline<T>::iterator Polyline<T>::begin(){
-        return (&dots_[0]);
+        detach();
+        return dots_.get();
     }
 
     template <Numeric T>
     Polyline<T>::iterator Polyline<T>::end(){
-        return (&dots_[0] + size_);
+        detach();
+        return dots_.get() + size_;
     }
 
     template <Numeric T>
     Polyline<T>::const_iterator Polyline<T>::begin() const{
-        return (&dots_[0]);
+        return dots_.get();
     }
 
     template <Numeric T>
     Polyline<T>::const_iterator Polyline<T>::end() const{
-        return (&dots_[0] + size_);
+        return dots_.get() + size_;
     }
 
     template <Numeric T>
     Polyline<T>::const_iterator Polyline<T>::cbegin() const{
-        return (&dots_[0]);
+        return dots_.get();
     }
 
     template <Numeric T>
     Polyline<T>::const_iterator Polyline<T>::cend() const{
-        return (&dots_[0] + size_);
+        return dots_.get() + size_;
     }
 
     template <Numeric T>
@@ -362,6 +450,7 @@ namespace PolylineNameSpace {
 
     template <Numeric T>
     Point<T> &Polyline<T>::operator[](size_t i){
+        detach();
         return dots_[i];
     }
 
@@ -375,23 +464,38 @@ namespace PolylineNameSpace {
         std::swap(dots_, other.dots_);
         std::swap(capacity_, other.capacity_);
         std::swap(size_, other.size_);
+        std::swap(id_, other.id_);
+        std::swap(version_, other.version_);
+        std::swap(borrowed_, other.borrowed_);
+    }
+
+    /*----------------COPY-ON-WRITE----------------*/
+    template <Numeric T>
+    void Polyline<T>::detach(){
+        version_ = next_polyline_version();
+        if(borrowed_ || dots_.use_count() > 1){ resize(capacity_); }
+        // Pairs with the release of a copy dropped on another thread, which has finished reading
+        else{ std::atomic_thread_fence(std::memory_order_acquire); }
     }
 
-    /*----------------DISTRUCTOR----------------*/
     template <Numeric T>
-    Polyline<T>::~Polyline(){
-        delete [] dots_;
+    bool Polyline<T>::shares_points(const Polyline<T>& other) const{
+        return dots_ != nullptr && dots_ == other.dots_;
     }
 
     /*----------------MAIN FUNCTIONS----------------*/
 
     template <Numeric T>
     void Polyline<T>::resize(size_t new_capacity){
-        Point<T>* new_dots = new Point<T>[new_capacity];
-        std::copy(dots_, dots_ + std::min(size_, new_capacity), new_dots);
-        delete [] dots_;
-        dots_ = new_dots;
+        std::shared_ptr<Point<T>[]> new_dots = std::make_shared_for_overwrite<Point<T>[]>(new_capacity);
+        if(new_capacity < size_){
+            size_ = new_capacity;
+            version_ = next_polyline_version();
+        }
+        std::copy(dots_.get(), dots_.get() + size_, new_dots.get());
+        dots_ = std::move(new_dots);
         capacity_ = new_capacity;
+        borrowed_ = false;
     }
 
     template <Numeric T>
@@ -399,6 +503,7 @@ namespace PolylineNameSpace {
         if(size_ == capacity_){
             resize(capacity_ * 2 + 1);
         }
+        detach();
         dots_[size_] = point;
         size_++;
     }
@@ -437,6 +542,8 @@ namespace PolylineNameSpace {
 
     template <Numeric T>
     void Polyline<T>::rotate_from_origin(double x_degree, double y_degree, double z_degree){
+        UtilsNameSpace::ScopedTimer timer(UtilsNameSpace::ProfileStage::Transform);
+        UtilsNameSpace::Profiler::count(UtilsNameSpace::ProfileCounter::PointsTransformed, size_);
         double x_radians = x_degree * std::numbers::pi_v<double> / 180.0;
         double y_radians = y_degree * std::numbers::pi_v<double> / 180.0;
         double z_radians = z_degree * std::numbers::pi_v<double> / 180.0;
@@ -466,6 +573,8 @@ namespace PolylineNameSpace {
 
     template <Numeric T>
     void Polyline<T>::rotate_by_vector(const Point<T>& start, const Point<T>& finish, double degree){
+        UtilsNameSpace::ScopedTimer timer(UtilsNameSpace::ProfileStage::Transform);
+        UtilsNameSpace::Profiler::count(UtilsNameSpace::ProfileCounter::PointsTransformed, size_);
         double radians = (-1) * degree * std::numbers::pi_v<double> / 180.0;
         double u = finish.x, v = finish.y, w = finish.z;
         double len = std::sqrt(u*u + v*v + w*w);
@@ -489,6 +598,8 @@ namespace PolylineNameSpace {
 
     template <Numeric T>
     void Polyline<T>::shift(double x, double y, double z){
+        UtilsNameSpace::ScopedTimer timer(UtilsNameSpace::ProfileStage::Transform);
+        UtilsNameSpace::Profiler::count(UtilsNameSpace::ProfileCounter::PointsTransformed, size_);
         std::transform(begin(), end(), begin(), [x, y, z](Point<T> point){
             point.x += x;
             point.y += y;
@@ -510,6 +621,16 @@ namespace PolylineNameSpace {
         return size_;
     }
 
+    template <Numeric T>
+    uint64_t Polyline<T>::id() const{
+        return id_;
+    }
+
+    template <Numeric T>
+    uint64_t Polyline<T>::version() const{
+        return version_;
+    }
+
     template <Numeric T>
     size_t Polyline<T>::find_distant() const{
         size_t res = 0;
@@ -0,0 +1,297 @@
+/**
+ * @file Scene.h
+ * @brief Slot map of polylines with stable generational identifiers and named groups
+ * @author Chesnokov Alexandr
+ * @date 2025
+ * @version 1.0
+ *
+ * This header defines a Scene class that stores polylines contiguously for rendering
+ * while handing out LineId handles that stay valid until their own polyline is
+ * erased. Insertion and erasure are O(1) and never move more than one polyline.
+ */
+
+#ifndef SCENE_H
+#define SCENE_H
+
+#include <charconv>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <optional>
+#include <stdexcept>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <Polyline/Polyline.h>
+
+namespace PolylineNameSpace {
+    /**
+     * @struct LineId
+     * @brief Handle of a polyline in a Scene
+     *
+     * The slot index is reused after an erase, but with a new generation, so a handle
+     * of an erased polyline never refers to the polyline that took its slot.
+     */
+    struct LineId{
+        uint32_t index = std::numeric_limits<uint32_t>::max(); ///< Slot of the polyline
+        uint32_t generation = 0; ///< Number of times the slot was freed before
+
+        bool operator==(const LineId&) const = default;
+    };
+
+    /**
+     * @brief Formats an identifier the way operators type it
+     * @param id Identifier to format
+     * @return std::string "N" for the first polyline in slot N - 1, "N.G" once the slot was reused G times
+     */
+    inline std::string to_string(LineId id){
+        std::string text = std::to_string(static_cast<uint64_t>(id.index) + 1);
+        if(id.generation != 0){ text += '.' + std::to_string(id.generation); }
+        return text;
+    }
+
+    /**
+     * @brief Parses an identifier formatted by to_string
+     * @param text "N" or "N.G"
+     * @return std::optional<LineId> The identifier, or nothing if text is malformed
+     */
+    inline std::optional<LineId> parse_line_id(std::string_view text){
+        uint64_t number = 0;
+        uint32_t generation = 0;
+        const char* last = text.data() + text.size();
+        auto [end, error] = std::from_chars(text.data(), last, number);
+        if(error != std::errc{} || number == 0 || number > std::numeric_limits<uint32_t>::max()){ return std::nullopt; }
+        if(end != last){
+            if(*end != '.'){ return std::nullopt; }
+            auto [generation_end, generation_error] = std::from_chars(end + 1, last, generation);
+            if(generation_error != std::errc{} || generation_end != last){ return std::nullopt; }
+        }
+        return LineId{static_cast<uint32_t>(number - 1), generation};
+    }
+
+    /**
+     * @class Scene
+     * @brief Collection of polylines addressed by LineId
+     * @tparam T Numeric type of point coordinates (must satisfy Numeric concept)
+     *
+     * Polylines live in one vector in no particular order; erase() moves the last one
+     * into the hole. Each slot maps an identifier to its position in that vector and
+     * back. Every polyline may belong to one named group.
+     */
+    template<Numeric T>
+    class Scene{
+    private:
+        static constexpr uint32_t no_slot_ = std::numeric_limits<uint32_t>::max(); ///< End of the free list
+
+        /**
+         * @struct Slot
+         * @brief Position of a polyline, or the next free slot while unused
+         */
+        struct Slot{
+            uint32_t position = 0; ///< Index in lines_, or the next free slot
+            uint32_t generation = 0; ///< Generation of the current or next occupant
+            bool used = false; ///< Whether a polyline occupies the slot
+        };
+
+        std::vector<Polyline<T>> lines_{}; ///< Polylines, contiguous for rendering
+        std::vector<uint32_t> owners_{}; ///< Slot of every polyline in lines_
+        std::vector<uint32_t> groups_{}; ///< Group of every polyline in lines_, 0 for none
+        std::vector<Slot> slots_{}; ///< Slots indexed by LineId::index
+        std::vector<std::string> group_names_{}; ///< Name of group k at k - 1
+        uint32_t free_ = no_slot_; ///< First free slot
+
+        /**
+         * @brief Finds the position of a polyline
+         * @param id Identifier of the polyline
+         * @return size_t Index in lines_, or lines_.size() if id is stale
+         */
+        size_t position(LineId id) const{
+            if(id.index >= slots_.size()){ return lines_.size(); }
+            const Slot& slot = slots_[id.index];
+            return slot.used && slot.generation == id.generation ? slot.position : lines_.size();
+        }
+
+        /**
+         * @brief Finds or adds a group
+         * @param name Name of the group
+         * @return uint32_t Group number, starting with 1
+         */
+        uint32_t group_number(std::string_view name){
+            for(size_t i = 0; i < group_names_.size(); i++){
+                if(group_names_[i] == name){ return static_cast<uint32_t>(i + 1); }
+            }
+            group_names_.emplace_back(name);
+            return static_cast<uint32_t>(group_names_.size());
+        }
+
+    public:
+        using iterator = typename std::vector<Polyline<T>>::iterator;
+        using const_iterator = typename std::vector<Polyline<T>>::const_iterator;
+
+        /**
+         * @brief Adds a polyline
+         * @param polyline Polyline to add
+         * @param group Group of the polyline, empty for none
+         * @return LineId Identifier of the polyline
+         * @throws std::length_error if the scene already holds 2^32 - 1 slots
+         */
+        LineId insert(Polyline<T> polyline, std::string_view group = {}){
+            uint32_t index = free_;
+            if(index == no_slot_){
+                if(slots_.size() >= no_slot_){ throw std::length_error("Scene is full"); }
+                index = static_cast<uint32_t>(slots_.size());
+                slots_.emplace_back();
+            }
+            else{ free_ = slots_[index].position; }
+            Slot& slot = slots_[index];
+            slot.position = static_cast<uint32_t>(lines_.size());
+            slot.used = true;
+            lines_.push_back(std::move(polyline));
+            owners_.push_back(index);
+            groups_.push_back(group.empty() ? 0 : group_number(group));
+            return LineId{index, slot.generation};
+        }
+
+        /**
+         * @brief Removes a polyline
+         * @param id Identifier of the polyline
+         * @return bool False if id does not refer to a polyline of the scene
+         *
+         * The last polyline is moved into the freed position; no other polyline moves.
+         */
+        bool erase(LineId id){
+            size_t at = position(id);
+            if(at == lines_.size()){ return false; }
+            size_t last = lines_.size() - 1;
+            if(at != last){
+                lines_[at] = std::move(lines_[last]);
+                owners_[at] = owners_[last];
+                groups_[at] = groups_[last];
+                slots_[owners_[at]].position = static_cast<uint32_t>(at);
+            }
+            lines_.pop_back();
+            owners_.pop_back();
+            groups_.pop_back();
+            Slot& slot = slots_[id.index];
+            slot.used = false;
+            slot.generation++;
+            slot.position = free_;
+            free_ = id.index;
+            return true;
+        }
+
+        /**
+         * @brief Removes all polylines and groups
+         *
+         * Slots are kept with bumped generations, so old identifiers stay invalid.
+         */
+        void clear(){
+            for(size_t i = lines_.size(); i-- > 0;){ erase(id_at(i)); }
+            group_names_.clear();
+        }
+
+        /**
+         * @brief Checks whether an identifier refers to a polyline of the scene
+         * @param id Identifier to check
+         * @return bool True if the polyline exists
+         */
+        bool contains(LineId id) const{ return position(id) != lines_.size(); }
+
+        /**
+         * @brief Access a polyline
+         * @param id Identifier of the polyline
+         * @return Polyline<T>* The polyline, or nullptr if id is stale
+         */
+        Polyline<T>* find(LineId id){
+            size_t at = position(id);
+            return at == lines_.size() ? nullptr : &lines_[at];
+        }
+
+        /**
+         * @brief Access a polyline with checking
+         * @param id Identifier of the polyline
+         * @return Reference to the polyline
+         * @throws std::out_of_range if id does not refer to a polyline of the scene
+         */
+        Polyline<T>& at(LineId id){
+            Polyline<T>* polyline = find(id);
+            if(!polyline){ throw std::out_of_range("No line with ID " + to_string(id)); }
+            return *polyline;
+        }
+
+        /**
+         * @brief Access a polyline with checking (const version)
+         * @param id Identifier of the polyline
+         * @return Const reference to the polyline
+         * @throws std::out_of_range if id does not refer to a polyline of the scene
+         */
+        const Polyline<T>& at(LineId id) const{
+            size_t at = position(id);
+            if(at == lines_.size()){ throw std::out_of_range("No line with ID " + to_string(id)); }
+            return lines_[at];
+        }
+
+        /**
+         * @brief Get the identifier of the polyline at a position of lines()
+         * @param position Index in lines()
+         * @return LineId Identifier of the polyline
+         */
+        LineId id_at(size_t position) const{
+            uint32_t index = owners_[position];
+            return LineId{index, slots_[index].generation};
+        }
+
+        size_t size() const{ return lines_.size(); } ///< Returns the number of polylines
+        bool empty() const{ return lines_.empty(); } ///< Checks whether the scene holds no polylines
+
+        /**
+         * @brief Get all polylines in storage order
+         * @return Const reference to the contiguous polylines
+         */
+        const std::vector<Polyline<T>>& lines() const{ return lines_; }
+
+        iterator begin(){ return lines_.begin(); } ///< Returns an iterator to the first polyline
+        iterator end(){ return lines_.end(); } ///< Returns an iterator past the last polyline
+        const_iterator begin() const{ return lines_.begin(); } ///< Returns a const iterator to the first polyline
+        const_iterator end() const{ return lines_.end(); } ///< Returns a const iterator past the last polyline
+
+        /**
+         * @brief Moves a polyline into a group
+         * @param id Identifier of the polyline
+         * @param group Name of the group, empty to remove the polyline from its group
+         * @throws std::out_of_range if id does not refer to a polyline of the scene
+         */
+        void set_group(LineId id, std::string_view group){
+            size_t at = position(id);
+            if(at == lines_.size()){ throw std::out_of_range("No line with ID " + to_string(id)); }
+            groups_[at] = group.empty() ? 0 : group_number(group);
+        }
+
+        /**
+         * @brief Get the group of a polyline
+         * @param id Identifier of the polyline
+         * @return std::string_view Name of the group, empty if the polyline is in none or does not exist
+         */
+        std::string_view group_of(LineId id) const{
+            size_t at = position(id);
+            if(at == lines_.size() || groups_[at] == 0){ return {}; }
+            return group_names_[groups_[at] - 1];
+        }
+
+        /**
+         * @brief Get the polylines of a group
+         * @param group Name of the group
+         * @return std::vector<LineId> Identifiers of its polylines in storage order
+         */
+        std::vector<LineId> group(std::string_view group) const{
+            std::vector<LineId> ids{};
+            if(group.empty()){ return ids; }
+            for(size_t i = 0; i < lines_.size(); i++){
+                if(groups_[i] != 0 && group_names_[groups_[i] - 1] == group){ ids.push_back(id_at(i)); }
+            }
+            return ids;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,446 @@
+/**
+ * @file SharedScene.h
+ * @brief Polylines of a Scene published in POSIX shared memory under a seqlock
+ * @author Chesnokov Alexandr
+ * @date 2025
+ * @version 1.0
+ *
+ * This header lets one writer process publish the polylines of a Scene into a named
+ * shared-memory segment and any number of reader processes render them straight from
+ * their read-only mapping. The readers never copy the points: they get Polyline views
+ * over the segment (see Polyline::borrow) and retry a frame if the writer published
+ * while it was being drawn.
+ *
+ * Layout of the segment: a SharedSceneHeader, a table of SharedLine entries and the
+ * points of all polylines, back to back. The segment only ever grows, so a reader's
+ * mapping stays valid while the writer resizes it, and every value a reader can see
+ * is one the writer stored (old or new); a torn read gives a wrong frame, never an
+ * out-of-bounds access.
+ */
+
+#ifndef SHAREDSCENE_H
+#define SHAREDSCENE_H
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <vector>
+#include <Polyline/Polyline.h>
+#include <Polyline/Scene.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace PolylineNameSpace {
+    constexpr uint64_t shared_scene_magic = 0x454E454353443354; ///< "T3DSCENE" in little-endian bytes
+
+    /**
+     * @struct SharedSceneHeader
+     * @brief First bytes of a shared scene segment
+     */
+    struct alignas(64) SharedSceneHeader{
+        uint64_t magic = shared_scene_magic; ///< Identifies the segment format
+        uint32_t point_size = 0; ///< sizeof(Point<T>) of the writer, checked by readers
+        uint32_t integral = 0; ///< Whether the writer's T is an integral type
+        std::atomic<uint64_t> sequence{0}; ///< Odd while the writer changes the segment
+        std::atomic<uint64_t> writer{0}; ///< Process ID of the writer, 0 once it closed the segment
+        uint64_t bytes = 0; ///< Size of the segment
+        uint64_t line_capacity = 0; ///< Entries the line table has room for
+        uint64_t point_capacity = 0; ///< Points the point array has room for
+        uint64_t lines = 0; ///< Number of published polylines
+        uint64_t points = 0; ///< Number of published points
+    };
+
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "The sequence must be usable across processes");
+
+    /**
+     * @struct SharedLine
+     * @brief Entry of the line table
+     */
+    struct SharedLine{
+        LineId id{}; ///< Identifier of the polyline in the writer's Scene
+        uint64_t offset = 0; ///< Index of its first point in the point array
+        uint64_t count = 0; ///< Number of its points
+    };
+
+    /**
+     * @brief Adds the leading slash POSIX expects in shared memory names
+     * @param name Segment name, with or without the slash
+     * @return std::string Name starting with '/'
+     */
+    inline std::string shared_memory_name(const std::string& name){
+        return name.starts_with('/') ? name : '/' + name;
+    }
+
+    /**
+     * @class SharedSceneWriter
+     * @brief Publishes the polylines of a Scene into a named shared-memory segment
+     * @tparam T Numeric type of point coordinates (must satisfy Numeric concept)
+     *
+     * Only one writer may use a segment at a time. The segment is removed by the
+     * destructor; readers that mapped it keep the last published scene.
+     */
+    template<Numeric T>
+    class SharedSceneWriter{
+    private:
+        static_assert(std::is_trivially_copyable_v<Point<T>>, "Points are copied into shared memory bytewise");
+
+        /**
+         * @struct Published
+         * @brief What the writer last copied for one polyline
+         */
+        struct Published{
+            uint64_t polyline = 0; ///< Polyline::id() of the copied polyline
+            uint64_t version = 0; ///< Polyline::version() when it was copied
+        };
+
+        std::string name_; ///< Name of the segment
+        int fd_ = -1; ///< Descriptor of the segment
+        void* memory_ = nullptr; ///< Writable mapping of the segment
+        size_t bytes_ = 0; ///< Size of the mapping
+        std::vector<Published> published_{}; ///< Polylines in the line table, in order
+        size_t copied_ = 0; ///< Points copied by the last publish
+
+        SharedSceneHeader& header() const{ return *static_cast<SharedSceneHeader*>(memory_); }
+
+        SharedLine* table() const{
+            return reinterpret_cast<SharedLine*>(static_cast<char*>(memory_) + sizeof(SharedSceneHeader));
+        }
+
+        Point<T>* points() const{
+            return reinterpret_cast<Point<T>*>(reinterpret_cast<char*>(table() + header().line_capacity));
+        }
+
+        static size_t segment_bytes(size_t lines, size_t points){
+            return sizeof(SharedSceneHeader) + lines * sizeof(SharedLine) + points * sizeof(Point<T>);
+        }
+
+        /**
+         * @brief Grows the segment to hold a scene, keeping the header
+         * @param lines Number of polylines
+         * @param points Number of points
+         *
+         * Called inside a write, so readers retry instead of using the moved arrays.
+         * Capacities grow by half, so repeated growth stays amortized O(1).
+         */
+        void reserve(size_t lines, size_t points){
+            SharedSceneHeader& old = header();
+            if(lines <= old.line_capacity && points <= old.point_capacity){ return; }
+            size_t line_capacity = std::max<size_t>(lines, old.line_capacity + old.line_capacity / 2);
+            size_t point_capacity = std::max<size_t>(points, old.point_capacity + old.point_capacity / 2);
+            size_t bytes = segment_bytes(line_capacity, point_capacity);
+            if(::ftruncate(fd_, static_cast<off_t>(bytes)) < 0){ throw std::runtime_error("Cannot grow shared scene " + name_ + ": " + std::strerror(errno)); }
+            void* memory = ::mremap(memory_, bytes_, bytes, MREMAP_MAYMOVE);
+            if(memory == MAP_FAILED){ throw std::runtime_error("Cannot map shared scene " + name_ + ": " + std::strerror(errno)); }
+            memory_ = memory;
+            bytes_ = bytes;
+            header().bytes = bytes;
+            header().line_capacity = line_capacity;
+            header().point_capacity = point_capacity;
+            // The point array moved behind the longer table; everything is copied again
+            published_.clear();
+        }
+
+    public:
+        /**
+         * @brief Constructor creating (or taking over) a segment
+         * @param name Name of the segment, such as "/terminal3d"
+         * @param lines Initial room for polylines
+         * @param points Initial room for points
+         * @throws std::runtime_error if the segment cannot be created or mapped
+         */
+        explicit SharedSceneWriter(const std::string& name, size_t lines = 64, size_t points = 4096) : name_(shared_memory_name(name)){
+            fd_ = ::shm_open(name_.c_str(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+            if(fd_ < 0){ throw std::runtime_error("Cannot create shared scene " + name_ + ": " + std::strerror(errno)); }
+            bytes_ = segment_bytes(lines, points);
+            struct stat status{};
+            // A segment left by an earlier writer may be mapped by readers, so it never shrinks
+            if(::fstat(fd_, &status) == 0){ bytes_ = std::max(bytes_, static_cast<size_t>(status.st_size)); }
+            memory_ = ::ftruncate(fd_, static_cast<off_t>(bytes_)) < 0 ? MAP_FAILED : ::mmap(nullptr, bytes_, PROT_READ | PROT_WRITE, MAP_SHARED, fd_, 0);
+            if(memory_ == MAP_FAILED){
+                int error = errno;
+                ::close(fd_);
+                ::shm_unlink(name_.c_str());
+                throw std::runtime_error("Cannot map shared scene " + name_ + ": " + std::strerror(error));
+            }
+            SharedSceneHeader& shared = header();
+            uint64_t sequence = shared.sequence.load(std::memory_order_relaxed);
+            shared.sequence.store(sequence | 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            shared.magic = shared_scene_magic;
+            shared.point_size = sizeof(Point<T>);
+            shared.integral = std::is_integral_v<T>;
+            shared.bytes = bytes_;
+            shared.line_capacity = lines;
+            shared.point_capacity = (bytes_ - segment_bytes(lines, 0)) / sizeof(Point<T>);
+            shared.lines = 0;
+            shared.points = 0;
+            shared.writer.store(static_cast<uint64_t>(::getpid()), std::memory_order_relaxed);
+            shared.sequence.store((sequence | 1) + 1, std::memory_order_release);
+        }
+
+        SharedSceneWriter(const SharedSceneWriter&) = delete;
+        SharedSceneWriter& operator=(const SharedSceneWriter&) = delete;
+
+        /**
+         * @brief Destructor
+         *
+         * Tells the readers it is gone, unmaps and removes the segment.
+         */
+        ~SharedSceneWriter(){
+            header().writer.store(0, std::memory_order_release);
+            ::munmap(memory_, bytes_);
+            ::close(fd_);
+            ::shm_unlink(name_.c_str());
+        }
+
+        /**
+         * @brief Get the name of the segment
+         * @return Const reference to the name, starting with '/'
+         */
+        const std::string& name() const{ return name_; }
+
+        /**
+         * @brief Get the number of publications so far
+         * @return uint64_t Even sequence number of the last publish
+         */
+        uint64_t sequence() const{ return header().sequence.load(std::memory_order_relaxed); }
+
+        /**
+         * @brief Get the number of points the last publish copied
+         * @return size_t Points of the polylines that changed, or of all polylines
+         */
+        size_t copied_points() const{ return copied_; }
+
+        /**
+         * @brief Makes the current polylines of a scene visible to the readers
+         * @param scene Scene to publish
+         * @throws std::runtime_error if the segment cannot grow
+         *
+         * While the line table is unchanged (same polylines with the same point counts
+         * in the same order), only polylines whose version() changed are copied.
+         */
+        void publish(const Scene<T>& scene){
+            size_t lines = scene.size(), point_count = 0;
+            for(const Polyline<T>& polyline : scene){ point_count += polyline.points_count(); }
+            SharedSceneHeader& shared = header();
+            uint64_t sequence = shared.sequence.load(std::memory_order_relaxed);
+            shared.sequence.store(sequence + 1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_release);
+            copied_ = 0;
+            try{
+                reserve(lines, point_count);
+                SharedSceneHeader& current = header();
+                SharedLine* entries = table();
+                bool same_table = published_.size() == lines && current.points == point_count;
+                for(size_t i = 0; same_table && i < lines; i++){
+                    same_table = entries[i].id == scene.id_at(i) && entries[i].count == scene.lines()[i].points_count();
+                }
+                if(!same_table){ published_.assign(lines, Published{}); }
+                uint64_t offset = 0;
+                for(size_t i = 0; i < lines; i++){
+                    const Polyline<T>& polyline = scene.lines()[i];
+                    size_t count = polyline.points_count();
+                    Published& copy = published_[i];
+                    if(!same_table){ entries[i] = SharedLine{scene.id_at(i), offset, count}; }
+                    if(!same_table || copy.polyline != polyline.id() || copy.version != polyline.version()){
+                        if(count != 0){ std::memcpy(static_cast<void*>(points() + offset), polyline.begin(), count * sizeof(Point<T>)); }
+                        copy = Published{polyline.id(), polyline.version()};
+                        copied_ += count;
+                    }
+                    offset += count;
+                }
+                current.lines = lines;
+                current.points = point_count;
+            }
+            catch(...){
+                // Readers see an empty scene rather than a half-written one
+                published_.clear();
+                header().lines = 0;
+                header().points = 0;
+                header().sequence.store(sequence + 2, std::memory_order_release);
+                throw;
+            }
+            header().sequence.store(sequence + 2, std::memory_order_release);
+        }
+    };
+
+    /**
+     * @class SharedSceneReader
+     * @brief Read-only view of a scene published by a SharedSceneWriter
+     * @tparam T Numeric type of point coordinates, the same as the writer's
+     */
+    template<Numeric T>
+    class SharedSceneReader{
+    private:
+        /**
+         * @struct Mapping
+         * @brief Read-only mapping of the segment, shared with the polyline views
+         */
+        struct Mapping{
+            const void* memory = MAP_FAILED; ///< Start of the mapping
+            size_t bytes = 0; ///< Size of the mapping
+
+            ~Mapping(){
+                if(memory != MAP_FAILED){ ::munmap(const_cast<void*>(memory), bytes); }
+            }
+        };
+
+        std::string name_; ///< Name of the segment
+        int fd_ = -1; ///< Descriptor of the segment
+        std::shared_ptr<const Mapping> mapping_{}; ///< Current mapping, kept alive by the views
+        std::vector<Polyline<T>> views_{}; ///< Polylines over the points of the mapping
+        std::vector<LineId> ids_{}; ///< Identifiers of the views
+        uint64_t sequence_ = 0; ///< Sequence of the last consistent read
+
+        const SharedSceneHeader& header() const{ return *static_cast<const SharedSceneHeader*>(mapping_->memory); }
+
+        /**
+         * @brief Maps the whole segment as it is now
+         * @throws std::runtime_error if it cannot be mapped or was not written by a SharedSceneWriter<T>
+         */
+        void map(){
+            struct stat status{};
+            if(::fstat(fd_, &status) < 0){ throw std::runtime_error("Cannot stat shared scene " + name_ + ": " + std::strerror(errno)); }
+            if(static_cast<size_t>(status.st_size) < sizeof(SharedSceneHeader)){ throw std::runtime_error("Shared scene " + name_ + " is not initialized"); }
+            auto mapping = std::make_shared<Mapping>();
+            mapping->bytes = static_cast<size_t>(status.st_size);
+            mapping->memory = ::mmap(nullptr, mapping->bytes, PROT_READ, MAP_SHARED, fd_, 0);
+            if(mapping->memory == MAP_FAILED){ throw std::runtime_error("Cannot map shared scene " + name_ + ": " + std::strerror(errno)); }
+            mapping_ = std::move(mapping);
+            const SharedSceneHeader& shared = header();
+            if(shared.magic != shared_scene_magic || shared.point_size != sizeof(Point<T>) || shared.integral != std::is_integral_v<T>){
+                throw std::runtime_error("Shared scene " + name_ + " holds another point type");
+            }
+        }
+
+        /**
+         * @brief Builds the views from the current table, checking every bound
+         * @return bool False if the table does not fit the mapping, which only happens mid-write
+         */
+        bool collect(){
+            views_.clear();
+            ids_.clear();
+            const SharedSceneHeader& shared = header();
+            uint64_t line_capacity = shared.line_capacity, point_capacity = shared.point_capacity, lines = shared.lines;
+            size_t bytes = mapping_->bytes;
+            size_t table_bytes = bytes - sizeof(SharedSceneHeader);
+            if(line_capacity > table_bytes / sizeof(SharedLine) || lines > line_capacity){ return false; }
+            if(point_capacity > (table_bytes - line_capacity * sizeof(SharedLine)) / sizeof(Point<T>)){ return false; }
+            const char* base = static_cast<const char*>(mapping_->memory) + sizeof(SharedSceneHeader);
+            const SharedLine* entries = reinterpret_cast<const SharedLine*>(base);
+            const Point<T>* points = reinterpret_cast<const Point<T>*>(base + line_capacity * sizeof(SharedLine));
+            for(size_t i = 0; i < lines; i++){
+                SharedLine entry = entries[i];
+                if(entry.offset > point_capacity || entry.count > point_capacity - entry.offset){ return false; }
+                views_.push_back(Polyline<T>::borrow(mapping_, points + entry.offset, entry.count));
+                ids_.push_back(entry.id);
+            }
+            return true;
+        }
+
+    public:
+        /**
+         * @brief Constructor opening a published segment
+         * @param name Name of the segment, with or without the leading slash
+         * @throws std::runtime_error if there is no such segment or it holds another point type
+         */
+        explicit SharedSceneReader(const std::string& name) : name_(shared_memory_name(name)){
+            fd_ = ::shm_open(name_.c_str(), O_RDONLY | O_CLOEXEC, 0);
+            if(fd_ < 0){ throw std::runtime_error("Cannot open shared scene " + name_ + ": " + std::strerror(errno)); }
+            try{ map(); }
+            catch(...){
+                ::close(fd_);
+                throw;
+            }
+        }
+
+        SharedSceneReader(const SharedSceneReader&) = delete;
+        SharedSceneReader& operator=(const SharedSceneReader&) = delete;
+
+        /**
+         * @brief Destructor
+         *
+         * The mapping itself is released once the last view of it is gone.
+         */
+        ~SharedSceneReader(){
+            ::close(fd_);
+        }
+
+        /**
+         * @brief Get the sequence the writer is at
+         * @return uint64_t Sequence number, odd while a publish is in progress
+         *
+         * A reader can skip a frame while this equals sequence().
+         */
+        uint64_t published() const{ return header().sequence.load(std::memory_order_acquire); }
+
+        /**
+         * @brief Checks whether the writer can still publish
+         * @return bool False once the writer closed the segment or its process is gone
+         *
+         * The process is probed with kill(pid, 0), so the writer has to run in the
+         * same PID namespace as the reader.
+         */
+        bool writer_alive() const{
+            uint64_t writer = header().writer.load(std::memory_order_acquire);
+            if(writer == 0){ return false; }
+            return ::kill(static_cast<pid_t>(writer), 0) == 0 || errno == EPERM;
+        }
+
+        /**
+         * @brief Get the sequence of the last consistent read
+         * @return uint64_t Sequence number, 0 before the first read
+         */
+        uint64_t sequence() const{ return sequence_; }
+
+        /**
+         * @brief Hands the published polylines to a function until they were not changed meanwhile
+         * @tparam Visit Callable taking std::span<const Polyline<T>> and std::span<const LineId>
+         * @param visit Called with views of the points in shared memory and their identifiers
+         * @param attempts Number of tries before giving up
+         * @return bool True once visit saw a consistent scene; false if every try
+         *              overlapped a publish (or the writer died in the middle of one)
+         *
+         * visit may be called several times and must start over each time, for example
+         * by cleaning the buffer it draws into; only the last call saw consistent data.
+         * The views stay readable after read() returns, but the writer may change their
+         * points with the next publish.
+         */
+        template<typename Visit>
+        bool read(Visit&& visit, size_t attempts = 1 << 16){
+            for(size_t attempt = 0; attempt < attempts; attempt++){
+                uint64_t before = header().sequence.load(std::memory_order_acquire);
+                if(before & 1){
+                    std::this_thread::yield();
+                    continue;
+                }
+                if(header().bytes > mapping_->bytes){
+                    map();
+                    continue;
+                }
+                bool consistent = collect();
+                if(consistent){ visit(std::span<const Polyline<T>>(views_), std::span<const LineId>(ids_)); }
+                std::atomic_thread_fence(std::memory_order_acquire);
+                if(consistent && header().sequence.load(std::memory_order_relaxed) == before){
+                    sequence_ = before;
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+}
+
+#endif
@@ -1,9 +1,39 @@
 #include <gtest/gtest.h>
 #include <Matrix/Matrix.h>
 #include <Polyline/Polyline.h>
+#include <Polyline/Scene.h>
+#include <Polyline/Obj.h>
+#include <Polyline/SharedScene.h>
+#include <Buffer/Buffer.h>
+#include <Buffer/RenderTarget.h>
+#include <Buffer/Recording.h>
+#include <Buffer/Svg.h>
+#include <Utils/FrameStats.h>
+#include <Utils/InputReader.h>
+#include <Dialogue/Script.h>
+#include <Dialogue/History.h>
+#include <Dialogue/RenderThread.h>
+#include <Dialogue/Server.h>
+#include <Dialogue/Batch.h>
+#include <Utils/Mailbox.h>
+#include <Utils/Profiler.h>
 #include <vector>
 #include <array>
 #include <numeric>
+#include <numbers>
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <sstream>
+#include <fstream>
+#include <cstdio>
+#include <thread>
+#include <fcntl.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/wait.h>
 
 using namespace PolylineNameSpace;
 
@@ -495,4 +525,1418 @@ TEST(PolylineTest, Swap) {
     EXPECT_EQ(poly1[0].x, 4);
     EXPECT_EQ(poly2.points_count(), 1);
     EXPECT_EQ(poly2[0].x, 1);
-}
\ No newline at end of file
+}
+
+TEST(PolylineTest, VersionAndId) {
+    Polyline<double> poly;
+    poly.add_point(1, 2, 3, 'A');
+    poly.add_point(4, 5, 6, 'B');
+    uint64_t version = poly.version();
+    const Polyline<double>& view = poly;
+    EXPECT_EQ(view[0].x, 1);
+    EXPECT_EQ(poly.version(), version);
+    poly.shift(1, 0, 0);
+    EXPECT_GT(poly.version(), version);
+
+    // Copies keep the identity; diverging copies never share a version
+    Polyline<double> copy = poly;
+    EXPECT_EQ(copy.id(), poly.id());
+    EXPECT_EQ(copy.version(), poly.version());
+    copy.shift(1, 0, 0);
+    poly.shift(1, 0, 0);
+    EXPECT_NE(copy.version(), poly.version());
+    uint64_t id = poly.id();
+    Polyline<double> moved = std::move(poly);
+    EXPECT_EQ(moved.id(), id);
+    EXPECT_NE(poly.id(), id);
+}
+
+// ==================== Buffer Tests ====================
+
+template <size_t height, size_t width>
+std::string render_to_string(const BufferNameSpace::Buffer<height, width>& buffer) {
+    std::ostringstream out;
+    out << buffer;
+    return out.str();
+}
+
+TEST(BufferTest, TiledRenderMatchesSerial) {
+    std::mt19937 gen(42);
+    std::uniform_real_distribution<double> coord(-120.0, 120.0);
+    Polyline<double> polyline;
+    for (size_t i = 0; i < 20000; ++i) {
+        polyline.add_point(coord(gen), coord(gen), coord(gen), static_cast<char>('A' + i % 26));
+    }
+
+    BufferNameSpace::Buffer<74, 313> tiled;
+    tiled << polyline;
+
+    BufferNameSpace::Buffer<74, 313> serial;
+    for (size_t i = 1; i < polyline.points_count(); ++i) {
+        Polyline<double> segment;
+        segment.add_point(polyline[i - 1]);
+        segment.add_point(polyline[i]);
+        serial << segment;
+    }
+
+    EXPECT_EQ(render_to_string(tiled), render_to_string(serial));
+}
+
+TEST(BufferTest, BrailleEncoding) {
+    EXPECT_EQ(BufferNameSpace::braille_char(0x00), "⠀");
+    EXPECT_EQ(BufferNameSpace::braille_char(0xFF), "⣿");
+    EXPECT_EQ(BufferNameSpace::braille_char(BufferNameSpace::braille_bit(3, 1)), "⢀");
+    EXPECT_EQ(BufferNameSpace::braille_char(BufferNameSpace::braille_bit(1, 0) | BufferNameSpace::braille_bit(0, 1)), "⠊");
+}
+
+TEST(BufferTest, BrailleModeKeepsLabels) {
+    BufferNameSpace::Buffer<74, 313> buffer;
+    buffer.set_mode(BufferNameSpace::RenderMode::Braille);
+    Polyline<double> polyline;
+    polyline.add_point(10, 20, 5, 'A');
+    polyline.add_point(-10, 40, -5, 'B');
+    buffer << polyline;
+    std::string frame = render_to_string(buffer);
+    EXPECT_NE(frame.find('A'), std::string::npos);
+    EXPECT_NE(frame.find('B'), std::string::npos);
+    EXPECT_NE(frame.find("\xE2\xA0"), std::string::npos);
+    EXPECT_EQ(frame.find('-'), std::string::npos);
+}
+
+TEST(BufferTest, DefaultCameraIsIsometric) {
+    BufferNameSpace::Camera camera;
+    const auto& matrix = camera.matrix();
+    EXPECT_NEAR((matrix[0, 0]), 1 / std::sqrt(15), 1e-12);
+    EXPECT_NEAR((matrix[1, 0]), 1 / std::sqrt(15), 1e-12);
+    EXPECT_NEAR((matrix[2, 0]), -0.6, 1e-12);
+    EXPECT_NEAR((matrix[0, 1]), -1, 1e-12);
+    EXPECT_NEAR((matrix[1, 1]), 1, 1e-12);
+    EXPECT_NEAR((matrix[2, 1]), 0, 1e-12);
+    EXPECT_NEAR((matrix[3, 2]), 1, 1e-12);
+}
+
+TEST(BufferTest, CameraZoomAndPan) {
+    BufferNameSpace::Camera camera;
+    size_t version = camera.version();
+    camera.zoom(2);
+    camera.pan(3, -4);
+    EXPECT_GT(camera.version(), version);
+    const auto& matrix = camera.matrix();
+    EXPECT_NEAR((matrix[1, 1]), 2, 1e-12);
+    EXPECT_NEAR((matrix[3, 0]), 3, 1e-12);
+    EXPECT_NEAR((matrix[3, 1]), -4, 1e-12);
+    EXPECT_THROW(camera.zoom(0), std::invalid_argument);
+}
+
+TEST(BufferTest, CachedBackground) {
+    BufferNameSpace::Buffer<74, 313> buffer;
+    std::string empty = render_to_string(buffer);
+
+    Polyline<double> polyline;
+    polyline.add_point(10, 20, 5, 'A');
+    polyline.add_point(-10, 40, -5, 'B');
+    buffer << polyline;
+    buffer.clean_buffer();
+    EXPECT_EQ(render_to_string(buffer), empty);
+
+    buffer.add_background(polyline);
+    std::string with_background = render_to_string(buffer);
+    EXPECT_NE(with_background, empty);
+    buffer.clean_buffer();
+    EXPECT_EQ(render_to_string(buffer), with_background);
+
+    buffer.camera().zoom(2);
+    buffer.clean_buffer();
+    EXPECT_NE(render_to_string(buffer), with_background);
+
+    buffer.camera().reset();
+    buffer.clear_background();
+    EXPECT_EQ(render_to_string(buffer), empty);
+}
+
+TEST(BufferTest, ClipSegment) {
+    BufferNameSpace::ClipRect rect = {0, 10, 0, 20};
+    BufferNameSpace::BufferPoint start = {5, -10};
+    BufferNameSpace::BufferPoint end = {5, 30};
+    bool start_clipped = false, end_clipped = false;
+    ASSERT_TRUE(BufferNameSpace::clip_segment(start, end, rect, start_clipped, end_clipped));
+    EXPECT_TRUE(start_clipped);
+    EXPECT_TRUE(end_clipped);
+    EXPECT_DOUBLE_EQ(start.y, 0);
+    EXPECT_DOUBLE_EQ(end.y, 20);
+
+    BufferNameSpace::BufferPoint outside1 = {-5, 0};
+    BufferNameSpace::BufferPoint outside2 = {0, -5};
+    EXPECT_FALSE(BufferNameSpace::clip_segment(outside1, outside2, rect, start_clipped, end_clipped));
+    EXPECT_NE(BufferNameSpace::outcode({-5, 0}, rect) & BufferNameSpace::outcode({-1, 25}, rect), 0);
+}
+
+TEST(BufferTest, OffscreenSegmentsAreClipped) {
+    BufferNameSpace::Buffer<74, 313> buffer;
+    std::string empty = render_to_string(buffer);
+
+    Polyline<double> offscreen;
+    offscreen.add_point(1e9, -1e9, 0, 'A');
+    offscreen.add_point(2e9, -2e9, 0, 'B');
+    buffer << offscreen;
+    EXPECT_EQ(render_to_string(buffer), empty);
+
+    Polyline<double> crossing;
+    crossing.add_point(0, 20, 0, 'C');
+    crossing.add_point(0, 1e9, 0, 'D');
+    buffer << crossing;
+    std::string frame = render_to_string(buffer);
+    EXPECT_NE(frame.find('C'), std::string::npos);
+    EXPECT_EQ(frame.find('D'), std::string::npos);
+
+    // Segments crossing the border draw the cells the whole line covers inside the
+    // buffer, including the one where they leave it
+    buffer.clean_buffer();
+    std::string background;
+    buffer.encode(background, BufferNameSpace::FrameFormat::Plain);
+    auto unclipped = [&background](const BufferNameSpace::BufferPoint& p1, const BufferNameSpace::BufferPoint& p2) {
+        std::string cells = background;
+        auto clamp = [](double value, size_t size) { return static_cast<size_t>(std::clamp(value, 0.0, static_cast<double>(size - 1))); };
+        size_t min_x = clamp(std::min(p1.x, p2.x), 74), max_x = clamp(std::max(p1.x, p2.x), 74);
+        size_t min_y = clamp(std::min(p1.y, p2.y), 313), max_y = clamp(std::max(p1.y, p2.y), 313);
+        double length = std::hypot(p2.x - p1.x, p2.y - p1.y);
+        for (size_t x = min_x; x <= max_x; ++x) {
+            for (size_t y = min_y; y <= max_y; ++y) {
+                double distance = std::abs((p2.x - p1.x) * (p1.y - static_cast<double>(y)) - (p1.x - static_cast<double>(x)) * (p2.y - p1.y)) / length;
+                if (min_y == max_y || distance < 0.4) { cells[x * 314 + y] = '-'; }
+            }
+        }
+        for (const BufferNameSpace::BufferPoint& p : {p1, p2}) {
+            if (p.x >= 0 && p.x < 74 && p.y >= 0 && p.y < 313) { cells[static_cast<size_t>(p.x) * 314 + static_cast<size_t>(p.y)] = 'L'; }
+        }
+        return cells;
+    };
+    std::mt19937 gen(7);
+    std::uniform_real_distribution<double> coord(-40.0, 40.0);
+    BufferNameSpace::Projector projector = buffer.view_projector(0);
+    size_t crossing_count = 0;
+    while (crossing_count < 200) {
+        Polyline<double> segment;
+        segment.add_point(coord(gen), coord(gen), coord(gen), 'L');
+        segment.add_point(coord(gen), coord(gen), coord(gen), 'L');
+        BufferNameSpace::BufferPoint p1 = projector(segment[0]), p2 = projector(segment[1]);
+        auto visible = [](const BufferNameSpace::BufferPoint& p) { return p.x >= 0 && p.x < 74 && p.y >= 0 && p.y < 313; };
+        if (visible(p1) == visible(p2)) { continue; }
+        ++crossing_count;
+        buffer.clean_buffer();
+        buffer << segment;
+        std::string plain;
+        buffer.encode(plain, BufferNameSpace::FrameFormat::Plain);
+        EXPECT_EQ(plain, unclipped(p1, p2)) << "segment " << p1.x << ", " << p1.y << " to " << p2.x << ", " << p2.y;
+    }
+}
+
+TEST(BufferTest, ColorEscapes) {
+    std::string escape;
+    BufferNameSpace::Color::rgb(255, 0, 10).append_escape(escape);
+    EXPECT_EQ(escape, "\033[38;2;255;0;10m");
+    escape.clear();
+    BufferNameSpace::Color::indexed(196).append_escape(escape);
+    EXPECT_EQ(escape, "\033[38;5;196m");
+    escape.clear();
+    BufferNameSpace::Color::automatic().append_escape(escape);
+    EXPECT_TRUE(escape.empty());
+}
+
+TEST(BufferTest, ColorEscapeOnlyOnChange) {
+    BufferNameSpace::Buffer<74, 313> buffer;
+    Polyline<double> polyline;
+    polyline.add_point(50, -50, 0, 'A');
+    polyline.add_point(-50, 50, 0, 'B');
+    buffer << BufferNameSpace::Color::rgb(255, 0, 0) << polyline;
+    std::string frame = render_to_string(buffer);
+
+    size_t red = 0;
+    for (size_t pos = frame.find("38;2;255;0;0m"); pos != std::string::npos; pos = frame.find("38;2;255;0;0m", pos + 1)) {
+        ++red;
+    }
+    // The red line lies in a single row, so its color is selected once or twice
+    EXPECT_GE(red, 1);
+    EXPECT_LE(red, 2);
+    EXPECT_LT(frame.size(), 74 * 313 * 2);
+}
+
+TEST(BufferTest, InstancesMatchShiftedCopies) {
+    Polyline<double> shape;
+    shape.add_point(0, 0, 0, 'A');
+    shape.add_point(5, 0, 3, 'B');
+    shape.add_point(0, 7, -2, 'C');
+
+    std::vector<BufferNameSpace::Transform> transforms;
+    BufferNameSpace::Buffer<74, 313> copies;
+    for (int i = 0; i < 10; ++i) {
+        transforms.push_back(BufferNameSpace::translation(i * 6, -i * 4, i));
+        Polyline<double> copy = shape;
+        copy.shift(i * 6, -i * 4, i);
+        copies << copy;
+    }
+
+    BufferNameSpace::Buffer<74, 313> instanced;
+    instanced.draw_instances(shape, std::span<const BufferNameSpace::Transform>(transforms));
+    EXPECT_EQ(render_to_string(instanced), render_to_string(copies));
+}
+
+TEST(BufferTest, PaletteReusesColorsNoLongerDrawn) {
+    auto buffer = std::make_unique<BufferNameSpace::Buffer<74, 313>>();
+    Polyline<double> polyline;
+    polyline.add_point(50, -50, 0, 'A');
+    polyline.add_point(-50, 50, 0, 'B');
+    // More distinct colors than one palette holds, one per frame
+    for (int frame = 0; frame < 300; ++frame) {
+        buffer->clean_buffer();
+        auto color = BufferNameSpace::Color::rgb(static_cast<uint8_t>(frame % 256), static_cast<uint8_t>(frame / 256), 7);
+        ASSERT_NO_THROW(*buffer << color << polyline);
+        std::string escape;
+        color.append_escape(escape);
+        std::string text = render_to_string(*buffer);
+        ASSERT_NE(text.find(escape), std::string::npos) << "frame " << frame;
+    }
+
+    // Colors still on screen keep their indices
+    auto layered = std::make_unique<BufferNameSpace::Buffer<74, 313>>();
+    *layered << BufferNameSpace::Layer::Overlay << BufferNameSpace::Color::rgb(1, 2, 3) << polyline;
+    *layered << BufferNameSpace::Layer::Dynamic;
+    for (int frame = 0; frame < 300; ++frame) {
+        layered->clear_layer(BufferNameSpace::Layer::Dynamic);
+        *layered << BufferNameSpace::Color::rgb(static_cast<uint8_t>(frame % 256), 100, static_cast<uint8_t>(frame / 256));
+        Polyline<double> shifted = polyline;
+        shifted.shift(0, 0, 40);
+        *layered << shifted;
+    }
+    EXPECT_NE(render_to_string(*layered).find("38;2;1;2;3m"), std::string::npos);
+}
+
+TEST(BufferTest, SegmentsAreCutAtTheNearPlane) {
+    auto buffer = std::make_unique<BufferNameSpace::Buffer<74, 313>>();
+    buffer->camera().set_projection(BufferNameSpace::Projection::Perspective);
+    BufferNameSpace::Projector projector = buffer->view_projector(0);
+    // w = 1 + p . g, so twice the eye distance along -g is behind the eye
+    double g[3] = {projector.m[0][2], projector.m[1][2], projector.m[2][2]};
+    double scale = -2 / (g[0] * g[0] + g[1] * g[1] + g[2] * g[2]);
+    Polyline<double> line;
+    line.add_point(20, -10, 5, 'A');
+    line.add_point(g[0] * scale + 30, g[1] * scale - 20, g[2] * scale, 'B');
+    ASSERT_FALSE(projector.behind(line[0]));
+    ASSERT_TRUE(projector.behind(line[1]));
+
+    auto plain = [&buffer]() {
+        std::string frame;
+        buffer->encode(frame, BufferNameSpace::FrameFormat::Plain);
+        return frame;
+    };
+    buffer->clean_buffer();
+    std::string empty = plain();
+    *buffer << line;
+    std::string drawn = plain();
+
+    // Every cell of the line lies on the ray from A towards the crossing point
+    BufferNameSpace::BufferPoint start = projector(line[0]);
+    BufferNameSpace::BufferPoint crossing = projector.near_point(line[1], line[0]);
+    double length = std::hypot(crossing.x - start.x, crossing.y - start.y);
+    double dx = (crossing.x - start.x) / length, dy = (crossing.y - start.y) / length;
+    size_t cells = 0;
+    for (size_t at = 0; at < drawn.size(); ++at) {
+        if (drawn[at] == empty[at]) { continue; }
+        double x = static_cast<double>(at / 314) - start.x, y = static_cast<double>(at % 314) - start.y;
+        EXPECT_GE(x * dx + y * dy, -1.5) << "cell " << x << ", " << y;
+        EXPECT_LE(std::abs(x * dy - y * dx), 1.5) << "cell " << x << ", " << y;
+        EXPECT_NE(drawn[at], 'B');
+        ++cells;
+    }
+    EXPECT_GT(cells, 5u);
+
+    // The SVG export cuts the segment at the same point
+    std::string svg = BufferNameSpace::render_svg(*buffer, std::vector<Polyline<double>>{line});
+    EXPECT_NE(svg.find(">A</text>"), std::string::npos);
+    EXPECT_EQ(svg.find(">B</text>"), std::string::npos);
+}
+
+TEST(BufferTest, TransformComposition) {
+    auto transform = BufferNameSpace::compose(BufferNameSpace::rotation(0, 0, 90), BufferNameSpace::translation(1, 2, 3));
+    Matrix<double, 1, 4> point = {1, 0, 0, 1};
+    auto result = point * transform;
+    EXPECT_NEAR((result[0, 0]), 1.0, 1e-10);
+    EXPECT_NEAR((result[0, 1]), 3.0, 1e-10);
+    EXPECT_NEAR((result[0, 2]), 3.0, 1e-10);
+}
+
+TEST(BufferTest, PlainFrameHasNoEscapes) {
+    BufferNameSpace::Buffer<74, 313> buffer;
+    Polyline<double> line;
+    line.add_point(0, 0, 0, 'A');
+    line.add_point(20, 10, 5, 'B');
+    buffer << BufferNameSpace::Color::rgb(255, 0, 0) << line;
+    std::string plain;
+    buffer.encode(plain, BufferNameSpace::FrameFormat::Plain);
+    EXPECT_EQ(plain.find('\033'), std::string::npos);
+    EXPECT_EQ(plain.size(), 74u * (313u + 1u));
+    EXPECT_NE(plain.find('A'), std::string::npos);
+}
+
+TEST(BufferTest, BitmapFrames) {
+    BufferNameSpace::Buffer<74, 313> buffer;
+    std::string pgm, ppm;
+    buffer.encode(pgm, BufferNameSpace::FrameFormat::Pgm);
+    buffer.encode(ppm, BufferNameSpace::FrameFormat::Ppm);
+    std::string pgm_header = "P5\n313 74\n255\n", ppm_header = "P6\n313 74\n255\n";
+    ASSERT_EQ(pgm.compare(0, pgm_header.size(), pgm_header), 0);
+    ASSERT_EQ(ppm.compare(0, ppm_header.size(), ppm_header), 0);
+    EXPECT_EQ(pgm.size(), pgm_header.size() + 74u * 313u);
+    EXPECT_EQ(ppm.size(), ppm_header.size() + 74u * 313u * 3u);
+
+    buffer.set_mode(BufferNameSpace::RenderMode::Braille);
+    std::string braille;
+    buffer.encode(braille, BufferNameSpace::FrameFormat::Pgm);
+    std::string braille_header = "P5\n626 296\n255\n";
+    ASSERT_EQ(braille.compare(0, braille_header.size(), braille_header), 0);
+    EXPECT_EQ(braille.size(), braille_header.size() + 296u * 626u);
+}
+
+TEST(BufferTest, RenderTargetWritesFile) {
+    BufferNameSpace::Buffer<74, 313> buffer;
+    std::string expected;
+    buffer.encode(expected, BufferNameSpace::FrameFormat::Plain);
+    std::string path = testing::TempDir() + "render_target_frame.txt";
+    {
+        BufferNameSpace::RenderTarget target(path, BufferNameSpace::frame_format_from_name("plain"));
+        target.write(buffer);
+        target.write(buffer);
+    }
+    std::ifstream file(path, std::ios::binary);
+    std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    EXPECT_EQ(written, expected + expected);
+    std::remove(path.c_str());
+    EXPECT_THROW(BufferNameSpace::frame_format_from_name("gif"), std::invalid_argument);
+}
+
+TEST(FrameStatsTest, Percentiles) {
+    UtilsNameSpace::LatencyStats stats;
+    EXPECT_EQ(stats.percentile(50), 0.0);
+    for (int i = 100; i >= 1; --i) {
+        stats.add(i);
+    }
+    EXPECT_EQ(stats.count(), 100u);
+    EXPECT_EQ(stats.percentile(50), 50.0);
+    EXPECT_EQ(stats.percentile(99), 99.0);
+    EXPECT_EQ(stats.percentile(100), 100.0);
+    EXPECT_EQ(stats.percentile(0), 1.0);
+    EXPECT_EQ(stats.max(), 100.0);
+}
+
+TEST(BufferTest, StageTimesAccumulate) {
+    BufferNameSpace::Buffer<74, 313> buffer;
+    Polyline<double> line;
+    for (int i = 0; i < 1000; ++i) {
+        line.add_point(i % 50, (i * 7) % 40, i % 13, 'A');
+    }
+    buffer << line;
+    auto first = buffer.stage_times();
+    EXPECT_GT(first.projection.count(), 0);
+    EXPECT_GT(first.rasterization.count(), 0);
+    buffer << line;
+    EXPECT_GT(buffer.stage_times().rasterization, first.rasterization);
+    buffer.reset_stage_times();
+    EXPECT_EQ(buffer.stage_times().projection.count(), 0);
+}
+
+namespace {
+    Polyline<double> make_pentagram(double radius) {
+        Polyline<double> star;
+        for (int i = 0; i < 5; ++i) {
+            double angle = (90.0 + 144.0 * i) * std::numbers::pi / 180.0;
+            star.add_point(radius * std::cos(angle), radius * std::sin(angle), 0, 'S');
+        }
+        return star;
+    }
+
+    size_t count_glyph(const std::string& frame, char glyph) {
+        return static_cast<size_t>(std::count(frame.begin(), frame.end(), glyph));
+    }
+}
+
+TEST(BufferTest, FillRules) {
+    BufferNameSpace::Buffer<74, 313> even_odd, non_zero;
+    Polyline<double> star = make_pentagram(30);
+    even_odd.fill(star, {BufferNameSpace::FillRule::EvenOdd, '@'});
+    non_zero.fill(star, {BufferNameSpace::FillRule::NonZero, '@'});
+    std::string even_odd_frame, non_zero_frame;
+    even_odd.encode(even_odd_frame, BufferNameSpace::FrameFormat::Plain);
+    non_zero.encode(non_zero_frame, BufferNameSpace::FrameFormat::Plain);
+
+    // The origin projects to row 49, column 156; the inner pentagon is a hole only for even-odd
+    size_t center = 49 * 314 + 156;
+    EXPECT_NE(even_odd_frame[center], '@');
+    EXPECT_EQ(non_zero_frame[center], '@');
+    EXPECT_GT(count_glyph(even_odd_frame, '@'), 0u);
+    EXPECT_GT(count_glyph(non_zero_frame, '@'), count_glyph(even_odd_frame, '@'));
+    for (size_t i = 0; i < even_odd_frame.size(); ++i) {
+        if (even_odd_frame[i] == '@') {
+            EXPECT_EQ(non_zero_frame[i], '@');
+        }
+    }
+}
+
+TEST(BufferTest, FillMatchesPointInPolygon) {
+    // Cell (row, col) is filled when its center (row, col + 0.5) is inside the projected outline
+    BufferNameSpace::Buffer<74, 313> buffer;
+    Polyline<double> shape;
+    shape.add_point(-20, -5, 0, 'A');
+    shape.add_point(25, -10, 0, 'B');
+    shape.add_point(5, 30, 0, 'C');
+    shape.add_point(0, 8, 0, 'D');
+    buffer.fill(shape, {BufferNameSpace::FillRule::EvenOdd, '@'});
+    std::string frame;
+    buffer.encode(frame, BufferNameSpace::FrameFormat::Plain);
+
+    const auto& matrix = buffer.camera().matrix();
+    std::vector<std::pair<double, double>> outline;
+    for (size_t i = 0; i < shape.points_count(); ++i) {
+        double row = shape[i].x * (matrix[0, 0]) + shape[i].y * (matrix[1, 0]) + (matrix[3, 0]);
+        double col = shape[i].x * (matrix[0, 1]) + shape[i].y * (matrix[1, 1]) + (matrix[3, 1]);
+        outline.push_back({std::round(row) + 74 * 2 / 3, col + 313 / 2.0});
+    }
+    size_t mismatches = 0, filled = 0;
+    for (size_t row = 0; row < 74; ++row) {
+        for (size_t col = 0; col < 313; ++col) {
+            double x = row, y = col + 0.5;
+            bool inside = false;
+            for (size_t i = 0, j = outline.size() - 1; i < outline.size(); j = i++) {
+                auto [xi, yi] = outline[i];
+                auto [xj, yj] = outline[j];
+                if ((xi <= x) != (xj <= x) && y < yi + (x - xi) * (yj - yi) / (xj - xi)) {
+                    inside = !inside;
+                }
+            }
+            filled += inside;
+            mismatches += inside != (frame[row * 314 + col] == '@');
+        }
+    }
+    EXPECT_GT(filled, 100u);
+    EXPECT_EQ(mismatches, 0u);
+}
+
+namespace {
+    template <size_t height, size_t width>
+    std::string plain_frame(const BufferNameSpace::Buffer<height, width>& buffer) {
+        std::string frame;
+        buffer.encode(frame, BufferNameSpace::FrameFormat::Plain);
+        return frame;
+    }
+
+    std::string crop(const std::string& frame, size_t frame_width, const BufferNameSpace::Tile& area) {
+        std::string result;
+        for (size_t row = area.row_begin; row < area.row_end; ++row) {
+            result += frame.substr(row * (frame_width + 1) + area.col_begin, area.col_end - area.col_begin);
+            result += '\n';
+        }
+        return result;
+    }
+}
+
+TEST(BufferTest, ViewportsMatchSeparateBuffers) {
+    Polyline<double> shape;
+    shape.add_point(-40, 10, 5, 'A');
+    shape.add_point(30, 25, -10, 'B');
+    shape.add_point(10, -35, 30, 'C');
+    shape.add_point(-20, -20, -25, 'D');
+
+    BufferNameSpace::Buffer<74, 313> quad;
+    quad.set_viewports(BufferNameSpace::quad_viewports(74, 313));
+    ASSERT_EQ(quad.viewports().size(), 4u);
+    quad.viewport_camera(3).orbit(30, 0);
+    quad.clean_buffer();
+    quad << shape;
+    std::string frame = plain_frame(quad);
+
+    BufferNameSpace::Buffer<36, 156> top;
+    top.camera().set_view(BufferNameSpace::View::Top);
+    top.camera().zoom(0.5);
+    top.clean_buffer();
+    top << shape;
+    EXPECT_EQ(crop(frame, 313, quad.viewports()[0].area), plain_frame(top));
+
+    BufferNameSpace::Buffer<37, 156> isometric;
+    isometric.camera().zoom(0.5);
+    isometric.camera().orbit(30, 0);
+    isometric.clean_buffer();
+    isometric << shape;
+    EXPECT_EQ(crop(frame, 313, quad.viewports()[3].area), plain_frame(isometric));
+
+    // The separating row and column stay empty
+    EXPECT_EQ(crop(frame, 313, {36, 37, 0, 313}), std::string(313, ' ') + "\n");
+    for (size_t row = 0; row < 74; ++row) {
+        EXPECT_EQ(frame[row * 314 + 156], ' ');
+    }
+
+    quad.set_viewports({});
+    BufferNameSpace::Buffer<74, 313> single;
+    quad << shape;
+    single << shape;
+    EXPECT_EQ(plain_frame(quad), plain_frame(single));
+    EXPECT_THROW(quad.set_viewports({{BufferNameSpace::Tile{0, 75, 0, 10}, BufferNameSpace::Camera()}}), std::invalid_argument);
+}
+
+TEST(BufferTest, CachedProjectionMatchesDirect) {
+    std::mt19937 gen(3);
+    std::uniform_real_distribution<double> coordinate(-60, 60);
+    std::vector<Polyline<double>> lines(50);
+    for (auto& line : lines) {
+        for (int i = 0; i < 20; ++i) {
+            line.add_point(coordinate(gen), coordinate(gen), coordinate(gen), 'A' + i);
+        }
+    }
+    auto direct_frame = [&lines]() {
+        BufferNameSpace::Buffer<74, 313> direct;
+        for (const auto& line : lines) {
+            direct << line;
+        }
+        return plain_frame(direct);
+    };
+
+    BufferNameSpace::Buffer<74, 313> cached;
+    for (int frame = 0; frame < 4; ++frame) {
+        if (frame == 2) {
+            lines[7].shift(5, -3, 2);
+        }
+        cached.clean_buffer();
+        for (const auto& line : lines) {
+            cached.draw_cached(line);
+        }
+        EXPECT_EQ(plain_frame(cached), direct_frame());
+    }
+    EXPECT_EQ(cached.cached_projections(), 50u);
+
+    cached.camera().orbit(40, 0);
+    cached.clean_buffer();
+    for (const auto& line : lines) {
+        cached.draw_cached(line);
+    }
+    BufferNameSpace::Buffer<74, 313> rotated;
+    rotated.camera().orbit(40, 0);
+    rotated.clean_buffer();
+    for (const auto& line : lines) {
+        rotated << line;
+    }
+    EXPECT_EQ(plain_frame(cached), plain_frame(rotated));
+
+    cached.set_mode(BufferNameSpace::RenderMode::Braille);
+    rotated.set_mode(BufferNameSpace::RenderMode::Braille);
+    for (int frame = 0; frame < 2; ++frame) {
+        cached.clean_buffer();
+        for (const auto& line : lines) {
+            cached.draw_cached(line);
+        }
+    }
+    for (const auto& line : lines) {
+        rotated << line;
+    }
+    EXPECT_EQ(plain_frame(cached), plain_frame(rotated));
+}
+
+TEST(BufferTest, CachedProjectionSeesShrunkPolylines) {
+    Polyline<double> line;
+    line.add_point(0, 0, 0, 'A');
+    line.add_point(20, 10, 5, 'B');
+    line.add_point(-15, 30, 10, 'C');
+    BufferNameSpace::Buffer<74, 313> cached;
+    cached.draw_cached(line);
+    uint64_t version = line.version();
+    line.resize(1);
+    EXPECT_NE(line.version(), version);
+    cached.clean_buffer();
+    cached.draw_cached(line);
+    BufferNameSpace::Buffer<74, 313> direct;
+    direct << line;
+    std::string frame = plain_frame(cached);
+    EXPECT_EQ(frame, plain_frame(direct));
+    EXPECT_EQ(frame.find('C'), std::string::npos);
+
+    // Growing keeps the points, so the cached projection stays valid
+    version = line.version();
+    line.resize(8);
+    EXPECT_EQ(line.version(), version);
+}
+
+TEST(BufferTest, LayersMatchRedrawnFrames) {
+    Polyline<double> scenery = make_pentagram(30);
+    Polyline<double> label;
+    label.add_point(0, 0, 40, 'L');
+    for (auto mode : {BufferNameSpace::RenderMode::Ascii, BufferNameSpace::RenderMode::Braille}) {
+        BufferNameSpace::Buffer<74, 313> layered;
+        layered.set_mode(mode);
+        layered << BufferNameSpace::Layer::Static << BufferNameSpace::Color::indexed(3) << scenery;
+        layered << BufferNameSpace::Layer::Overlay << BufferNameSpace::Color::automatic() << label;
+        for (int frame = 0; frame < 5; ++frame) {
+            Polyline<double> mover;
+            mover.add_point(frame * 6.0 - 10, -12, 0, 'M');
+            mover.add_point(frame * 6.0 - 4, -6, 3, 'N');
+            layered.clear_layer(BufferNameSpace::Layer::Dynamic);
+            layered << BufferNameSpace::Layer::Dynamic << mover;
+
+            BufferNameSpace::Buffer<74, 313> redrawn;
+            redrawn.set_mode(mode);
+            redrawn << BufferNameSpace::Color::indexed(3) << scenery << BufferNameSpace::Color::automatic() << mover << label;
+            EXPECT_EQ(render_to_string(layered), render_to_string(redrawn));
+        }
+    }
+
+    BufferNameSpace::Buffer<74, 313> buffer;
+    EXPECT_THROW(buffer << BufferNameSpace::Layer::Background, std::invalid_argument);
+    EXPECT_THROW(buffer.clear_layer(BufferNameSpace::Layer::Background), std::invalid_argument);
+    std::string empty = render_to_string(buffer);
+    buffer << BufferNameSpace::Layer::Static << scenery;
+    buffer.clean_buffer();
+    EXPECT_EQ(render_to_string(buffer), empty);
+}
+
+TEST(BufferTest, CleanDynamicKeepsStaticLayerUntilTheViewChanges) {
+    Polyline<double> scenery = make_pentagram(30);
+    BufferNameSpace::Buffer<74, 313> layered;
+    EXPECT_TRUE(layered.clean_dynamic());
+    layered << BufferNameSpace::Layer::Static << scenery << BufferNameSpace::Layer::Dynamic;
+    for (int frame = 0; frame < 4; ++frame) {
+        Polyline<double> mover;
+        mover.add_point(frame * 6.0 - 10, -12, 0, 'M');
+        mover.add_point(frame * 6.0 - 4, -6, 3, 'N');
+        if (frame == 2) { layered.camera().zoom(2); }
+        bool redraw = layered.clean_dynamic();
+        EXPECT_EQ(redraw, frame == 2);
+        if (redraw) { layered << BufferNameSpace::Layer::Static << scenery << BufferNameSpace::Layer::Dynamic; }
+        layered << mover;
+
+        BufferNameSpace::Buffer<74, 313> redrawn;
+        redrawn.camera() = layered.camera();
+        redrawn.clean_buffer();
+        redrawn << scenery << mover;
+        EXPECT_EQ(render_to_string(layered), render_to_string(redrawn));
+    }
+    layered.clean_buffer();
+    EXPECT_TRUE(layered.clean_dynamic());
+    layered.set_mode(BufferNameSpace::RenderMode::Braille);
+    EXPECT_TRUE(layered.clean_dynamic());
+    EXPECT_FALSE(layered.clean_dynamic());
+}
+
+namespace {
+    // Applies the output of a plain (uncolored) recording to a screen of ASCII rows
+    void apply_terminal_output(std::vector<std::string>& screen, const std::string& output) {
+        size_t row = 0, col = 0;
+        for (size_t i = 0; i < output.size(); ++i) {
+            if (output[i] != '\033') {
+                screen[row][col++] = output[i];
+                continue;
+            }
+            size_t end = output.find_first_of("HJm", i);
+            std::string arguments = output.substr(i + 2, end - i - 2);
+            if (output[end] == 'J') {
+                for (auto& line : screen) {
+                    line.assign(line.size(), ' ');
+                }
+            } else if (output[end] == 'H') {
+                row = std::stoul(arguments) - 1;
+                col = std::stoul(arguments.substr(arguments.find(';') + 1)) - 1;
+            }
+            i = end;
+        }
+    }
+}
+
+TEST(BufferTest, RecordingReplaysFrames) {
+    std::string path = testing::TempDir() + "session.cast";
+    std::vector<std::string> frames;
+    {
+        BufferNameSpace::Recorder recorder(path, 8, false);
+        BufferNameSpace::Buffer<74, 313> buffer;
+        for (int frame = 0; frame < 20; ++frame) {
+            Polyline<double> mover = make_pentagram(10);
+            mover.shift(frame * 2.0, -frame * 1.0, 0);
+            buffer.clean_buffer();
+            buffer << mover;
+            recorder.record(buffer, frame * 0.1);
+            frames.push_back(plain_frame(buffer));
+        }
+        EXPECT_EQ(recorder.frames(), 20u);
+    }
+    std::ifstream file(path, std::ios::binary);
+    BufferNameSpace::Player player(file);
+    std::remove(path.c_str());
+    EXPECT_EQ(player.height(), 74u);
+    EXPECT_EQ(player.width(), 313u);
+    ASSERT_EQ(player.events().size(), 20u);
+    EXPECT_TRUE(player.events()[8].keyframe);
+    EXPECT_FALSE(player.events()[9].keyframe);
+    EXPECT_LT(player.events()[9].data.size() * 5, player.events()[8].data.size());
+
+    for (size_t frame = 0; frame < frames.size(); ++frame) {
+        std::string output;
+        EXPECT_EQ(player.frame_at(output, frame * 0.1 + 0.01), frame + 1);
+        std::vector<std::string> screen(74, std::string(313, ' '));
+        apply_terminal_output(screen, output);
+        std::string text;
+        for (const auto& line : screen) {
+            text += line + '\n';
+        }
+        EXPECT_EQ(text, frames[frame]);
+    }
+
+    std::istringstream malformed("{\"version\": 2}\n[0.5, \"o\"\n");
+    EXPECT_THROW(BufferNameSpace::Player{malformed}, std::runtime_error);
+}
+
+TEST(ScriptTest, RunsCommandsWithoutPrompts) {
+    std::string path = testing::TempDir() + "script_frame.txt";
+    std::istringstream script(
+        "# two lines, joined and shifted\n"
+        "create 0 0 0 A 10 0 0 B\n"
+        "create 0 10 0 C   0 10 10 D 40 40 40 E\n"
+        "\n"
+        "join 1 2\n"
+        "prune 1\n"
+        "shift 1 1 -2 0.5\n"
+        "camera orbit 30 0\n"
+        "render plain " + path + "\n");
+    Scene<double> scene;
+    auto buffer = std::make_unique<BufferNameSpace::Buffer<74, 313>>();
+    DialogueNameSpace::run_script(script, scene, *buffer);
+    ASSERT_EQ(scene.size(), 1u);
+    Polyline<double>& joined = scene.at(LineId{0, 0});
+    EXPECT_EQ(joined.points_count(), 4u);
+    EXPECT_EQ(joined[0].x, 1);
+    EXPECT_EQ(joined[0].z, 0.5);
+
+    BufferNameSpace::Buffer<74, 313> expected;
+    expected.camera().orbit(30, 0);
+    expected.clean_buffer();
+    DialogueNameSpace::draw_lines(scene, expected);
+    std::ifstream file(path, std::ios::binary);
+    std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::remove(path.c_str());
+    EXPECT_EQ(written, plain_frame(expected));
+
+    // The new line reuses the slot of line 2 as 2.1, so 2 stays invalid
+    std::istringstream bad("create 0 0 0 A\ngroup 2.1 top\nshift top 1 1 1\nshift 2 1 1 1\n");
+    try {
+        DialogueNameSpace::run_script(bad, scene, *buffer);
+        FAIL() << "expected an error";
+    } catch (const std::runtime_error& e) {
+        EXPECT_STREQ(e.what(), "Script line 4: no line or group '2'");
+    }
+    EXPECT_EQ(scene.at(LineId{1, 1})[0].z, 1);
+}
+
+TEST(InputReaderTest, NumbersAndPoints) {
+    std::istringstream in("12 x\n-1\n7 +2.5\nQ 300\n1\n1 2 3 A\n4 5 bad B\n4 5 6 B 7 8\n9 C\n");
+    std::ostringstream feedback;
+    UtilsNameSpace::InputReader reader(in, feedback);
+    EXPECT_EQ(reader.number<int>(0, 100), 12);
+    EXPECT_EQ(reader.number<size_t>(1, 10), 7u);
+    EXPECT_EQ(reader.number<double>(-10, 10), 2.5);
+    EXPECT_EQ(reader.number<char>('A', 'z'), 'Q');
+    EXPECT_EQ(reader.number<int>(0, 255), 1);
+
+    Point<double> first = reader.point<Point<double>>('A', 'z');
+    EXPECT_EQ(first.y, 2);
+    EXPECT_EQ(first.name_, 'A');
+    Point<int> second = reader.point<Point<int>>('A', 'z');
+    EXPECT_EQ(second.x, 4);
+    EXPECT_EQ(second.z, 6);
+    Point<int> third = reader.point<Point<int>>('A', 'z');
+    EXPECT_EQ(third.y, 8);
+    EXPECT_EQ(third.name_, 'C');
+    // "x", "-1" for size_t, "300" above 255 and the line with "bad"
+    std::string messages = feedback.str();
+    size_t retries = 0;
+    for (size_t at = messages.find("repeat"); at != std::string::npos; at = messages.find("repeat", at + 1)) {
+        ++retries;
+    }
+    EXPECT_EQ(retries, 4u);
+    EXPECT_THROW(reader.number<int>(0, 1), std::runtime_error);
+}
+
+TEST(PolylineTest, CopiesSharePointsUntilWritten) {
+    Polyline<double> original;
+    original.add_point(1, 2, 3, 'A');
+    original.add_point(4, 5, 6, 'B');
+    Polyline<double> copy = original;
+    EXPECT_TRUE(copy.shares_points(original));
+    EXPECT_EQ(copy.id(), original.id());
+
+    copy.shift(1, 0, 0);
+    EXPECT_FALSE(copy.shares_points(original));
+    EXPECT_EQ(original[0].x, 1);
+    EXPECT_EQ(copy[0].x, 2);
+
+    Polyline<double> appended = original;
+    appended.add_point(7, 8, 9, 'C');
+    EXPECT_EQ(original.points_count(), 2u);
+    EXPECT_EQ(appended.points_count(), 3u);
+}
+
+TEST(HistoryTest, UndoAndRedoEdits) {
+    Scene<double> scene;
+    Polyline<double> line;
+    line.add_point(1, 0, 0, 'A');
+    line.add_point(0, 1, 0, 'B');
+    LineId first = scene.insert(line);
+    DialogueNameSpace::History<double> history;
+
+    history.snapshot(scene, "создание");
+    LineId second = scene.insert(line);
+    history.record_shift(scene, second, 2, 0, 0);
+    scene.at(second).shift(2, 0, 0);
+    history.record_rotate(scene, first, 30, 40, 50);
+    scene.at(first).rotate_from_origin(30, 40, 50);
+
+    EXPECT_EQ(history.undo(scene), "поворот");
+    EXPECT_NEAR(scene.at(first)[0].x, 1, 1e-9);
+    EXPECT_NEAR(scene.at(first)[1].y, 1, 1e-9);
+    EXPECT_NEAR(scene.at(first)[1].z, 0, 1e-9);
+    EXPECT_EQ(history.undo(scene), "сдвиг");
+    EXPECT_EQ(scene.at(second)[0].x, 1);
+    EXPECT_EQ(history.undo(scene), "создание");
+    EXPECT_EQ(scene.size(), 1u);
+    EXPECT_FALSE(history.undo(scene));
+
+    EXPECT_EQ(history.redo(scene), "создание");
+    EXPECT_EQ(history.redo(scene), "сдвиг");
+    ASSERT_EQ(scene.size(), 2u);
+    EXPECT_EQ(scene.at(second)[0].x, 3);
+    history.snapshot(scene, "очистка");
+    EXPECT_EQ(history.redo_count(), 0u);
+
+    DialogueNameSpace::History<int> integer_history(2);
+    Scene<int> integer_scene;
+    Polyline<int> integer_line;
+    integer_line.add_point(1, 1, 1, 'A');
+    LineId id = integer_scene.insert(integer_line);
+    for (int i = 0; i < 3; ++i) {
+        integer_history.record_rotate(integer_scene, id, 45, 0, 0);
+        integer_scene.at(id).rotate_from_origin(45, 0, 0);
+    }
+    EXPECT_EQ(integer_history.undo_count(), 2u);
+    integer_history.undo(integer_scene);
+    integer_history.undo(integer_scene);
+    EXPECT_FALSE(integer_history.undo(integer_scene));
+    integer_line.rotate_from_origin(45, 0, 0);
+    EXPECT_EQ(integer_scene.at(id)[0].y, integer_line[0].y);
+    EXPECT_EQ(integer_scene.at(id)[0].z, integer_line[0].z);
+}
+
+TEST(MailboxTest, ConsumerGetsNewestValue) {
+    UtilsNameSpace::Mailbox<int> mailbox;
+    mailbox.back() = 1;
+    mailbox.publish();
+    mailbox.back() = 2;
+    mailbox.publish();
+    ASSERT_TRUE(mailbox.take());
+    EXPECT_EQ(mailbox.front(), 2);
+
+    std::jthread producer([&mailbox] {
+        for (int i = 3; i <= 1000; ++i) {
+            mailbox.back() = i;
+            mailbox.publish();
+        }
+        mailbox.close();
+    });
+    int last = 2;
+    while (mailbox.take()) {
+        EXPECT_GT(mailbox.front(), last);
+        last = mailbox.front();
+    }
+    EXPECT_EQ(last, 1000);
+    EXPECT_LE(mailbox.taken(), 1000u);
+}
+
+TEST(RenderThreadTest, PrintsNewestScene) {
+    std::string path = testing::TempDir() + "render_thread_frames.txt";
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd, 0);
+    Scene<double> scene;
+    LineId id = scene.insert(Polyline<double>());
+    BufferNameSpace::Buffer<74, 313> settings;
+    uint64_t submitted = 0, rendered = 0;
+    {
+        DialogueNameSpace::RenderThread<double, 74, 313> renderer(fd);
+        for (int i = 0; i < 50; ++i) {
+            scene.at(id).add_point(i, i % 7, i % 5, 'A');
+            renderer.submit(scene, settings);
+        }
+        settings.set_mode(BufferNameSpace::RenderMode::Braille);
+        settings.camera().orbit(20, 10);
+        renderer.submit(scene, settings);
+        renderer.wait_idle();
+        submitted = renderer.submitted();
+        rendered = renderer.rendered();
+    }
+    ::close(fd);
+    EXPECT_EQ(submitted, 51u);
+    EXPECT_GE(rendered, 1u);
+    EXPECT_LE(rendered, submitted);
+
+    settings.clean_buffer();
+    DialogueNameSpace::draw_lines(scene, settings);
+    std::string expected;
+    settings.encode(expected);
+    std::ifstream file(path, std::ios::binary);
+    std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::remove(path.c_str());
+    EXPECT_TRUE(written.ends_with(expected));
+}
+
+TEST(RenderThreadTest, RedrawsThePromptBelowEveryFrame) {
+    std::string path = testing::TempDir() + "render_thread_console.txt";
+    int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    ASSERT_GE(fd, 0);
+    Scene<double> scene;
+    Polyline<double> line;
+    line.add_point(0, 0, 0, 'A');
+    line.add_point(10, 10, 10, 'B');
+    scene.insert(std::move(line));
+    BufferNameSpace::Buffer<74, 313> settings;
+    {
+        DialogueNameSpace::RenderThread<double, 74, 313> renderer(fd);
+        std::ostream console(&renderer.console());
+        console << "menu\nchoose: " << std::flush;
+        renderer.submit(scene, settings);
+        renderer.wait_idle();
+        console << "2\nsecond" << std::flush;
+        console << " question: " << std::flush;
+        renderer.submit(scene, settings);
+        renderer.wait_idle();
+    }
+    ::close(fd);
+
+    DialogueNameSpace::draw_lines(scene, settings);
+    std::string frame;
+    settings.encode(frame);
+    std::ifstream file(path, std::ios::binary);
+    std::string written((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    std::remove(path.c_str());
+    EXPECT_EQ(written, "menu\nchoose: " + frame + "choose: " + "2\nsecond question: " + frame + "second question: ");
+}
+
+TEST(RenderThreadTest, SnapshotsHitTheProjectionCache) {
+    int fd = ::open("/dev/null", O_WRONLY);
+    ASSERT_GE(fd, 0);
+    Scene<double> scene;
+    for (int i = 0; i < 50; ++i) {
+        Polyline<double> line;
+        line.add_point(i, 0, 0, 'A');
+        line.add_point(0, i, 10, 'B');
+        scene.insert(std::move(line));
+    }
+    BufferNameSpace::Buffer<74, 313> settings;
+    {
+        DialogueNameSpace::RenderThread<double, 74, 313> renderer(fd);
+        renderer.submit(scene, settings);
+        renderer.wait_idle();
+        EXPECT_EQ(renderer.cached_projections(), 50u);
+        EXPECT_EQ(renderer.projection_cache_hits(), 0u);
+        renderer.submit(scene, settings);
+        renderer.wait_idle();
+        EXPECT_EQ(renderer.cached_projections(), 50u);
+        EXPECT_EQ(renderer.projection_cache_hits(), 50u);
+        // Only the changed line is projected again
+        scene.at(scene.id_at(7)).shift(1, 0, 0);
+        renderer.submit(scene, settings);
+        renderer.wait_idle();
+        EXPECT_EQ(renderer.cached_projections(), 50u);
+        EXPECT_EQ(renderer.projection_cache_hits(), 99u);
+    }
+    ::close(fd);
+}
+
+TEST(SceneTest, StableIdsAndGroups) {
+    Scene<int> scene;
+    std::vector<LineId> ids;
+    for (int i = 0; i < 5; ++i) {
+        Polyline<int> line;
+        line.add_point(i, 0, 0, 'A');
+        ids.push_back(scene.insert(std::move(line), i % 2 == 0 ? "even" : ""));
+    }
+    EXPECT_TRUE(scene.erase(ids[1]));
+    EXPECT_FALSE(scene.erase(ids[1]));
+    EXPECT_FALSE(scene.contains(ids[1]));
+    EXPECT_EQ(scene.find(ids[1]), nullptr);
+    EXPECT_THROW(scene.at(ids[1]), std::out_of_range);
+    ASSERT_EQ(scene.size(), 4u);
+    for (size_t i : {0u, 2u, 3u, 4u}) {
+        EXPECT_EQ(scene.at(ids[i])[0].x, static_cast<int>(i));
+    }
+    for (size_t i = 0; i < scene.size(); ++i) {
+        EXPECT_EQ(&scene.at(scene.id_at(i)), &scene.lines()[i]);
+    }
+
+    LineId reused = scene.insert(Polyline<int>());
+    EXPECT_EQ(reused.index, ids[1].index);
+    EXPECT_NE(reused, ids[1]);
+    EXPECT_EQ(PolylineNameSpace::to_string(ids[1]), "2");
+    EXPECT_EQ(PolylineNameSpace::to_string(reused), "2.1");
+    EXPECT_EQ(PolylineNameSpace::parse_line_id("2.1"), reused);
+    EXPECT_FALSE(PolylineNameSpace::parse_line_id("0"));
+    EXPECT_FALSE(PolylineNameSpace::parse_line_id("3x"));
+
+    EXPECT_EQ(scene.group("even"), (std::vector<LineId>{ids[0], ids[4], ids[2]}));
+    scene.set_group(ids[4], "");
+    scene.set_group(reused, "even");
+    EXPECT_EQ(scene.group_of(reused), "even");
+    EXPECT_EQ(scene.group("even").size(), 3u);
+    EXPECT_TRUE(scene.group("odd").empty());
+
+    scene.clear();
+    EXPECT_TRUE(scene.empty());
+    EXPECT_FALSE(scene.contains(reused));
+}
+
+TEST(ObjTest, ReadsInChunksAndRoundTrips) {
+    std::istringstream in(
+        "# exported elsewhere\n"
+        "mtllib scene.mtl\n"
+        "v 0 0 0\n"
+        "v 1.5 -2 +3 1.0 # B\n"
+        "vt 0 0\n"
+        "o wire\n"
+        "v 4e1 5 6\n"
+        "l 1/1 2/1 3/1\n"
+        "g\n"
+        "l -1 -3");
+    Scene<double> scene;
+    EXPECT_EQ(PolylineNameSpace::read_obj(in, scene, 0, 7), 2u);
+    ASSERT_EQ(scene.size(), 2u);
+    const Polyline<double>& first = scene.lines()[0];
+    ASSERT_EQ(first.points_count(), 3u);
+    EXPECT_EQ(first[1].x, 1.5);
+    EXPECT_EQ(first[1].z, 3);
+    EXPECT_EQ(first[1].name_, 'B');
+    EXPECT_EQ(first[2].x, 40);
+    EXPECT_EQ(scene.group_of(scene.id_at(0)), "wire");
+    EXPECT_EQ(scene.group_of(scene.id_at(1)), "");
+    EXPECT_EQ(scene.lines()[1][1].x, 0);
+
+    std::ostringstream out;
+    PolylineNameSpace::write_obj(scene, out, 16);
+    std::istringstream again(out.str());
+    Scene<double> copy;
+    PolylineNameSpace::read_obj(again, copy);
+    ASSERT_EQ(copy.size(), scene.size());
+    for (size_t i = 0; i < scene.size(); ++i) {
+        ASSERT_EQ(copy.lines()[i].points_count(), scene.lines()[i].points_count());
+        for (size_t j = 0; j < scene.lines()[i].points_count(); ++j) {
+            EXPECT_EQ(copy.lines()[i][j].x, scene.lines()[i][j].x);
+            EXPECT_EQ(copy.lines()[i][j].name_, scene.lines()[i][j].name_);
+        }
+        EXPECT_EQ(copy.group_of(copy.id_at(i)), scene.group_of(scene.id_at(i)));
+    }
+
+    std::string path = testing::TempDir() + "obj_test.obj";
+    PolylineNameSpace::write_obj(scene, path);
+    for (bool reserve_by_size : {false, true}) {
+        Scene<double> from_file;
+        EXPECT_EQ(PolylineNameSpace::read_obj(path, from_file, reserve_by_size), 2u);
+        ASSERT_EQ(from_file.size(), 2u);
+        EXPECT_EQ(from_file.lines()[0].points_count(), 3u);
+        EXPECT_EQ(from_file.lines()[0][2].x, 40);
+    }
+    std::remove(path.c_str());
+
+    std::istringstream bad("v 0 0 0\nv 1 1 1\nl 1 3\n");
+    try {
+        PolylineNameSpace::read_obj(bad, copy);
+        FAIL() << "expected an error";
+    } catch (const std::runtime_error& e) {
+        EXPECT_STREQ(e.what(), "OBJ line 3: vertex index 3 out of range");
+    }
+}
+
+TEST(SvgTest, ProjectsEveryViewWithoutSnapping) {
+    BufferNameSpace::Buffer<74, 313> buffer;
+    std::vector<Polyline<double>> lines(1);
+    lines[0].add_point(0, 0, 0, 'A');
+    for (int i = 1; i < 1000; ++i) {
+        lines[0].add_point(i * 0.00001, 0, 0, 'm');
+    }
+    lines[0].add_point(10, 10, 10, '<');
+    std::array<BufferNameSpace::Color, 1> colors = {BufferNameSpace::Color::rgb(255, 165, 0)};
+
+    std::string svg = BufferNameSpace::render_svg(buffer, lines, std::span<const BufferNameSpace::Color>(colors));
+    EXPECT_TRUE(svg.starts_with("<svg xmlns=\"http://www.w3.org/2000/svg\" width=\"2504\" height=\"1184\""));
+    EXPECT_TRUE(svg.ends_with("</svg>\n"));
+    EXPECT_NE(svg.find("stroke=\"#ffa500\""), std::string::npos);
+    EXPECT_NE(svg.find(">&lt;</text>"), std::string::npos);
+    // The points within half a pixel of the first are dropped
+    size_t labels = 0;
+    for (size_t at = svg.find(">m</text>"); at != std::string::npos; at = svg.find(">m</text>", at + 1)) {
+        ++labels;
+    }
+    EXPECT_EQ(labels, 0u);
+
+    BufferNameSpace::Projector projector = buffer.view_projector(0);
+    projector.round_rows = false;
+    BufferNameSpace::BufferPoint end = projector(lines[0][1000]);
+    char expected[64];
+    std::snprintf(expected, sizeof(expected), "%g,%g\"/>", std::round(end.y * 8 * 100) / 100, std::round(end.x * 16 * 100) / 100);
+    EXPECT_NE(svg.find(expected), std::string::npos);
+
+    buffer.set_viewports(BufferNameSpace::quad_viewports(74, 313));
+    std::string quad = BufferNameSpace::render_svg(buffer, lines);
+    EXPECT_NE(quad.find("<clipPath id=\"view3\">"), std::string::npos);
+    EXPECT_NE(quad.find("url(#view3)"), std::string::npos);
+}
+
+TEST(ServerTest, SharesSceneBetweenClients) {
+    std::string path = testing::TempDir() + "render_server.sock";
+    std::string obj_path = testing::TempDir() + "render_server.obj";
+    DialogueNameSpace::RenderServer<double, 74, 313> server(path, testing::TempDir());
+    std::thread serving([&server] { server.run(); });
+    struct stat socket_stat{};
+    ASSERT_EQ(::stat(path.c_str(), &socket_stat), 0);
+    EXPECT_EQ(socket_stat.st_mode & 0777, 0600u);
+
+    auto connect_client = [&path] {
+        int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+        sockaddr_un address{};
+        address.sun_family = AF_UNIX;
+        std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+        EXPECT_EQ(::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+        return fd;
+    };
+    // Reads until the output contains text or the connection is closed
+    auto read_until = [](int fd, std::string_view text) {
+        std::string output;
+        char chunk[4096];
+        pollfd ready{fd, POLLIN, 0};
+        while (output.find(text) == std::string::npos && ::poll(&ready, 1, 5000) > 0) {
+            ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+            if (received <= 0) { break; }
+            output.append(chunk, static_cast<size_t>(received));
+        }
+        return output;
+    };
+    auto send_text = [](int fd, std::string_view text) {
+        EXPECT_EQ(::send(fd, text.data(), text.size(), MSG_NOSIGNAL), static_cast<ssize_t>(text.size()));
+    };
+
+    int operator_fd = connect_client(), viewer_fd = connect_client();
+    send_text(viewer_fd, "size 12 50\n");
+    EXPECT_TRUE(read_until(viewer_fd, "\033[13;1H").starts_with(BufferNameSpace::keyframe_prefix));
+    send_text(operator_fd, "size 10 40\ncreate 0 0 0 A 5 5 5 B\nrotate 1 0 0 0\nbogus\n");
+    EXPECT_NE(read_until(viewer_fd, "B").find('B'), std::string::npos);
+
+    send_text(operator_fd, "camera zoom 2\nexport " + obj_path + "\nsvg ../render_server.svg\nexport render_server.obj\nquit\n");
+    std::string output = read_until(operator_fd, "\x01");
+    EXPECT_NE(output.find("\033[11;1H\033[0m\033[2KScript line 4: unknown command 'bogus'"), std::string::npos);
+    EXPECT_NE(output.find("Script line 6: file name '" + obj_path + "' is not a plain name in the files directory"), std::string::npos);
+    EXPECT_NE(output.find("Script line 7: file name '../render_server.svg' is not a plain name"), std::string::npos);
+    Scene<double> exported;
+    EXPECT_EQ(read_obj(obj_path, exported), 1u);
+    std::remove(obj_path.c_str());
+
+    server.stop();
+    serving.join();
+    EXPECT_EQ(server.clients(), 1u);
+    ::close(operator_fd);
+    ::close(viewer_fd);
+}
+
+TEST(ServerTest, RefusesFileCommandsWithoutFilesDirectory) {
+    std::string path = testing::TempDir() + "render_server_nofiles.sock";
+    std::string obj_path = testing::TempDir() + "render_server_nofiles.obj";
+    DialogueNameSpace::RenderServer<double, 74, 313> server(path);
+    std::thread serving([&server] { server.run(); });
+
+    int fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    std::strncpy(address.sun_path, path.c_str(), sizeof(address.sun_path) - 1);
+    ASSERT_EQ(::connect(fd, reinterpret_cast<const sockaddr*>(&address), sizeof(address)), 0);
+    std::string commands = "create 0 0 0 A 1 1 1 B\nexport " + obj_path + "\nimport " + obj_path + "\nquit\n";
+    EXPECT_EQ(::send(fd, commands.data(), commands.size(), MSG_NOSIGNAL), static_cast<ssize_t>(commands.size()));
+    std::string output;
+    char chunk[4096];
+    pollfd ready{fd, POLLIN, 0};
+    while (::poll(&ready, 1, 5000) > 0) {
+        ssize_t received = ::recv(fd, chunk, sizeof(chunk), 0);
+        if (received <= 0) { break; }
+        output.append(chunk, static_cast<size_t>(received));
+    }
+    EXPECT_NE(output.find("Script line 2: export is disabled; the server was started without a files directory"), std::string::npos);
+    EXPECT_NE(output.find("Script line 3: import is disabled"), std::string::npos);
+    EXPECT_NE(::access(obj_path.c_str(), F_OK), 0);
+
+    server.stop();
+    serving.join();
+    ::close(fd);
+}
+
+TEST(SharedSceneTest, ReadersSeeEveryPublishWithoutCopies) {
+    std::string name = "/terminal3d_test_" + std::to_string(::getpid());
+    Scene<double> scene;
+    LineId first = scene.insert(Polyline<double>());
+    scene.at(first).add_point(1, 2, 3, 'A');
+    scene.at(first).add_point(4, 5, 6, 'B');
+    LineId second = scene.insert(Polyline<double>());
+    scene.at(second).add_point(7, 8, 9, 'C');
+
+    SharedSceneWriter<double> writer(name, 1, 2);
+    SharedSceneReader<double> reader(name);
+    writer.publish(scene);
+    EXPECT_EQ(writer.copied_points(), 3u);
+    std::vector<Polyline<double>> seen;
+    std::vector<LineId> seen_ids;
+    auto keep = [&seen, &seen_ids](std::span<const Polyline<double>> lines, std::span<const LineId> ids) {
+        seen.assign(lines.begin(), lines.end());
+        seen_ids.assign(ids.begin(), ids.end());
+    };
+    ASSERT_TRUE(reader.read(keep));
+    EXPECT_EQ(reader.sequence(), writer.sequence());
+    ASSERT_EQ(seen.size(), 2u);
+    EXPECT_EQ(seen_ids[1], second);
+    EXPECT_EQ(seen[0][1].y, 5);
+    EXPECT_EQ(seen[1][0].name_, 'C');
+
+    // Only the changed polyline is copied again
+    scene.at(second).shift(1, 0, 0);
+    writer.publish(scene);
+    EXPECT_EQ(writer.copied_points(), 1u);
+    EXPECT_NE(reader.published(), reader.sequence());
+    ASSERT_TRUE(reader.read(keep));
+    EXPECT_EQ(seen[1][0].x, 8);
+
+    // Writing to a view copies it out of the read-only mapping
+    Polyline<double> edited = seen[0];
+    edited.shift(0, 0, 10);
+    EXPECT_EQ(edited[0].z, 13);
+    EXPECT_EQ(seen[0][0].z, 3);
+
+    // Growing the segment remaps the readers
+    for (int i = 0; i < 100; ++i) {
+        Polyline<double> line;
+        for (int j = 0; j < 50; ++j) { line.add_point(i, j, 0, 'D'); }
+        scene.insert(std::move(line));
+    }
+    writer.publish(scene);
+    ASSERT_TRUE(reader.read(keep));
+    ASSERT_EQ(seen.size(), 102u);
+    EXPECT_EQ(seen[101][49].y, 49);
+    EXPECT_EQ(seen[1][0].x, 8);
+}
+
+TEST(SharedSceneTest, ReadersNoticeTheWriterIsGone) {
+    std::string name = "/terminal3d_test_gone_" + std::to_string(::getpid());
+    auto writer = std::make_unique<SharedSceneWriter<double>>(name);
+    SharedSceneReader<double> reader(name);
+    EXPECT_TRUE(reader.writer_alive());
+    writer.reset();
+    EXPECT_FALSE(reader.writer_alive());
+
+    // A writer killed without its destructor leaves its process ID behind
+    pid_t child = ::fork();
+    ASSERT_GE(child, 0);
+    if (child == 0) {
+        SharedSceneWriter<double> killed(name);
+        ::_exit(0);
+    }
+    int status = 0;
+    ASSERT_EQ(::waitpid(child, &status, 0), child);
+    SharedSceneReader<double> orphaned(name);
+    EXPECT_FALSE(orphaned.writer_alive());
+
+    // A view without a frame limit ends with the writer, one that wants more frames fails
+    DialogueNameSpace::BatchOptions options;
+    options.view_name = name;
+    options.frames = 0;
+    options.fps = 1000;
+    options.output = testing::TempDir() + "view_gone.txt";
+    EXPECT_NO_THROW(DialogueNameSpace::View(options));
+    options.frames = 3;
+    EXPECT_THROW(DialogueNameSpace::View(options), std::runtime_error);
+    ::shm_unlink(name.c_str());
+    std::remove(options.output.c_str());
+}
+
+TEST(BatchTest, RejectsBadNumbersAndSeveralModes) {
+    auto parse = [](std::vector<std::string> args) {
+        args.insert(args.begin(), "Main");
+        std::vector<char*> argv;
+        for (std::string& arg : args) { argv.push_back(arg.data()); }
+        return DialogueNameSpace::parse_batch_options(static_cast<int>(argv.size()), argv.data());
+    };
+    auto message = [&parse](std::vector<std::string> args) {
+        try {
+            parse(std::move(args));
+        }
+        catch (const std::invalid_argument& e) {
+            return std::string(e.what());
+        }
+        return std::string();
+    };
+    DialogueNameSpace::BatchOptions options = parse({"--render", "scene.txt", "--frames", "12", "--orbit", "-7.5"});
+    EXPECT_EQ(options.frames, 12u);
+    EXPECT_EQ(options.orbit, -7.5);
+    EXPECT_EQ(parse({"--play", "a.cast", "--speed", "inf"}).speed, std::numeric_limits<double>::infinity());
+    EXPECT_EQ(parse({"--view", "a", "--view", "b"}).view_name, "b");
+
+    EXPECT_EQ(message({"--render", "scene.txt", "--frames", "-1"}), "--frames expects a whole number, not '-1'");
+    EXPECT_EQ(message({"--render", "scene.txt", "--frames", "10x"}), "--frames expects a whole number, not '10x'");
+    EXPECT_EQ(message({"--render", "scene.txt", "--frames", ""}), "--frames expects a whole number, not ''");
+    EXPECT_EQ(message({"--view", "a", "--fps", "fast"}), "--fps expects a number, not 'fast'");
+    EXPECT_EQ(message({"--render", "scene.txt", "--frames", "99999999999999999999999"}),
+              "--frames expects a whole number, not '99999999999999999999999'");
+    EXPECT_EQ(message({"--script", "commands.txt", "--render", "scene.txt"}),
+              "Only one of --render, --play, --script, --serve and --view can be given, not --script and --render");
+}
+
+TEST(ProfilerTest, CountsHotPathsPerFrame) {
+    using namespace UtilsNameSpace;
+    Profiler::reset();
+    Polyline<double> line;
+    line.add_point(0, 0, 0, 'A');
+    line.add_point(5, 10, 0, 'B');
+    line.add_point(10, 0, 5, 'C');
+    line.shift(1, 0, 0);
+    line.rotate_from_origin(0, 0, 10);
+    auto buffer = std::make_unique<BufferNameSpace::Buffer<30, 80>>();
+    *buffer << line;
+    std::string frame;
+    buffer->encode(frame);
+    Profiler::frame();
+    ProfileSample last = Profiler::last_frame();
+#if PROFILED_TESTS
+    static_assert(profiling_enabled, "ProfiledTests must be built with UTILS_PROFILING=1");
+#endif
+    if (!profiling_enabled) {
+        // Compiled out: nothing is measured
+        EXPECT_EQ(Profiler::session().calls(ProfileStage::Projection), 0u);
+        EXPECT_EQ(last.count(ProfileCounter::CellsWritten), 0u);
+        return;
+    }
+    EXPECT_EQ(last.calls(ProfileStage::Transform), 2u);
+    EXPECT_EQ(last.count(ProfileCounter::PointsTransformed), 6u);
+    EXPECT_GE(last.count(ProfileCounter::PointsProjected), 3u);
+    EXPECT_GT(last.count(ProfileCounter::CellsWritten), 0u);
+    EXPECT_LE(last.count(ProfileCounter::CellsWritten), last.count(ProfileCounter::CellsTested));
+    EXPECT_LE(last.count(ProfileCounter::DistanceTests), last.count(ProfileCounter::CellsTested));
+    EXPECT_EQ(last.calls(ProfileStage::Encode), 1u);
+    for (size_t i = 0; i < profile_stages; ++i) {
+        auto stage = static_cast<ProfileStage>(i);
+        uint64_t bucketed = 0;
+        for (size_t bucket = 0; bucket < profile_buckets; ++bucket) { bucketed += last.bucket(stage, bucket); }
+        EXPECT_EQ(bucketed, last.calls(stage));
+    }
+
+    // The next frame starts empty, and a finished thread keeps its totals in the session
+    std::thread([] {
+        Polyline<int> point;
+        point.add_point(0, 0, 0, 'D');
+        point.shift(1, 1, 1);
+    }).join();
+    Profiler::frame();
+    EXPECT_EQ(Profiler::last_frame().count(ProfileCounter::PointsTransformed), 1u);
+    EXPECT_EQ(Profiler::last_frame().calls(ProfileStage::Encode), 0u);
+    EXPECT_EQ(Profiler::session().count(ProfileCounter::PointsTransformed), 7u);
+}
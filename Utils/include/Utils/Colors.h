@@ -0,0 +1,14 @@
+#ifndef COLORS_H
+#define COLORS_H
+
+namespace UtilsNameSpace {
+    inline constexpr const char* GREEN = "\033[38;2;0;255;0m";
+    inline constexpr const char* RED = "\033[38;2;255;0;0m";
+    inline constexpr const char* BLUE = "\033[38;2;0;191;255m";
+    inline constexpr const char* ORANGE = "\033[38;2;255;165;0m";
+    inline constexpr const char* MAGENTA = "\033[38;2;255;20;147m";
+    inline constexpr const char* YELLOW = "\033[38;2;255;255;0m";
+    inline constexpr const char* RESET = "\033[0;0m";
+}
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * @file FrameStats.h
+ * @brief Latency samples and percentiles for frame timing
+ * @author Chesnokov Alexandr
+ * @date 2025
+ * @version 1.0
+ *
+ * This header defines a LatencyStats class collecting durations of a repeated stage
+ * (projection, rasterization, output, whole frame) and reporting their percentiles.
+ */
+
+#ifndef FRAMESTATS_H
+#define FRAMESTATS_H
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstddef>
+#include <vector>
+
+namespace UtilsNameSpace {
+    /**
+     * @brief Converts a duration to fractional milliseconds
+     * @param duration Duration of any precision
+     * @return double Milliseconds
+     */
+    template <typename Rep, typename Period>
+    double to_milliseconds(std::chrono::duration<Rep, Period> duration){
+        return std::chrono::duration<double, std::milli>(duration).count();
+    }
+
+    /**
+     * @class LatencyStats
+     * @brief Collection of duration samples in milliseconds
+     *
+     * Samples are kept unsorted; percentile() sorts a copy, so it is meant for
+     * reports, not for the measured loop itself.
+     */
+    class LatencyStats{
+    private:
+        std::vector<double> samples_{}; ///< Recorded durations in milliseconds
+
+    public:
+        /**
+         * @brief Records one sample
+         * @param milliseconds Duration in milliseconds
+         */
+        void add(double milliseconds){
+            samples_.push_back(milliseconds);
+        }
+
+        /**
+         * @brief Removes all samples
+         */
+        void clear(){
+            samples_.clear();
+        }
+
+        /**
+         * @brief Get the number of samples
+         * @return size_t Sample count
+         */
+        size_t count() const{
+            return samples_.size();
+        }
+
+        /**
+         * @brief Get a percentile of the samples (nearest rank)
+         * @param percent Percentile in [0, 100]
+         * @return double Duration in milliseconds, 0 when there are no samples
+         */
+        double percentile(double percent) const{
+            if(samples_.empty()){ return 0; }
+            std::vector<double> sorted = samples_;
+            std::sort(sorted.begin(), sorted.end());
+            double rank = std::ceil(std::clamp(percent, 0.0, 100.0) / 100.0 * static_cast<double>(sorted.size()));
+            size_t index = rank < 1 ? 0 : static_cast<size_t>(rank) - 1;
+            return sorted[index];
+        }
+
+        /**
+         * @brief Get the largest sample
+         * @return double Duration in milliseconds, 0 when there are no samples
+         */
+        double max() const{
+            return samples_.empty() ? 0 : *std::max_element(samples_.begin(), samples_.end());
+        }
+    };
+}
+
+#endif
@@ -3,30 +3,29 @@
 
 #include <iostream>
 #include <limits>
+#include <string>
+#include <Utils/InputReader.h>
 
 namespace UtilsNameSpace {
+    // Shared by all prompts, so values typed ahead on one line are not lost
+    inline InputReader& standard_input(){
+        static InputReader reader(std::cin, std::cout);
+        return reader;
+    }
+
     template<typename T>
     T get_num(T min = std::numeric_limits<T>::lowest(), T max = std::numeric_limits<T>::max()){
-        T num = 0;
-        while(!std::cin.eof()){
-            std::cin >> num;
-            if(std::cin.eof()){
-                throw std::runtime_error("End Of File\n");
-            }
-            else if(std::cin.bad()){
-                throw std::runtime_error("BAD! Something is wrong!\n");
-            }
-            else if(std::cin.fail() || num < min || num > max){
-                std::cin.clear();
-                std::cin.ignore(std::numeric_limits<std::streamsize>::max(), '\n');
-                std::cout << "Please repeat it correctly!" << std::endl;
-            }
-            else{
-                return num;
-            }
-        }
-        return num;
+        return standard_input().number<T>(min, max);
+    }
+
+    inline std::string get_word(){
+        return standard_input().word();
+    }
+
+    template<typename P>
+    P get_point(char min_name = 'A', char max_name = 'z'){
+        return standard_input().point<P>(min_name, max_name);
     }
 }
 
-#endif
\ No newline at end of file
+#endif
@@ -0,0 +1,159 @@
+/**
+ * @file InputReader.h
+ * @brief Line-buffered parsing of numbers and points from a stream
+ * @author Chesnokov Alexandr
+ * @date 2025
+ * @version 1.0
+ *
+ * This header defines an InputReader class that reads whole lines from a stream and
+ * parses the values in them with std::from_chars, so long pasted or piped lists of
+ * numbers and points cost one getline per line instead of one extraction per value.
+ */
+
+#ifndef INPUTREADER_H
+#define INPUTREADER_H
+
+#include <algorithm>
+#include <charconv>
+#include <cstddef>
+#include <istream>
+#include <ostream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <type_traits>
+
+namespace UtilsNameSpace {
+    /**
+     * @class InputReader
+     * @brief Reader of whitespace-separated values with validation and retry
+     *
+     * A value that cannot be parsed or is out of range discards the rest of its line,
+     * prints "Please repeat it correctly!" to the feedback stream and is read again
+     * from the next line. The end of the stream throws std::runtime_error.
+     */
+    class InputReader{
+    private:
+        std::istream& in_; ///< Source of the lines
+        std::ostream& feedback_; ///< Receives the retry messages
+        std::string line_{}; ///< Line being parsed
+        size_t position_ = 0; ///< Index of the next unread character in line_
+
+        /**
+         * @brief Moves to the next non-blank character, reading lines as needed
+         * @return bool False at the end of the stream
+         * @throws std::runtime_error if the stream fails
+         */
+        bool next_token(){
+            while(true){
+                position_ = line_.find_first_not_of(" \t\r\n\v\f", position_);
+                if(position_ != std::string::npos){ return true; }
+                if(!std::getline(in_, line_)){
+                    if(in_.bad()){ throw std::runtime_error("BAD! Something is wrong!\n"); }
+                    return false;
+                }
+                position_ = 0;
+            }
+        }
+
+        /**
+         * @brief Parses one value at the current position
+         * @tparam T Type of the value; char takes a single character
+         * @param value Receives the parsed value
+         * @return bool False if there is no value of type T here
+         *
+         * Like stream extraction, parsing stops after the longest valid prefix and
+         * a leading '+' is accepted.
+         */
+        template<typename T>
+        bool parse(T& value){
+            if(!next_token()){ throw std::runtime_error("End Of File\n"); }
+            const char* first = line_.data() + position_;
+            const char* last = line_.data() + line_.size();
+            if constexpr(std::is_same_v<T, char>){
+                value = *first;
+                position_++;
+                return true;
+            }
+            else{
+                if(*first == '+' && last - first > 1 && first[1] != '-'){ first++; }
+                auto [end, error] = std::from_chars(first, last, value);
+                if(error != std::errc{}){ return false; }
+                position_ = static_cast<size_t>(end - line_.data());
+                return true;
+            }
+        }
+
+        /**
+         * @brief Drops the rest of the current line and asks for the value again
+         */
+        void retry(){
+            position_ = line_.size();
+            feedback_ << "Please repeat it correctly!" << std::endl;
+        }
+
+    public:
+        /**
+         * @brief Constructor
+         * @param in Stream to read from
+         * @param feedback Stream receiving the retry messages
+         */
+        InputReader(std::istream& in, std::ostream& feedback) : in_(in), feedback_(feedback){}
+
+        /**
+         * @brief Reads a number in [min, max]
+         * @tparam T Arithmetic type of the number; char reads one character
+         * @param min Smallest accepted value
+         * @param max Largest accepted value
+         * @return T The value
+         * @throws std::runtime_error at the end of the stream or if the stream fails
+         */
+        template<typename T>
+        T number(T min, T max){
+            while(true){
+                T value{};
+                if(parse(value) && value >= min && value <= max){ return value; }
+                retry();
+            }
+        }
+
+        /**
+         * @brief Reads one whitespace-separated word
+         * @return std::string The word
+         * @throws std::runtime_error at the end of the stream or if the stream fails
+         */
+        std::string word(){
+            if(!next_token()){ throw std::runtime_error("End Of File\n"); }
+            size_t end = std::min(line_.find_first_of(" \t\r\n\v\f", position_), line_.size());
+            std::string result = line_.substr(position_, end - position_);
+            position_ = end;
+            return result;
+        }
+
+        /**
+         * @brief Reads a point given as x y z name
+         * @tparam P Point type, constructible as P{x, y, z, name}
+         * @param min_name Smallest accepted name
+         * @param max_name Largest accepted name
+         * @return P The point
+         * @throws std::runtime_error at the end of the stream or if the stream fails
+         *
+         * If any field is invalid the rest of the line is dropped and the whole point
+         * is read again, so one bad line of a pasted list costs only that line.
+         */
+        template<typename P>
+        P point(char min_name, char max_name){
+            using T = decltype(P::x);
+            while(true){
+                T x{}, y{}, z{};
+                char name = '\0';
+                if(parse(x) && parse(y) && parse(z) && parse(name) && name >= min_name && name <= max_name){
+                    return P{x, y, z, name};
+                }
+                retry();
+            }
+        }
+    };
+}
+
+#endif
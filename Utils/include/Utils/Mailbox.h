@@ -0,0 +1,109 @@
+/**
+ * @file Mailbox.h
+ * @brief Lock-free single-producer/single-consumer handoff of the latest value
+ * @author Chesnokov Alexandr
+ * @date 2025
+ * @version 1.0
+ *
+ * This header defines a Mailbox class: a triple buffer through which one thread
+ * publishes values and another takes only the newest of them. Values published
+ * while the consumer is busy replace each other instead of queueing up.
+ */
+
+#ifndef MAILBOX_H
+#define MAILBOX_H
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace UtilsNameSpace {
+    /**
+     * @class Mailbox
+     * @brief Triple buffer with blocking take for one producer and one consumer
+     * @tparam T Type of the values, reused between publications
+     *
+     * The producer fills back() and calls publish(); the consumer calls take() and reads
+     * front(). Each side owns one slot and the third is swapped through an atomic, so
+     * neither side ever waits for the other while it holds a slot. Slots are reused,
+     * so the producer should overwrite every field of back() it cares about.
+     */
+    template<typename T>
+    class Mailbox{
+    private:
+        static constexpr uint8_t fresh_ = 4; ///< Set in middle_ when the middle slot holds an untaken value
+
+        std::array<T, 3> slots_{}; ///< Back, middle and front slots in some order
+        std::atomic<uint8_t> middle_{1}; ///< Index of the middle slot, with fresh_ if it is untaken
+        std::atomic<uint64_t> published_{0}; ///< Bumped by publish() and close(), waited on by the consumer
+        std::atomic<bool> closed_{false}; ///< Set by close() to stop the consumer
+        uint8_t back_ = 0; ///< Slot owned by the producer
+        uint8_t front_ = 2; ///< Slot owned by the consumer
+        uint64_t taken_ = 0; ///< Number of values taken by the consumer
+
+        /**
+         * @brief Swaps the front slot with the middle one if it holds a new value
+         * @return bool True if front() now holds a value not taken before
+         */
+        bool try_take(){
+            if(!(middle_.load(std::memory_order_relaxed) & fresh_)){ return false; }
+            front_ = middle_.exchange(front_, std::memory_order_acq_rel) & ~fresh_;
+            taken_++;
+            return true;
+        }
+
+    public:
+        /**
+         * @brief Slot the producer writes the next value into
+         * @return T& Reference valid until publish()
+         */
+        T& back(){ return slots_[back_]; }
+
+        /**
+         * @brief Makes the value in back() the newest one
+         *
+         * A value published earlier and not taken yet is dropped.
+         */
+        void publish(){
+            back_ = middle_.exchange(back_ | fresh_, std::memory_order_acq_rel) & ~fresh_;
+            published_.fetch_add(1, std::memory_order_release);
+            published_.notify_one();
+        }
+
+        /**
+         * @brief Wakes up the consumer and makes take() return false once nothing is left
+         */
+        void close(){
+            closed_.store(true, std::memory_order_release);
+            published_.fetch_add(1, std::memory_order_release);
+            published_.notify_one();
+        }
+
+        /**
+         * @brief Waits for a value not taken before and moves it to front()
+         * @return bool False if the mailbox was closed and holds no new value
+         */
+        bool take(){
+            while(true){
+                uint64_t seen = published_.load(std::memory_order_acquire);
+                if(try_take()){ return true; }
+                if(closed_.load(std::memory_order_acquire)){ return false; }
+                published_.wait(seen, std::memory_order_acquire);
+            }
+        }
+
+        /**
+         * @brief Slot holding the value returned by the last take()
+         * @return T& Reference valid until the next take()
+         */
+        T& front(){ return slots_[front_]; }
+
+        /**
+         * @brief Number of values taken so far (consumer side)
+         * @return uint64_t Count of successful take() calls
+         */
+        uint64_t taken() const{ return taken_; }
+    };
+}
+
+#endif
@@ -0,0 +1,297 @@
+/**
+ * @file Profiler.h
+ * @brief Scoped timers and counters for the rendering hot paths
+ * @author Chesnokov Alexandr
+ * @date 2025
+ * @version 1.0
+ *
+ * This header defines the stages and counters measured inside projection, rasterization,
+ * polyline transforms and frame output, and a Profiler collecting them per thread.
+ * Measurements are compiled in only when UTILS_PROFILING is defined to a non-zero value
+ * (cmake -DPROFILING=ON); otherwise ScopedTimer and Profiler::count do nothing and the
+ * optimizer removes them completely.
+ */
+
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+#ifndef UTILS_PROFILING
+#define UTILS_PROFILING 0
+#endif
+
+namespace UtilsNameSpace {
+    /// True when the measurements are compiled in
+    inline constexpr bool profiling_enabled = UTILS_PROFILING != 0;
+
+    /**
+     * @enum ProfileStage
+     * @brief Timed stages of a frame
+     */
+    enum class ProfileStage : size_t{
+        Projection, ///< Projecting polyline points to the views
+        Rasterization, ///< Drawing the clipped segments into cells or braille dots
+        Transform, ///< Rotating and shifting polylines
+        Encode, ///< Compositing the layers and encoding the frame text
+        Output, ///< Writing the encoded frame
+    };
+
+    /**
+     * @enum ProfileCounter
+     * @brief Counted events of a frame
+     */
+    enum class ProfileCounter : size_t{
+        PointsProjected, ///< Points passed through a view projection
+        CellsTested, ///< Cells (or braille dots) visited by rasterization
+        DistanceTests, ///< Calls of the point to line distance test
+        CellsWritten, ///< Cells (or braille dots) actually drawn
+        PointsTransformed, ///< Points rotated or shifted
+        BytesWritten, ///< Bytes of written frames
+    };
+
+    inline constexpr size_t profile_stages = 5; ///< Number of ProfileStage values
+    inline constexpr size_t profile_counters = 6; ///< Number of ProfileCounter values
+    inline constexpr size_t profile_buckets = 32; ///< Histogram buckets, bucket i holds durations in [2^i, 2^(i+1)) ns
+
+    /**
+     * @class ProfileSample
+     * @brief Totals of every stage and counter at some moment or over some interval
+     *
+     * Samples taken by Profiler are cumulative; subtracting two of them gives the
+     * totals of the interval between them.
+     */
+    class ProfileSample{
+    private:
+        static constexpr size_t stage_size = 2 + profile_buckets;
+
+        std::array<uint64_t, profile_counters + profile_stages * stage_size> values_{}; ///< Counters, then calls, nanoseconds and histogram of every stage
+
+        static constexpr size_t counter_index(ProfileCounter counter){ return static_cast<size_t>(counter); }
+        static constexpr size_t calls_index(ProfileStage stage){ return profile_counters + static_cast<size_t>(stage) * stage_size; }
+
+        friend class Profiler;
+
+    public:
+        /**
+         * @brief Get the number of timed calls of a stage
+         * @param stage Measured stage
+         * @return uint64_t Call count
+         */
+        uint64_t calls(ProfileStage stage) const{ return values_[calls_index(stage)]; }
+
+        /**
+         * @brief Get the total time spent in a stage
+         * @param stage Measured stage
+         * @return std::chrono::nanoseconds Sum of all calls
+         */
+        std::chrono::nanoseconds time(ProfileStage stage) const{
+            return std::chrono::nanoseconds(values_[calls_index(stage) + 1]);
+        }
+
+        /**
+         * @brief Get one histogram bucket of a stage
+         * @param stage Measured stage
+         * @param bucket Bucket index below profile_buckets; the last one also holds longer calls
+         * @return uint64_t Number of calls whose duration fell into the bucket
+         */
+        uint64_t bucket(ProfileStage stage, size_t bucket) const{ return values_[calls_index(stage) + 2 + bucket]; }
+
+        /**
+         * @brief Get the value of a counter
+         * @param counter Counted event
+         * @return uint64_t Number of events
+         */
+        uint64_t count(ProfileCounter counter) const{ return values_[counter_index(counter)]; }
+
+        /**
+         * @brief Get the totals between an earlier sample and this one
+         * @param earlier Sample taken before this one
+         * @return ProfileSample Difference of all values
+         */
+        ProfileSample operator-(const ProfileSample& earlier) const{
+            ProfileSample result;
+            for(size_t i = 0; i < values_.size(); i++){ result.values_[i] = values_[i] - earlier.values_[i]; }
+            return result;
+        }
+    };
+
+    /**
+     * @class Profiler
+     * @brief Process-wide collection of the measurements of all threads
+     *
+     * Every thread writes to its own slot of relaxed atomics with plain load and store
+     * (no locked instructions), so the thread pool does not contend on counters. Slots
+     * are summed when a sample is taken; a finishing thread folds its slot into the
+     * totals. frame() marks a frame boundary, so the last frame can be reported
+     * separately from the session.
+     */
+    class Profiler{
+    private:
+        using Values = std::array<std::atomic<uint64_t>, std::tuple_size_v<decltype(ProfileSample::values_)>>;
+
+        struct Registry{
+            std::mutex mutex{};
+            std::vector<const Values*> slots{};
+            ProfileSample finished{}; ///< Totals of the threads that exited
+            ProfileSample session_start{};
+            ProfileSample frame_start{};
+            ProfileSample last_frame{};
+        };
+
+        static Registry& registry(){
+            static Registry instance;
+            return instance;
+        }
+
+        struct LocalSlot{
+            Values values{};
+
+            LocalSlot(){
+                Registry& shared = registry();
+                std::lock_guard lock(shared.mutex);
+                shared.slots.push_back(&values);
+            }
+
+            ~LocalSlot(){
+                Registry& shared = registry();
+                std::lock_guard lock(shared.mutex);
+                for(size_t i = 0; i < values.size(); i++){ shared.finished.values_[i] += values[i].load(std::memory_order_relaxed); }
+                std::erase(shared.slots, &values);
+            }
+        };
+
+        static Values& local(){
+            thread_local LocalSlot slot;
+            return slot.values;
+        }
+
+        static void add(std::atomic<uint64_t>& value, uint64_t amount){
+            value.store(value.load(std::memory_order_relaxed) + amount, std::memory_order_relaxed);
+        }
+
+        // Cumulative totals since the process started; the registry mutex must be held
+        static ProfileSample total(const Registry& shared){
+            ProfileSample sample = shared.finished;
+            for(const Values* slot : shared.slots){
+                for(size_t i = 0; i < slot->size(); i++){ sample.values_[i] += (*slot)[i].load(std::memory_order_relaxed); }
+            }
+            return sample;
+        }
+
+    public:
+        /**
+         * @brief Adds events to a counter of the calling thread
+         * @param counter Counted event
+         * @param amount Number of events
+         */
+        static void count(ProfileCounter counter, uint64_t amount = 1){
+            if constexpr(profiling_enabled){
+                add(local()[ProfileSample::counter_index(counter)], amount);
+            }
+        }
+
+        /**
+         * @brief Records one timed call of a stage
+         * @param stage Measured stage
+         * @param duration Duration of the call
+         */
+        static void record(ProfileStage stage, std::chrono::nanoseconds duration){
+            if constexpr(profiling_enabled){
+                Values& values = local();
+                uint64_t nanoseconds = static_cast<uint64_t>(std::max<int64_t>(duration.count(), 0));
+                size_t index = ProfileSample::calls_index(stage);
+                size_t bucket = std::min<size_t>(static_cast<size_t>(std::bit_width(nanoseconds)), profile_buckets) - (nanoseconds != 0);
+                add(values[index], 1);
+                add(values[index + 1], nanoseconds);
+                add(values[index + 2 + bucket], 1);
+            }
+        }
+
+        /**
+         * @brief Marks the end of a frame
+         *
+         * Everything measured since the previous call becomes the last frame.
+         */
+        static void frame(){
+            if constexpr(profiling_enabled){
+                Registry& shared = registry();
+                std::lock_guard lock(shared.mutex);
+                ProfileSample now = total(shared);
+                shared.last_frame = now - shared.frame_start;
+                shared.frame_start = now;
+            }
+        }
+
+        /**
+         * @brief Get the totals of the last complete frame
+         * @return ProfileSample Measurements between the last two frame() calls
+         */
+        static ProfileSample last_frame(){
+            Registry& shared = registry();
+            std::lock_guard lock(shared.mutex);
+            return shared.last_frame;
+        }
+
+        /**
+         * @brief Get the totals of the session
+         * @return ProfileSample Measurements since the start or the last reset()
+         */
+        static ProfileSample session(){
+            Registry& shared = registry();
+            std::lock_guard lock(shared.mutex);
+            return total(shared) - shared.session_start;
+        }
+
+        /**
+         * @brief Starts a new session and forgets the last frame
+         */
+        static void reset(){
+            Registry& shared = registry();
+            std::lock_guard lock(shared.mutex);
+            shared.session_start = shared.frame_start = total(shared);
+            shared.last_frame = ProfileSample{};
+        }
+    };
+
+    /**
+     * @class ScopedTimer
+     * @brief Records the lifetime of a scope as one call of a stage
+     *
+     * Does nothing when profiling is disabled.
+     */
+    class ScopedTimer{
+    private:
+        ProfileStage stage_; ///< Measured stage
+        std::chrono::steady_clock::time_point start_{}; ///< Construction time
+
+    public:
+        /**
+         * @brief Constructor, starts the measurement
+         * @param stage Measured stage
+         */
+        explicit ScopedTimer(ProfileStage stage) : stage_(stage){
+            if constexpr(profiling_enabled){ start_ = std::chrono::steady_clock::now(); }
+        }
+
+        /**
+         * @brief Destructor, records the measurement
+         */
+        ~ScopedTimer(){
+            if constexpr(profiling_enabled){ Profiler::record(stage_, std::chrono::steady_clock::now() - start_); }
+        }
+
+        ScopedTimer(const ScopedTimer&) = delete;
+        ScopedTimer& operator=(const ScopedTimer&) = delete;
+    };
+}
+
+#endif
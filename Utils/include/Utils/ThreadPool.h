@@ -0,0 +1,157 @@
+/**
+ * @file ThreadPool.h
+ * @brief Minimal fork-join thread pool for data-parallel loops
+ * @author Chesnokov Alexandr
+ * @date 2025
+ * @version 1.0
+ *
+ * This header defines a ThreadPool class that runs an index-parallel loop on a fixed
+ * set of worker threads. The calling thread takes part in the loop and returns only
+ * after every index has been processed.
+ */
+
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <cstddef>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <exception>
+
+namespace UtilsNameSpace {
+    /**
+     * @class ThreadPool
+     * @brief Fixed-size pool of worker threads executing parallel_for jobs
+     *
+     * Workers sleep between jobs. Each job hands out indices through an atomic
+     * counter, so the work is balanced dynamically between the threads.
+     */
+    class ThreadPool{
+    private:
+        std::vector<std::jthread> workers_{}; ///< Worker threads (the caller is an extra participant)
+        std::mutex mutex_{}; ///< Protects job state shared with the workers
+        std::mutex run_mutex_{}; ///< Serializes concurrent parallel_for calls
+        std::condition_variable start_cv_{}; ///< Signals a new job or shutdown to the workers
+        std::condition_variable done_cv_{}; ///< Signals job completion to the caller
+        std::function<void(size_t)> job_{}; ///< Current job body
+        size_t job_count_ = 0; ///< Number of indices in the current job
+        std::atomic<size_t> next_index_{0}; ///< Next index to hand out
+        size_t generation_ = 0; ///< Job generation counter
+        size_t finished_ = 0; ///< Workers that finished the current generation
+        bool stop_ = false; ///< Shutdown flag
+        std::exception_ptr error_{}; ///< First exception thrown by the current job
+
+        /**
+         * @brief Pulls indices of the current job until none are left
+         */
+        void run_indices(){
+            for(size_t i = next_index_++; i < job_count_; i = next_index_++){
+                try{
+                    job_(i);
+                }
+                catch(...){
+                    std::lock_guard lock(mutex_);
+                    if(!error_){ error_ = std::current_exception(); }
+                }
+            }
+        }
+
+        /**
+         * @brief Main loop of a worker thread
+         */
+        void worker_loop(){
+            size_t seen_generation = 0;
+            while(true){
+                {
+                    std::unique_lock lock(mutex_);
+                    start_cv_.wait(lock, [this, seen_generation]{ return stop_ || generation_ != seen_generation; });
+                    if(stop_){ return; }
+                    seen_generation = generation_;
+                }
+                run_indices();
+                {
+                    std::lock_guard lock(mutex_);
+                    finished_++;
+                }
+                done_cv_.notify_one();
+            }
+        }
+
+    public:
+        /**
+         * @brief Constructor
+         * @param threads Total number of threads taking part in a job, including the caller
+         *
+         * A value of 0 or 1 creates no workers and makes parallel_for run serially.
+         */
+        explicit ThreadPool(size_t threads = std::thread::hardware_concurrency()){
+            for(size_t i = 1; i < threads; i++){
+                workers_.emplace_back([this]{ worker_loop(); });
+            }
+        }
+
+        ThreadPool(const ThreadPool&) = delete;
+        ThreadPool& operator=(const ThreadPool&) = delete;
+
+        /**
+         * @brief Destructor
+         *
+         * Wakes up and joins all workers.
+         */
+        ~ThreadPool(){
+            {
+                std::lock_guard lock(mutex_);
+                stop_ = true;
+            }
+            start_cv_.notify_all();
+            workers_.clear();
+        }
+
+        /**
+         * @brief Get the number of threads taking part in a job
+         * @return size_t Worker count plus the calling thread
+         */
+        size_t size() const{
+            return workers_.size() + 1;
+        }
+
+        /**
+         * @brief Calls func(i) for every i in [0, count) using all threads of the pool
+         * @tparam F Callable type accepting a size_t index
+         * @param count Number of indices
+         * @param func Job body, must be safe to call concurrently for distinct indices
+         * @throws Rethrows the first exception thrown by func
+         *
+         * Blocks until every index has been processed.
+         */
+        template <typename F>
+        void parallel_for(size_t count, F&& func){
+            if(workers_.empty() || count <= 1){
+                for(size_t i = 0; i < count; i++){ func(i); }
+                return;
+            }
+            std::lock_guard run_lock(run_mutex_);
+            {
+                std::lock_guard lock(mutex_);
+                job_ = [&func](size_t i){ func(i); };
+                job_count_ = count;
+                next_index_ = 0;
+                finished_ = 0;
+                error_ = nullptr;
+                generation_++;
+            }
+            start_cv_.notify_all();
+            run_indices();
+            std::unique_lock lock(mutex_);
+            done_cv_.wait(lock, [this]{ return finished_ == workers_.size(); });
+            job_ = nullptr;
+            if(error_){ std::rethrow_exception(error_); }
+        }
+    };
+}
+
+#endif